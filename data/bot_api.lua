@@ -246,10 +246,14 @@ end
 
 ---------------------------------------------------------------------------------------------
 
--- this function is called every game step from the C++ api
+-- this function is called every game step from the C++ api.
+-- it returns the input the bot wants: left, right, jump
 __lastBallSpeed = nil
 function __OnStep()
 	ActiveMode = "game"
+	__WANT_LEFT = false
+	__WANT_RIGHT = false
+	__WANT_JUMP = false
 
 	__PERF_ESTIMATE_COUNTER = 0 -- count the calls to estimate!
 	__bx, __by, __bvx, __bvy = __balldata()
@@ -331,6 +335,7 @@ function __OnStep()
 	end
 	
 	--print(__PERF_ESTIMATE_COUNTER)
+	return __WANT_LEFT, __WANT_RIGHT, __WANT_JUMP
 end
 
 -----------------------------------------------------------------------------------------------
@@ -0,0 +1,119 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "AsyncInputSource.h"
+
+/* includes */
+#include <boost/make_shared.hpp>
+
+#include "DuelMatch.h"
+#include "DuelMatchState.h"
+#include "GameLogic.h"
+#include "Trace.h"
+
+/* implementation */
+
+AsyncInputSource::AsyncInputSource(boost::shared_ptr<InputSource> source, PlayerSide side, std::chrono::microseconds budget) :
+	mSource(source),
+	// the snapshot only holds the state of the real match, so the rules do not matter
+	mSnapshot(new DuelMatch(true, FALLBACK_RULES_NAME, 1)),
+	mBudget(budget),
+	mThinking(false),
+	mRunning(true),
+	mStepCount(0),
+	mMissedDeadlines(0)
+{
+	auto other = boost::make_shared<InputSource>();
+	mSnapshot->setInputSources(side == LEFT_PLAYER ? mSource : other, side == RIGHT_PLAYER ? mSource : other);
+
+	mWorker = std::thread(&AsyncInputSource::workerLoop, this);
+}
+
+AsyncInputSource::~AsyncInputSource()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mRunning = false;
+	}
+	mSnapshotReady.notify_one();
+	mWorker.join();
+}
+
+unsigned int AsyncInputSource::getStepCount() const
+{
+	return mStepCount;
+}
+
+unsigned int AsyncInputSource::getMissedDeadlines() const
+{
+	return mMissedDeadlines;
+}
+
+PlayerInputAbs AsyncInputSource::getNextInput()
+{
+	if (getMatch() == 0)
+	{
+		return PlayerInputAbs();
+	}
+
+	++mStepCount;
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	// the snapshot may only be changed while the worker is idle. Otherwise, it
+	// still thinks about an older state, and gets the new one in a later step.
+	if(!mThinking)
+	{
+		mSnapshot->setState(getMatch()->getState());
+		mThinking = true;
+		mSnapshotReady.notify_one();
+	}
+
+	if(!mDecisionReady.wait_for(lock, mBudget, [this](){ return !mThinking; }))
+	{
+		++mMissedDeadlines;
+	}
+
+	return mDecision;
+}
+
+void AsyncInputSource::workerLoop()
+{
+	TRACE_THREAD_NAME("bot");
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	while(true)
+	{
+		mSnapshotReady.wait(lock, [this](){ return mThinking || !mRunning; });
+		if(!mRunning)
+			break;
+
+		lock.unlock();
+		{
+			TRACE_SCOPE("AsyncInputSource::think");
+			mSource->updateInput();
+		}
+		lock.lock();
+
+		mDecision = mSource->getRealInput();
+		mThinking = false;
+		mDecisionReady.notify_one();
+	}
+}
@@ -0,0 +1,80 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "Global.h"
+#include "InputSource.h"
+
+class DuelMatch;
+
+/*! \class AsyncInputSource
+	\brief runs another input source on its own thread, with a time budget per step.
+	\details The wrapped source (usually a ScriptedInputSource) does not see the real
+			match, but a snapshot that is updated with the state of the real match
+			whenever the worker thread is idle. Each step waits at most \p budget for
+			the worker to decide. If it is too late, the previous decision is used
+			and the step counts as a missed deadline; the late decision is used in
+			the next step, and a new snapshot is handed out once it is done.
+			So a slow bot reacts later, but does not slow down the game.
+*/
+class AsyncInputSource : public InputSource
+{
+	public:
+		/// \p source is attached to the snapshot match, so it must not be attached to a match yet.
+		AsyncInputSource(boost::shared_ptr<InputSource> source, PlayerSide side, std::chrono::microseconds budget);
+		~AsyncInputSource();
+
+		/// number of steps for which an input was requested
+		unsigned int getStepCount() const;
+		/// number of steps for which the wrapped source did not decide in time
+		unsigned int getMissedDeadlines() const;
+
+	private:
+		virtual PlayerInputAbs getNextInput();
+
+		void workerLoop();
+
+		boost::shared_ptr<InputSource> mSource;
+		boost::scoped_ptr<DuelMatch> mSnapshot;
+		const std::chrono::microseconds mBudget;
+
+		std::mutex mMutex;
+		std::condition_variable mSnapshotReady;
+		std::condition_variable mDecisionReady;
+		// true while the worker works on the snapshot
+		bool mThinking;
+		bool mRunning;
+		PlayerInputAbs mDecision;
+
+		std::atomic<unsigned int> mStepCount;
+		std::atomic<unsigned int> mMissedDeadlines;
+
+		std::thread mWorker;
+};
@@ -20,10 +20,29 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "BlobbyDebug.h"
 #include <string>
 #include <map>
+#include <mutex>
+#include <vector>
 #include <iostream>
 #include <fstream>
 #include <boost/lexical_cast.hpp>
 
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+// guards the maps below and the slot list. Counting objects does not need it.
+std::mutex& GetCounterMutex()
+{
+	static std::mutex CounterMutex;
+	return CounterMutex;
+}
+
+std::vector<const ObjectCounterSlot*>& GetSlotList()
+{
+	static std::vector<const ObjectCounterSlot*> SlotList;
+	return SlotList;
+}
+
 std::map<std::string, CountingReport>& GetCounterMap()
 {
 	static std::map<std::string, CountingReport> CounterMap;
@@ -42,30 +61,69 @@ std::map<std::string, int>& GetProfMap()
 	return ProfMap;
 }
 
-int count(const std::type_info& type)
+std::string GetTypeName(const std::type_info& type)
 {
-	std::string test = type.name();
-	if(GetCounterMap().find(type.name()) == GetCounterMap().end() )
+#ifdef __GNUG__
+	int status = 0;
+	char* demangled = abi::__cxa_demangle(type.name(), 0, 0, &status);
+	if(status == 0 && demangled)
 	{
-		GetCounterMap()[type.name()] = CountingReport();
+		std::string name = demangled;
+		free(demangled);
+		return name;
 	}
+#endif
+	return type.name();
+}
+
+ObjectCounterSlot::ObjectCounterSlot(const std::type_info& type) : mType(type), mAlive(0), mCreated(0)
+{
+	std::lock_guard<std::mutex> lock(GetCounterMutex());
+	GetSlotList().push_back(this);
+}
 
-	GetCounterMap()[type.name()].created++;
-	return ++GetCounterMap()[type.name()].alive;
+const std::type_info& ObjectCounterSlot::getType() const
+{
+	return mType;
 }
 
-int uncount(const std::type_info& type)
+int ObjectCounterSlot::getAlive() const
 {
-	return --GetCounterMap()[type.name()].alive;
+	return mAlive.load(std::memory_order_relaxed);
+}
+
+int ObjectCounterSlot::getCreated() const
+{
+	return mCreated.load(std::memory_order_relaxed);
 }
 
 int getObjectCount(const std::type_info& type)
 {
-	return 	GetCounterMap()[type.name()].alive;
+	std::lock_guard<std::mutex> lock(GetCounterMutex());
+	for(const ObjectCounterSlot* slot : GetSlotList())
+	{
+		if(slot->getType() == type)
+			return slot->getAlive();
+	}
+	return 0;
+}
+
+std::map<std::string, CountingReport> getCounterSnapshot()
+{
+	std::lock_guard<std::mutex> lock(GetCounterMutex());
+	std::map<std::string, CountingReport> snapshot = GetCounterMap();
+	for(const ObjectCounterSlot* slot : GetSlotList())
+	{
+		CountingReport& entry = snapshot[GetTypeName(slot->getType())];
+		entry.alive = slot->getAlive();
+		entry.created = slot->getCreated();
+	}
+	return snapshot;
 }
 
 int count(const std::type_info& type, std::string tag, int n)
 {
+	std::lock_guard<std::mutex> lock(GetCounterMutex());
 	std::string name = std::string(type.name()) + " - " + tag;
 	if(GetCounterMap().find(name) == GetCounterMap().end() )
 	{
@@ -77,6 +135,7 @@ int count(const std::type_info& type, std::string tag, int n)
 
 int uncount(const std::type_info& type, std::string tag, int n)
 {
+	std::lock_guard<std::mutex> lock(GetCounterMutex());
 	return GetCounterMap()[std::string(type.name()) + " - " + tag].alive -= n;
 }
 
@@ -84,13 +143,18 @@ int count(const std::type_info& type, std::string tag, void* address, int num)
 {
 	std::cout << "MALLOC " << num << "\n";
 	count(type, tag, num);
+	std::lock_guard<std::mutex> lock(GetCounterMutex());
 	GetAddressMap()[address] = num;
 	return 0;
 }
 
 int uncount(const std::type_info& type, std::string tag, void* address)
 {
-	int num = GetAddressMap()[address];
+	int num;
+	{
+		std::lock_guard<std::mutex> lock(GetCounterMutex());
+		num = GetAddressMap()[address];
+	}
 	std::cout << "FREE " << num << "\n";
 	uncount(type, tag, num);
 	return 0;
@@ -99,6 +163,7 @@ int uncount(const std::type_info& type, std::string tag, void* address)
 void debug_count_execution_fkt(std::string file, int line)
 {
 	std::string rec = file + ":" + boost::lexical_cast<std::string>(line);
+	std::lock_guard<std::mutex> lock(GetCounterMutex());
 	if(GetProfMap().find(rec) == GetProfMap().end() )
 	{
 		GetProfMap()[rec] = 0;
@@ -112,7 +177,8 @@ void report(std::ostream& stream)
 {
 	stream << "MEMORY REPORT\n";
 	int sum = 0;
-	for(std::map<std::string, CountingReport>::iterator i = GetCounterMap().begin(); i != GetCounterMap().end(); ++i)
+	std::map<std::string, CountingReport> counters = getCounterSnapshot();
+	for(std::map<std::string, CountingReport>::iterator i = counters.begin(); i != counters.end(); ++i)
 	{
 		stream << i->first << "\n- - - - - - - - - -\n";
 		stream << " alive:   " << i->second.alive << "\n";
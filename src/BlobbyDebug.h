@@ -25,49 +25,95 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <utility>
 #include <cstddef>
 #include <cstdlib>
+#include <atomic>
+#include <map>
 #include <memory>
 #include <string>
 
-int count(const std::type_info& type);
-int uncount(const std::type_info& type);
 int count(const std::type_info& type, std::string tag, int num);
 int uncount(const std::type_info& type, std::string tag, int num);
 
+/*! \class ObjectCounterSlot
+	\brief number of living and created objects of one type
+	\details There is one slot per counted type. It registers itself once, when the first
+			object of the type is created, so counting an object only costs two atomic
+			increments.
+*/
+class ObjectCounterSlot
+{
+	public:
+		explicit ObjectCounterSlot(const std::type_info& type);
+
+		void add()
+		{
+			mAlive.fetch_add(1, std::memory_order_relaxed);
+			mCreated.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void remove()
+		{
+			mAlive.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		const std::type_info& getType() const;
+		int getAlive() const;
+		int getCreated() const;
+
+	private:
+		const std::type_info& mType;
+		std::atomic<int> mAlive;
+		std::atomic<int> mCreated;
+};
+
 /*! \class ObjectCounter
 	\brief Logging number of creations and living objects
 	\details To use this class for logging creations of a class TYPE, just derive it
 			from ObjectCounter<TYPE>. A full memory report can be written to a stream
-			by the record function.
+			by the record function, getCounterSnapshot returns the current counts.
+			Objects can be created and destroyed from any thread.
+			If BLOBBY_NO_OBJECT_COUNTER is defined, nothing is counted and
+			ObjectCounter is an empty base class.
 	\todo more specific reporting, watches, etc.
 */
+#ifndef BLOBBY_NO_OBJECT_COUNTER
 template<class Base>
 class ObjectCounter
 {
 	public:
 		ObjectCounter()
 		{
-			count(typeid(Base));
+			getSlot().add();
 		};
 
 		~ObjectCounter()
 		{
-			uncount(typeid(Base));
+			getSlot().remove();
 		};
 
 		ObjectCounter(const ObjectCounter& other)
 		{
-			count(typeid(Base));
+			getSlot().add();
 		}
 
 		ObjectCounter& operator=(const ObjectCounter& other)
 		{
 			return *this;
 		}
-};
 
-
-void report(std::ostream& stream);
-int getObjectCount(const std::type_info& type);
+	private:
+		static ObjectCounterSlot& getSlot()
+		{
+			// never destroyed, so objects that outlive the static destructors can still uncount
+			static ObjectCounterSlot* slot = new ObjectCounterSlot(typeid(Base));
+			return *slot;
+		}
+};
+#else
+template<class Base>
+class ObjectCounter
+{
+};
+#endif
 
 struct CountingReport
 {
@@ -80,6 +126,11 @@ struct CountingReport
 	int created;
 };
 
+void report(std::ostream& stream);
+int getObjectCount(const std::type_info& type);
+/// returns the counts of all counted types, by readable type name. Can be called from any thread.
+std::map<std::string, CountingReport> getCounterSnapshot();
+
 // counting allocator
 template<class T, typename tag_type>
 struct CountingAllocator : private std::allocator<T>
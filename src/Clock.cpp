@@ -24,7 +24,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 /* includes */
 #include <sstream>
 
-#include "SDL2/SDL.h"
+#include "TimeSource.h"
 
 /* implementation */
 
@@ -38,12 +38,12 @@ void Clock::reset()
 	// set all variables to their default values
 	mRunning = false;
 	mGameTime = 0;
-	mLastTime = SDL_GetTicks();
+	mLastTime = TimeSource::ticks();
 }
 
 void Clock::start()
 {
-	mLastTime = SDL_GetTicks();
+	mLastTime = TimeSource::ticks();
 	mRunning = true;
 }
 
@@ -106,7 +106,7 @@ void Clock::step()
 {
 	if(mRunning)
 	{
-		int newTime = SDL_GetTicks();
+		int newTime = TimeSource::ticks();
 		if(newTime > mLastTime)
 		{
 			mGameTime += newTime - mLastTime;
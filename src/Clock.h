@@ -26,6 +26,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 	\brief Game Timing Management
 	\details This class represents a clock. It can be started, paused, resetted,
 			and it is possible to get the time in a string for in-game representation
+			The time is taken from the TimeSource of the current thread, so a clock
+			in a simulated match runs with the simulated time.
 */
 class Clock
 {
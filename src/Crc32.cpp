@@ -0,0 +1,116 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "Crc32.h"
+
+/* includes */
+#include <algorithm>
+
+/* implementation */
+
+namespace
+{
+	// reversed polynomial of CRC-32
+	const uint32_t POLYNOMIAL = 0xEDB88320;
+
+	struct CrcTables
+	{
+		CrcTables()
+		{
+			for(uint32_t i = 0; i < 256; ++i)
+			{
+				uint32_t crc = i;
+				for(int bit = 0; bit < 8; ++bit)
+					crc = (crc >> 1) ^ (crc & 1 ? POLYNOMIAL : 0);
+				table[0][i] = crc;
+			}
+
+			// table[k][i] is the crc of byte i followed by k zero bytes
+			for(int k = 1; k < 8; ++k)
+			{
+				for(int i = 0; i < 256; ++i)
+					table[k][i] = (table[k-1][i] >> 8) ^ table[0][table[k-1][i] & 0xFF];
+			}
+		}
+
+		uint32_t table[8][256];
+	};
+
+	const CrcTables& getTables()
+	{
+		static const CrcTables tables;
+		return tables;
+	}
+
+	inline uint32_t readLittleEndian(const unsigned char* data)
+	{
+		return uint32_t(data[0]) | uint32_t(data[1]) << 8 | uint32_t(data[2]) << 16 | uint32_t(data[3]) << 24;
+	}
+}
+
+uint32_t crc32(const void* data, std::size_t length, uint32_t crc)
+{
+	const uint32_t (&table)[8][256] = getTables().table;
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+	crc = ~crc;
+
+	while(length >= 8)
+	{
+		uint32_t first = readLittleEndian(bytes) ^ crc;
+		uint32_t second = readLittleEndian(bytes + 4);
+		crc = table[7][first & 0xFF] ^ table[6][(first >> 8) & 0xFF] ^
+				table[5][(first >> 16) & 0xFF] ^ table[4][first >> 24] ^
+				table[3][second & 0xFF] ^ table[2][(second >> 8) & 0xFF] ^
+				table[1][(second >> 16) & 0xFF] ^ table[0][second >> 24];
+		bytes += 8;
+		length -= 8;
+	}
+
+	while(length > 0)
+	{
+		crc = (crc >> 8) ^ table[0][(crc ^ *bytes) & 0xFF];
+		++bytes;
+		--length;
+	}
+
+	return ~crc;
+}
+
+uint32_t legacyChecksum(const void* data, std::size_t length)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	uint32_t crc = 0;
+	std::size_t position = 0;
+
+	while(true)
+	{
+		std::size_t block = std::min<std::size_t>(128, length - position);
+		for(std::size_t i = 0; i < block; ++i)
+			crc = crc32(bytes + position, block, crc);
+		position += block;
+
+		if(block < 32)
+			break;
+	}
+
+	return crc;
+}
@@ -0,0 +1,41 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <cstddef>
+#include <inttypes.h>
+
+/** \file Crc32.h
+	CRC-32 checksums, as used by zip and png (and by boost::crc_32_type).
+	The calculation uses the slicing-by-8 algorithm, which processes eight bytes
+	per table lookup round instead of one.
+*/
+
+/// calculates the CRC-32 of \p length bytes at \p data. To calculate the checksum of
+/// data that is split into several blocks, pass the checksum of the previous blocks
+/// as \p crc.
+uint32_t crc32(const void* data, std::size_t length, uint32_t crc = 0);
+
+/// calculates the checksum that older versions used for rules files. They processed
+/// the file in blocks of 128 bytes and accidentally fed each block into the CRC
+/// as many times as it was long, and stopped after the first block shorter than 32
+/// bytes. It is still needed for the rules check in the network protocol.
+uint32_t legacyChecksum(const void* data, std::size_t length);
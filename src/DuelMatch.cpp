@@ -33,6 +33,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "GameConstants.h"
 #include "InputSource.h"
 #include "IUserConfigReader.h"
+#include "Trace.h"
 
 /* implementation */
 
@@ -88,6 +89,8 @@ void DuelMatch::setRules(std::string rulesFile, int score_to_win)
 
 void DuelMatch::step()
 {
+	TRACE_SCOPE("DuelMatch::step");
+
 	// in pause mode, step does nothing
 	if(mPaused)
 		return;
@@ -158,6 +161,20 @@ void DuelMatch::step()
 	mEvents.clear();
 }
 
+void DuelMatch::resimulateStep()
+{
+	std::vector<MatchEvent> pendingEvents;
+	std::vector<MatchEvent> lastEvents;
+	pendingEvents.swap(mEvents);
+	lastEvents.swap(mLastEvents);
+
+	step();
+
+	// events generated while re-simulating have already been generated when the frame was simulated the first time
+	mEvents.swap(pendingEvents);
+	mLastEvents.swap(lastEvents);
+}
+
 void DuelMatch::setScore(int left, int right)
 {
 	mLogic->setScore(LEFT_PLAYER, left);
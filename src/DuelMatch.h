@@ -63,6 +63,10 @@ class DuelMatch : public ObjectCounter<DuelMatch>
 
 		// This steps through one frame
 		void step();
+		// Steps through a frame that has already been simulated, after the
+		// state has been rewound. Events that are waiting to be processed
+		// and the events of the last frame are kept.
+		void resimulateStep();
 
 		// this methods allow external input
 		// events triggered by the network
@@ -22,6 +22,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "DuelMatchState.h"
 
 /* includes */
+#include <cstring>
+#include <ostream>
+
 #include "raknet/BitStream.h"
 
 #include "GameConstants.h"
@@ -39,6 +42,67 @@ void DuelMatchState::swapSides()
 	std::swap(playerInput[LEFT_PLAYER], playerInput[RIGHT_PLAYER]);
 }
 
+namespace
+{
+	// the words are mixed in like FNV-1a does with bytes, the final mix spreads
+	// every input bit over the whole hash
+	const std::uint64_t HASH_PRIME = 1099511628211ull;
+
+	inline void mix(std::uint64_t& hash, std::uint32_t word)
+	{
+		hash = (hash ^ word) * HASH_PRIME;
+	}
+
+	inline void mix(std::uint64_t& hash, float value)
+	{
+		std::uint32_t word;
+		std::memcpy(&word, &value, sizeof(word));
+		mix(hash, word);
+	}
+
+	inline void mix(std::uint64_t& hash, const Vector2& value)
+	{
+		mix(hash, value.x);
+		mix(hash, value.y);
+	}
+}
+
+std::uint64_t DuelMatchState::hash() const
+{
+	std::uint64_t hash = 14695981039346656037ull;
+
+	for(int i = 0; i < MAX_PLAYERS; ++i)
+	{
+		mix(hash, worldState.blobPosition[i]);
+		mix(hash, worldState.blobVelocity[i]);
+		// the animation of the blobs is left out, it depends on its speed, which is not
+		// part of the state. So it can differ for a few steps after a state has been set.
+	}
+	mix(hash, worldState.ballPosition);
+	mix(hash, worldState.ballVelocity);
+	mix(hash, worldState.ballRotation);
+	mix(hash, worldState.ballAngularVelocity);
+
+	mix(hash, (std::uint32_t)logicState.leftScore);
+	mix(hash, (std::uint32_t)logicState.rightScore);
+	for(int i = 0; i < MAX_PLAYERS; ++i)
+	{
+		mix(hash, (std::uint32_t)logicState.hitCount[i]);
+		mix(hash, (std::uint32_t)logicState.squish[i]);
+	}
+	mix(hash, (std::uint32_t)logicState.servingPlayer);
+	mix(hash, (std::uint32_t)logicState.winningPlayer);
+	mix(hash, (std::uint32_t)logicState.squishWall);
+	mix(hash, (std::uint32_t)logicState.squishGround);
+	mix(hash, (std::uint32_t)(logicState.isGameRunning | logicState.isBallValid << 1 |
+								playerInput[LEFT_PLAYER].getAll() << 2 | playerInput[RIGHT_PLAYER].getAll() << 5));
+
+	hash ^= hash >> 32;
+	hash *= 0xd6e8feb86659fd93ull;
+	hash ^= hash >> 32;
+	return hash;
+}
+
 USER_SERIALIZER_IMPLEMENTATION_HELPER(DuelMatchState)
 {
 	io.template generic<PhysicState> (value.worldState);
@@ -119,3 +183,9 @@ int DuelMatchState::getScore(PlayerSide player) const
 	return -1;
 }
 
+std::ostream& operator<<(std::ostream& stream, const DuelMatchState& state)
+{
+	stream << state.worldState << "\n" << state.logicState << "\n"
+			<< "INPUT [ " << state.playerInput[LEFT_PLAYER] << " " << state.playerInput[RIGHT_PLAYER] << " ]";
+	return stream;
+}
@@ -20,6 +20,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #pragma once
 
+#include <cstdint>
+#include <iosfwd>
+
 #include "PhysicState.h"
 #include "GameLogicState.h"
 #include "PlayerInput.h"
@@ -46,8 +49,15 @@ struct DuelMatchState
 
 	void swapSides();
 
+	/// 64 bit hash of the state, except the animation of the blobs. Two states have the same
+	/// hash if they are bitwise equal, so client and server (or a replay and its recording)
+	/// can check cheaply whether they agree.
+	std::uint64_t hash() const;
+
 	PhysicState worldState;
 	GameLogicState logicState;
 
 	PlayerInput playerInput[MAX_PLAYERS];
 };
+
+std::ostream& operator<<(std::ostream&, const DuelMatchState&);
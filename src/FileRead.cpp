@@ -26,7 +26,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <physfs.h>
 
-#include <boost/crc.hpp>
 #include <boost/scoped_array.hpp>
 #include <boost/algorithm/string.hpp>
 
@@ -40,6 +39,7 @@ extern "C"
 }
 
 #include "Global.h"
+#include "Crc32.h"
 
 
 /* implementation */
@@ -163,35 +163,23 @@ std::string FileRead::readString()
 }
 
 
-uint32_t FileRead::calcChecksum(uint32_t start)
+uint32_t FileRead::calcChecksum(uint32_t start, ChecksumType type)
 {
 	uint32_t oldpos = tell();
 	seek(start);
 
-	// buffered reading
-	char buffer[128];
-	size_t len = length();
-
-	boost::crc_32_type crc;
-
-	while(true)
-	{
-		int maxread = std::min(sizeof(buffer), len - tell());
-		readRawBytes( buffer, maxread );	// read into buffer
-
-		for(int i = 0; i < maxread; ++i)
-		{
-			crc.process_bytes(buffer, maxread);
-		}
-
-		if(maxread < 32)
-			break;
-	}
+	// read the rest of the file in one go
+	std::string buffer(length() - start, '\0');
+	if(!buffer.empty())
+		readRawBytes( &buffer[0], buffer.size() );
 
 	// return read pointer back to old position
 	seek(oldpos);
 
-	return crc();
+	if(type == LEGACY_CHECKSUM)
+		return legacyChecksum(buffer.data(), buffer.size());
+
+	return crc32(buffer.data(), buffer.size());
 }
 
 
@@ -105,8 +105,15 @@ class FileRead : public File
 		
 		
 		// helper function for checksum
-		/// calculates a crc checksum of the file contents beginning at posInFile till the end of the file.
-		uint32_t calcChecksum(uint32_t start);
+		enum ChecksumType
+		{
+			CRC32_CHECKSUM,		///< plain CRC-32 of the file contents
+			LEGACY_CHECKSUM		///< the checksum older versions used in the network protocol, see legacyChecksum
+		};
+
+		/// calculates a checksum of the file contents beginning at \p start till the end of the file.
+		/// The read position is not changed.
+		uint32_t calcChecksum(uint32_t start, ChecksumType type = LEGACY_CHECKSUM);
 		
 		
 		// -----------------------------------------------------------------------------------------
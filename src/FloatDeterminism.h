@@ -0,0 +1,105 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+/** \file FloatDeterminism.h
+
+	Client, server and replays simulate the same match independently, so the physics
+	has to give bitwise identical results on every machine. This is the case as long
+	as every float operation is a single IEEE 754 single precision operation, which
+	requires
+		- floats are computed in SSE (or any other non-x87) registers, i.e.
+		  FLT_EVAL_METHOD is 0. This is always the case on x86_64 and ARM, 32 bit x86
+		  builds are compiled with -msse2 -mfpmath=sse (see src/CMakeLists.txt).
+		- a * b + c is not contracted into a fused multiply-add: -ffp-contract=off.
+		- no -ffast-math.
+	The floating point control word is never touched for SSE math. Only builds which
+	still compute on the x87 FPU need its precision set to 24 bits, which is what
+	ScopedFloatPrecision does for them. For all other builds it is an empty object.
+*/
+
+#include <cfloat>
+#include <limits>
+
+#if defined(__i386__) || defined(_M_IX86)
+	#if !(defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0) && !(defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+		#define BLOBBY_X87_FLOAT_MATH
+	#endif
+#endif
+
+#if defined(BLOBBY_X87_FLOAT_MATH) && defined(_MSC_VER)
+	#include <float.h>
+#endif
+
+#if defined(__FAST_MATH__)
+	#error "the physics is not deterministic when compiled with -ffast-math"
+#endif
+
+static_assert(std::numeric_limits<float>::is_iec559, "the physics needs IEEE 754 floats");
+
+/// sets the x87 FPU to single precision while it exists, if the build uses the x87 FPU at all
+class ScopedFloatPrecision
+{
+	public:
+#ifdef BLOBBY_X87_FLOAT_MATH
+	#if defined(__GNUC__)
+		ScopedFloatPrecision()
+		{
+			asm volatile ("fstcw %0" : "=m"(mControlWord));
+			unsigned short single = mControlWord & 0xfcff;
+			asm volatile ("fldcw %0" :: "m"(single));
+		}
+
+		~ScopedFloatPrecision()
+		{
+			asm volatile ("fldcw %0" :: "m"(mControlWord));
+		}
+	#elif defined(_MSC_VER)
+		ScopedFloatPrecision() : mControlWord(_control87(0, 0))
+		{
+			_control87(_PC_24, _MCW_PC);
+		}
+
+		~ScopedFloatPrecision()
+		{
+			_control87(mControlWord, _MCW_PC);
+		}
+	#else
+		#error "no way to set the x87 precision for this compiler, compile with SSE math instead"
+	#endif
+#else
+		ScopedFloatPrecision()
+		{
+		}
+#endif
+
+		ScopedFloatPrecision(const ScopedFloatPrecision&) = delete;
+		ScopedFloatPrecision& operator=(const ScopedFloatPrecision&) = delete;
+
+#ifdef BLOBBY_X87_FLOAT_MATH
+	private:
+	#if defined(_MSC_VER)
+		unsigned int mControlWord;
+	#else
+		unsigned short mControlWord;
+	#endif
+#endif
+};
@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 /* includes */
 #include <cassert>
+#include <chrono>
 #include <cmath>
 #include <iostream>
 
@@ -38,7 +39,10 @@ extern "C"
 #include "DuelMatch.h"
 #include "GameConstants.h"
 #include "IScriptableComponent.h"
+#include "LuaStatePool.h"
 #include "PlayerInput.h"
+#include "ScriptTime.h"
+#include "Trace.h"
 
 
 int lua_toint(lua_State* state, int index)
@@ -442,6 +446,30 @@ class LuaGameLogic : public FallbackGameLogic, public IScriptableComponent
 		static LuaGameLogic* getGameLogic(lua_State* state);
 
 	private:
+		/// the functions a rules script may define. They are resolved once when the
+		/// script is loaded; if one is missing, the FallbackGameLogic behaviour is used.
+		enum Hook
+		{
+			IS_WINNING,
+			HANDLE_INPUT,
+			ON_BALL_HITS_PLAYER,
+			ON_BALL_HITS_WALL,
+			ON_BALL_HITS_NET,
+			ON_BALL_HITS_GROUND,
+			ON_GAME,
+			HOOK_COUNT
+		};
+
+		/// pushes \p hook onto the stack.
+		/// \return false, if the script does not define it.
+		bool pushHook(Hook hook) const;
+
+		/// calls the function on top of the stack, prints errors and adds the
+		/// time spent in the script to ScriptTime
+		void callLuaFunction(int arguments, int results) const;
+
+		/// lua states with the api scripts and the C functions of the rules
+		static LuaStatePool& getStatePool();
 
 		// lua functions
 		static int luaMistake(lua_State* state);
@@ -455,11 +483,14 @@ class LuaGameLogic : public FallbackGameLogic, public IScriptableComponent
 
 		std::string mAuthor;
 		std::string mTitle;
+
+		// registry references of the hooks, LUA_NOREF for missing ones
+		int mHooks[HOOK_COUNT];
 };
 
 
 LuaGameLogic::LuaGameLogic( const std::string& filename, DuelMatch* match, int score_to_win ) :
-	FallbackGameLogic( score_to_win ), mSourceFile(filename)
+	FallbackGameLogic( score_to_win ), IScriptableComponent( getStatePool() ), mSourceFile(filename)
 {
 	setMatch( match );
 	lua_pushlightuserdata(mState, this);
@@ -469,20 +500,7 @@ LuaGameLogic::LuaGameLogic( const std::string& filename, DuelMatch* match, int s
 	lua_pushnumber(mState, getScoreToWin());
 	lua_setglobal(mState, "SCORE_TO_WIN");
 
-	setGameConstants();
-	setGameFunctions();
-
-	// add functions
-	luaL_requiref(mState, "math", luaopen_math, 1);
-	lua_register(mState, "score", luaScore);
-	lua_register(mState, "mistake", luaMistake);
-	lua_register(mState, "servingplayer", luaGetServingPlayer);
-	lua_register(mState, "time", luaGetGameTime);
-	lua_register(mState, "isgamerunning", luaIsGameRunning);
-
-	// now load script file
-	openScript("api");
-	openScript("rules_api");
+	// now load script file. the api scripts have already been run by the pool.
 	openScript("rules/"+mSourceFile);
 
 	lua_getglobal(mState, "SCORE_TO_WIN");
@@ -499,6 +517,14 @@ LuaGameLogic::LuaGameLogic( const std::string& filename, DuelMatch* match, int s
 	mTitle = ( title ? title : "untitled script" );
 	lua_pop(mState, 1);
 
+	mHooks[IS_WINNING] = getLuaFunctionRef("IsWinning");
+	mHooks[HANDLE_INPUT] = getLuaFunctionRef("HandleInput");
+	mHooks[ON_BALL_HITS_PLAYER] = getLuaFunctionRef("OnBallHitsPlayer");
+	mHooks[ON_BALL_HITS_WALL] = getLuaFunctionRef("OnBallHitsWall");
+	mHooks[ON_BALL_HITS_NET] = getLuaFunctionRef("OnBallHitsNet");
+	mHooks[ON_BALL_HITS_GROUND] = getLuaFunctionRef("OnBallHitsGround");
+	mHooks[ON_GAME] = getLuaFunctionRef("OnGame");
+
 	std::cout << "loaded rules "<< getTitle()<< " by " << getAuthor() << " from " << mSourceFile << std::endl;
 }
 
@@ -506,21 +532,38 @@ LuaGameLogic::~LuaGameLogic()
 {
 }
 
+LuaStatePool& LuaGameLogic::getStatePool()
+{
+	static LuaStatePool pool([](lua_State* state)
+		{
+			initState(state);
+
+			// add functions
+			lua_register(state, "score", luaScore);
+			lua_register(state, "mistake", luaMistake);
+			lua_register(state, "servingplayer", luaGetServingPlayer);
+			lua_register(state, "time", luaGetGameTime);
+			lua_register(state, "isgamerunning", luaIsGameRunning);
+
+			runScript(state, "api");
+			runScript(state, "rules_api");
+		});
+	return pool;
+}
+
 PlayerSide LuaGameLogic::checkWin() const
 {
+	TRACE_SCOPE("LuaGameLogic::checkWin");
+
 	bool won = false;
-	if (!getLuaFunction("IsWinning"))
+	if (!pushHook(IS_WINNING))
 	{
 		return FallbackGameLogic::checkWin();
 	}
 
 	lua_pushnumber(mState, getScore(LEFT_PLAYER) );
 	lua_pushnumber(mState, getScore(RIGHT_PLAYER) );
-	if( lua_pcall(mState, 2, 1, 0) )
-	{
-		std::cerr << "Lua Error: " << lua_tostring(mState, -1);
-		std::cerr << std::endl;
-	};
+	callLuaFunction(2, 1);
 
 	won = lua_toboolean(mState, -1);
 	lua_pop(mState, 1);
@@ -539,7 +582,9 @@ PlayerSide LuaGameLogic::checkWin() const
 
 PlayerInput LuaGameLogic::handleInput(PlayerInput ip, PlayerSide player)
 {
-	if (!getLuaFunction( "HandleInput" ))
+	TRACE_SCOPE("LuaGameLogic::handleInput");
+
+	if (!pushHook(HANDLE_INPUT))
 	{
 		return FallbackGameLogic::handleInput(ip, player);
 	}
@@ -547,11 +592,7 @@ PlayerInput LuaGameLogic::handleInput(PlayerInput ip, PlayerSide player)
 	lua_pushboolean(mState, ip.left);
 	lua_pushboolean(mState, ip.right);
 	lua_pushboolean(mState, ip.up);
-	if(lua_pcall(mState, 4, 3, 0))
-	{
-		std::cerr << "Lua Error: " << lua_tostring(mState, -1);
-		std::cerr << std::endl;
-	};
+	callLuaFunction(4, 3);
 
 	PlayerInput ret;
 	ret.up = lua_toboolean(mState, -1);
@@ -566,38 +607,36 @@ PlayerInput LuaGameLogic::handleInput(PlayerInput ip, PlayerSide player)
 
 void LuaGameLogic::OnBallHitsPlayerHandler(PlayerSide side)
 {
-	if (!getLuaFunction("OnBallHitsPlayer"))
+	TRACE_SCOPE("LuaGameLogic::OnBallHitsPlayer");
+
+	if (!pushHook(ON_BALL_HITS_PLAYER))
 	{
 		FallbackGameLogic::OnBallHitsPlayerHandler(side);
 		return;
 	}
 	lua_pushnumber(mState, side);
-	if( lua_pcall(mState, 1, 0, 0) )
-	{
-		std::cerr << "Lua Error: " << lua_tostring(mState, -1);
-		std::cerr << std::endl;
-	};
+	callLuaFunction(1, 0);
 }
 
 void LuaGameLogic::OnBallHitsWallHandler(PlayerSide side)
 {
-	if (!getLuaFunction("OnBallHitsWall"))
+	TRACE_SCOPE("LuaGameLogic::OnBallHitsWall");
+
+	if (!pushHook(ON_BALL_HITS_WALL))
 	{
 		FallbackGameLogic::OnBallHitsWallHandler(side);
 		return;
 	}
 
 	lua_pushnumber(mState, side);
-	if( lua_pcall(mState, 1, 0, 0) )
-	{
-		std::cerr << "Lua Error: " << lua_tostring(mState, -1);
-		std::cerr << std::endl;
-	};
+	callLuaFunction(1, 0);
 }
 
 void LuaGameLogic::OnBallHitsNetHandler(PlayerSide side)
 {
-	if (!getLuaFunction( "OnBallHitsNet" ))
+	TRACE_SCOPE("LuaGameLogic::OnBallHitsNet");
+
+	if (!pushHook(ON_BALL_HITS_NET))
 	{
 		FallbackGameLogic::OnBallHitsNetHandler(side);
 		return;
@@ -605,16 +644,14 @@ void LuaGameLogic::OnBallHitsNetHandler(PlayerSide side)
 
 	lua_pushnumber(mState, side);
 
-	if( lua_pcall(mState, 1, 0, 0) )
-	{
-		std::cerr << "Lua Error: " << lua_tostring(mState, -1);
-		std::cerr << std::endl;
-	};
+	callLuaFunction(1, 0);
 }
 
 void LuaGameLogic::OnBallHitsGroundHandler(PlayerSide side)
 {
-	if (!getLuaFunction( "OnBallHitsGround" ))
+	TRACE_SCOPE("LuaGameLogic::OnBallHitsGround");
+
+	if (!pushHook(ON_BALL_HITS_GROUND))
 	{
 		FallbackGameLogic::OnBallHitsGroundHandler(side);
 		return;
@@ -622,25 +659,39 @@ void LuaGameLogic::OnBallHitsGroundHandler(PlayerSide side)
 
 	lua_pushnumber(mState, side);
 
-	if( lua_pcall(mState, 1, 0, 0) )
-	{
-		std::cerr << "Lua Error: " << lua_tostring(mState, -1);
-		std::cerr << std::endl;
-	};
+	callLuaFunction(1, 0);
 }
 
 void LuaGameLogic::OnGameHandler( const DuelMatchState& state )
 {
-	if (!getLuaFunction( "OnGame" ))
+	TRACE_SCOPE("LuaGameLogic::OnGame");
+
+	if (!pushHook(ON_GAME))
 	{
 		FallbackGameLogic::OnGameHandler( state );
 		return;
 	}
-	if( lua_pcall(mState, 0, 0, 0) )
+	callLuaFunction(0, 0);
+}
+
+bool LuaGameLogic::pushHook(Hook hook) const
+{
+	if (mHooks[hook] == LUA_NOREF)
+		return false;
+
+	pushLuaFunction(mHooks[hook]);
+	return true;
+}
+
+void LuaGameLogic::callLuaFunction(int arguments, int results) const
+{
+	auto start = std::chrono::steady_clock::now();
+	if( lua_pcall(mState, arguments, results, 0) )
 	{
 		std::cerr << "Lua Error: " << lua_tostring(mState, -1);
 		std::cerr << std::endl;
-	};
+	}
+	ScriptTime::add(std::chrono::steady_clock::now() - start);
 }
 
 LuaGameLogic* LuaGameLogic::getGameLogic(lua_State* state)
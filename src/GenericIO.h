@@ -28,6 +28,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "GenericIOFwd.h"
 #include "GenericIODetail.h"
+#include "GenericIOBitStream.h"
 #include "Global.h"
 
 // forward declarations
@@ -146,7 +147,7 @@ class GenericIO : public boost::noncopyable
 	USER_SERIALIZER_IMPLEMENTATION_HELPER( \p type )
 	{
 		generic serialisation algorithm for both input and output. Variable \p io
-		contains the GenericIO object, variable value the \p type object.
+		contains the GenericIO object (or BitStreamOut/BitStreamIn), variable value the \p type object.
 	}
 	\endcode
 	remember to use generic\< \p type\> like this:
@@ -161,8 +162,8 @@ class GenericIO : public boost::noncopyable
 	}
 */
 #define USER_SERIALIZER_IMPLEMENTATION_HELPER( UD_TYPE )											\
-template<class TAG>																					\
-void doSerialize##UD_TYPE(GenericIO<TAG>&, typename detail::conster<TAG, UD_TYPE>::type value);	\
+template<class IO>																					\
+void doSerialize##UD_TYPE(IO&, typename detail::conster<typename IO::tag_type, UD_TYPE>::type value);	\
 template<>																							\
 void UserSerializer<UD_TYPE>::serialize( GenericOut& out, const UD_TYPE& value)						\
 {																									\
@@ -173,8 +174,18 @@ void UserSerializer<UD_TYPE>::serialize( GenericIn& in, UD_TYPE& value)								\
 {																									\
 	doSerialize##UD_TYPE(in, value);																\
 }																									\
-template<class TAG>																					\
-void doSerialize##UD_TYPE(GenericIO<TAG>& io, typename detail::conster<TAG, UD_TYPE>::type value)
+template<>																							\
+void UserSerializer<UD_TYPE>::serialize( BitStreamOut& out, const UD_TYPE& value)					\
+{																									\
+	doSerialize##UD_TYPE(out, value);																\
+}																									\
+template<>																							\
+void UserSerializer<UD_TYPE>::serialize( BitStreamIn& in, UD_TYPE& value)							\
+{																									\
+	doSerialize##UD_TYPE(in, value);																\
+}																									\
+template<class IO>																					\
+void doSerialize##UD_TYPE(IO& io, typename detail::conster<typename IO::tag_type, UD_TYPE>::type value)
 
 
 // -------------------------------------------------------------------------------------------------
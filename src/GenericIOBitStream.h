@@ -0,0 +1,267 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+/** \file GenericIOBitStream.h
+
+	Statically dispatched counterparts of the generic BitStream reader and writer.
+	BitStreamOut and BitStreamIn have the same interface as GenericOut and GenericIn,
+	so every type with a UserSerializer can be written with them, but they are
+	plain classes: they live on the stack, need no virtual calls and write
+	exactly the same data as createGenericWriter(RakNet::BitStream*).
+	To read from a raw buffer, wrap it in a BitStream that does not copy the data.
+	Containers are not supported, use the dynamic GenericIO for them.
+*/
+
+#include <string>
+
+#include "GenericIOFwd.h"
+#include "GenericIODetail.h"
+#include "Global.h"
+#include "PlayerInput.h"
+#include "raknet/BitStream.h"
+#include "raknet/NetworkTypes.h"
+
+namespace detail
+{
+	template<class IO, class T>
+	void static_serialize(IO& io, T& value);
+}
+
+/// writes to a BitStream without virtual dispatch
+class BitStreamOut
+{
+	public:
+		typedef detail::WRITER_TAG tag_type;
+
+		explicit BitStreamOut(RakNet::BitStream& stream) : mStream(stream)
+		{
+		}
+
+		void byte(const unsigned char& data)
+		{
+			mStream.Write(data);
+		}
+
+		void boolean(const bool& data)
+		{
+			mStream.Write(data);
+		}
+
+		void uint32(const unsigned int& data)
+		{
+			mStream.Write(data);
+		}
+
+		void number(const float& data)
+		{
+			mStream.Write(data);
+		}
+
+		void string(const std::string& string)
+		{
+			uint32(string.size());
+			mStream.Write(string.c_str(), string.size());
+		}
+
+		void array(const char* data, unsigned int length)
+		{
+			mStream.Write(data, length);
+		}
+
+		unsigned int tell() const
+		{
+			return mStream.GetNumberOfBitsUsed();
+		}
+
+		void seek(unsigned int pos) const
+		{
+			mStream.SetWriteOffset(pos);
+		}
+
+		template<class T>
+		void generic(const T& data)
+		{
+			detail::static_serialize(*this, data);
+		}
+
+	private:
+		RakNet::BitStream& mStream;
+};
+
+/// reads from a BitStream without virtual dispatch
+class BitStreamIn
+{
+	public:
+		typedef detail::READER_TAG tag_type;
+
+		explicit BitStreamIn(RakNet::BitStream& stream) : mStream(stream)
+		{
+		}
+
+		void byte(unsigned char& data)
+		{
+			mStream.Read(data);
+		}
+
+		void boolean(bool& data)
+		{
+			mStream.Read(data);
+		}
+
+		void uint32(unsigned int& data)
+		{
+			mStream.Read(data);
+		}
+
+		void number(float& data)
+		{
+			mStream.Read(data);
+		}
+
+		void string(std::string& string)
+		{
+			unsigned int size;
+			uint32(size);
+			string.resize(size);
+			for(unsigned int i = 0; i < size; ++i)
+			{
+				unsigned char c;
+				byte(c);
+				string[i] = c;
+			}
+		}
+
+		void array(char* data, unsigned int length)
+		{
+			mStream.Read(data, length);
+		}
+
+		unsigned int tell() const
+		{
+			return mStream.GetReadOffset();
+		}
+
+		void seek(unsigned int pos) const
+		{
+			mStream.ResetReadPointer();
+			mStream.IgnoreBits(pos);
+		}
+
+		template<class T>
+		void generic(T& data)
+		{
+			detail::static_serialize(*this, data);
+		}
+
+	private:
+		RakNet::BitStream& mStream;
+};
+
+// -------------------------------------------------------------------------------------------------
+//         						Implementation detail
+// -------------------------------------------------------------------------------------------------
+
+namespace detail
+{
+	// the predefined types are written exactly like predifined_serializer in GenericIO.cpp does
+	inline void static_serialize_imp(BitStreamOut& io, const unsigned char& value) { io.byte(value); }
+	inline void static_serialize_imp(BitStreamIn& io, unsigned char& value) { io.byte(value); }
+	inline void static_serialize_imp(BitStreamOut& io, const bool& value) { io.boolean(value); }
+	inline void static_serialize_imp(BitStreamIn& io, bool& value) { io.boolean(value); }
+	inline void static_serialize_imp(BitStreamOut& io, const unsigned int& value) { io.uint32(value); }
+	inline void static_serialize_imp(BitStreamIn& io, unsigned int& value) { io.uint32(value); }
+	inline void static_serialize_imp(BitStreamOut& io, const float& value) { io.number(value); }
+	inline void static_serialize_imp(BitStreamIn& io, float& value) { io.number(value); }
+	inline void static_serialize_imp(BitStreamOut& io, const std::string& value) { io.string(value); }
+	inline void static_serialize_imp(BitStreamIn& io, std::string& value) { io.string(value); }
+
+	inline void static_serialize_imp(BitStreamOut& io, const Color& value)
+	{
+		io.uint32(value.toInt());
+	}
+
+	inline void static_serialize_imp(BitStreamIn& io, Color& value)
+	{
+		unsigned int target;
+		io.uint32(target);
+		value = Color(target);
+	}
+
+	inline void static_serialize_imp(BitStreamOut& io, const PlayerInput& value)
+	{
+		io.uint32(value.getAll());
+	}
+
+	inline void static_serialize_imp(BitStreamIn& io, PlayerInput& value)
+	{
+		unsigned int target;
+		io.uint32(target);
+		value.setAll(target);
+	}
+
+	inline void static_serialize_imp(BitStreamOut& io, const PlayerSide& value)
+	{
+		io.uint32(value);
+	}
+
+	inline void static_serialize_imp(BitStreamIn& io, PlayerSide& value)
+	{
+		unsigned int target;
+		io.uint32(target);
+		value = (PlayerSide)target;
+	}
+
+	inline void static_serialize_imp(BitStreamOut& io, const PlayerID& value)
+	{
+		io.uint32(value.binaryAddress);
+		io.uint32(value.port);
+	}
+
+	inline void static_serialize_imp(BitStreamIn& io, PlayerID& value)
+	{
+		io.uint32(value.binaryAddress);
+		unsigned int port;
+		io.uint32(port);
+		value.port = port;
+	}
+
+	// all other types need a UserSerializer
+	template<class T>
+	void static_serialize_imp(BitStreamOut& io, const T& value)
+	{
+		static_assert(!is_container_type<T>::value, "containers can only be serialized with GenericOut");
+		UserSerializer<T>::serialize(io, value);
+	}
+
+	template<class T>
+	void static_serialize_imp(BitStreamIn& io, T& value)
+	{
+		static_assert(!is_container_type<T>::value, "containers can only be serialized with GenericIn");
+		UserSerializer<T>::serialize(io, value);
+	}
+
+	template<class IO, class T>
+	void static_serialize(IO& io, T& value)
+	{
+		static_serialize_imp(io, value);
+	}
+}
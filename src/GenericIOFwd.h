@@ -49,11 +49,19 @@ typedef GenericIO<detail::READER_TAG> GenericIn;
 typedef GenericIO<detail::WRITER_TAG> GenericOut;
 
 
+/// statically dispatched BitStream writer and reader, see GenericIOBitStream.h
+class BitStreamOut;
+class BitStreamIn;
+
+
 /// to make GenericIO support a user defined type, you have to implement
-///	the two functions in this template for that type.
+///	the functions in this template for that type. USER_SERIALIZER_IMPLEMENTATION_HELPER
+///	does that for you.
 template<class T>
 struct UserSerializer
 {
 	static void serialize( GenericOut& out, const T& value);
 	static void serialize( GenericIn& in, T& value);
+	static void serialize( BitStreamOut& out, const T& value);
+	static void serialize( BitStreamIn& in, T& value);
 };
@@ -0,0 +1,87 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "HeadlessMatch.h"
+
+/* includes */
+#include "DuelMatch.h"
+#include "InputSource.h"
+
+/* implementation */
+
+HeadlessMatch::HeadlessMatch(const std::string& rules, int scoreToWin, const InputFactory& createInput, float gameFPS) :
+		mStepDuration(1000.0 / gameFPS), mSteps(0)
+{
+	ScopedTimeSource time(mTime);
+
+	mMatch.reset(new DuelMatch(false, rules, scoreToWin));
+	mMatch->setInputSources(createInput(LEFT_PLAYER), createInput(RIGHT_PLAYER));
+}
+
+HeadlessMatch::~HeadlessMatch()
+{
+	// the input sources may query the time when they are destroyed
+	ScopedTimeSource time(mTime);
+	mMatch.reset();
+}
+
+bool HeadlessMatch::step()
+{
+	if(mMatch->winningPlayer() != NO_PLAYER)
+		return false;
+
+	ScopedTimeSource time(mTime);
+	mMatch->step();
+	mTime.advance(mStepDuration);
+	++mSteps;
+	return true;
+}
+
+HeadlessMatch::Result HeadlessMatch::run(unsigned int maxSteps)
+{
+	ScopedTimeSource time(mTime);
+	for(unsigned int i = 0; i < maxSteps && step(); ++i)
+	{
+	}
+
+	return getResult();
+}
+
+HeadlessMatch::Result HeadlessMatch::getResult() const
+{
+	Result result;
+	result.winner = mMatch->winningPlayer();
+	result.score[LEFT_PLAYER] = mMatch->getScore(LEFT_PLAYER);
+	result.score[RIGHT_PLAYER] = mMatch->getScore(RIGHT_PLAYER);
+	result.steps = mSteps;
+	result.gameTime = mMatch->getClock().getTime();
+	return result;
+}
+
+DuelMatch& HeadlessMatch::getMatch()
+{
+	return *mMatch;
+}
+
+const VirtualTimeSource& HeadlessMatch::getTimeSource() const
+{
+	return mTime;
+}
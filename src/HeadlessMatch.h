@@ -0,0 +1,89 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "Global.h"
+#include "TimeSource.h"
+#include "BlobbyDebug.h"
+
+class DuelMatch;
+class InputSource;
+
+/*! \class HeadlessMatch
+	\brief plays a DuelMatch as fast as possible, without graphics, sound or SDL
+	\details The match runs with its own VirtualTimeSource, which is advanced by
+			exactly one frame of the game speed after each step. So the game clock,
+			the serve delay of the bots and every other timing see the same time as
+			in a match running in real time, and the result is the same, but the
+			match takes only as long as the computations do.
+			The time source is only active on the calling thread while the match is
+			constructed or stepped, so several headless matches can run on different
+			threads at the same time.
+*/
+class HeadlessMatch : public ObjectCounter<HeadlessMatch>
+{
+	public:
+		/// creates the input source for one side. Called while the simulated time is
+		/// active, so bots take their start time from the match time.
+		typedef std::function<boost::shared_ptr<InputSource>(PlayerSide)> InputFactory;
+
+		struct Result
+		{
+			PlayerSide winner;
+			int score[MAX_PLAYERS];
+			/// number of steps that were simulated
+			unsigned int steps;
+			/// game time in seconds, as shown by the match clock
+			int gameTime;
+		};
+
+		/// \param rules rules file, as passed to DuelMatch
+		/// \param scoreToWin score to win, 0 to use the value of config.xml
+		/// \param createInput called once for each side
+		/// \param gameFPS game speed which is simulated
+		HeadlessMatch(const std::string& rules, int scoreToWin, const InputFactory& createInput, float gameFPS = 75);
+		~HeadlessMatch();
+
+		/// simulates a single step. returns false if the match is already over.
+		bool step();
+		/// simulates until a player has won, or \p maxSteps steps have been simulated.
+		/// If the match did not end, the winner of the result is NO_PLAYER.
+		Result run(unsigned int maxSteps = DEFAULT_MAX_STEPS);
+
+		Result getResult() const;
+		DuelMatch& getMatch();
+		const VirtualTimeSource& getTimeSource() const;
+
+		/// one hour of game time at 75 fps
+		static const unsigned int DEFAULT_MAX_STEPS = 75 * 60 * 60;
+
+	private:
+		VirtualTimeSource mTime;
+		double mStepDuration;
+		unsigned int mSteps;
+		boost::scoped_ptr<DuelMatch> mMatch;
+};
@@ -7,44 +7,97 @@
 #include "DuelMatch.h"
 #include "DuelMatchState.h"
 #include "FileRead.h"
+#include "PhysicWorld.h"
+#include "ScriptCache.h"
+#include "LuaStatePool.h"
 
+#include <cstring>
 #include <iostream>
 
 // fwd decl
 int lua_print(lua_State* state);
 
+static void setNumber(lua_State* state, const char* name, double value)
+{
+	lua_pushnumber(state, value);
+	lua_setglobal(state, name);
+}
+
 IScriptableComponent::IScriptableComponent() :
-	mState(luaL_newstate())
+	mState(luaL_newstate()),
+	mPool(nullptr),
+	mGame(nullptr)
 {
-	// register this in the lua registry
-	lua_pushliteral(mState, "__C++_ScriptComponent__");
-	lua_pushlightuserdata(mState, (void*)this);
-	lua_settable(mState, LUA_REGISTRYINDEX);
+	initState(mState);
+	registerComponent();
+}
 
-	lua_register(mState, "print", lua_print);
+IScriptableComponent::IScriptableComponent(LuaStatePool& pool) :
+	mState(pool.acquire()),
+	mPool(&pool),
+	mGame(nullptr)
+{
+	registerComponent();
+}
+
+IScriptableComponent::~IScriptableComponent()
+{
+	// pooled states are reused, so they must not keep our functions alive
+	for(int ref : mFunctionRefs)
+	{
+		luaL_unref(mState, LUA_REGISTRYINDEX, ref);
+	}
+
+	if(mPool)
+	{
+		mPool->release(mState);
+	}
+	 else
+	{
+		lua_close(mState);
+	}
+}
+
+void IScriptableComponent::initState(lua_State* state)
+{
+	lua_register(state, "print", lua_print);
 
 	// open math lib
-	luaL_requiref(mState, "math", luaopen_math, 1);
-	luaL_requiref(mState, "base", luaopen_base, 1);
+	luaL_requiref(state, "math", luaopen_math, 1);
+	luaL_requiref(state, "base", luaopen_base, 1);
+	lua_settop(state, 0);
+
+	setGameConstants(state);
+	setGameFunctions(state);
 }
 
-IScriptableComponent::~IScriptableComponent()
+void IScriptableComponent::registerComponent()
 {
-	lua_close(mState);
+	// register this in the lua registry
+	lua_pushliteral(mState, "__C++_ScriptComponent__");
+	lua_pushlightuserdata(mState, (void*)this);
+	lua_settable(mState, LUA_REGISTRYINDEX);
 }
 
 void IScriptableComponent::openScript(std::string file)
 {
-	int error = FileRead::readLuaScript(file, mState);
+	runScript(mState, file);
+}
+
+void IScriptableComponent::runScript(lua_State* state, const std::string& file)
+{
+	// the scripts are compiled only once, and then shared between all components
+	int error = ScriptCache::load(state, *ScriptCache::get(file));
 	if (error == 0)
-		error = lua_pcall(mState, 0, 0, 0);
+		error = lua_pcall(state, 0, 0, 0);
 
 	if (error)
 	{
-		std::cerr << "Lua Error: " << lua_tostring(mState, -1);
+		std::cerr << "Lua Error: " << lua_tostring(state, -1);
 		std::cerr << std::endl;
 		ScriptException except;
-		except.luaerror = lua_tostring(mState, -1);
+		except.luaerror = lua_tostring(state, -1);
+		lua_pop(state, 1);
 		BOOST_THROW_EXCEPTION(except);
 	}
 }
@@ -67,37 +120,54 @@ bool IScriptableComponent::getLuaFunction(const char* fname) const
 	return true;
 }
 
-void IScriptableComponent::callLuaFunction(int arg_count)
+int IScriptableComponent::getLuaFunctionRef(const char* fname)
 {
-	if (lua_pcall(mState, arg_count, 0, 0))
+	if (!getLuaFunction(fname))
+		return LUA_NOREF;
+
+	int ref = luaL_ref(mState, LUA_REGISTRYINDEX);
+	mFunctionRefs.push_back(ref);
+	return ref;
+}
+
+void IScriptableComponent::pushLuaFunction(int ref) const
+{
+	lua_rawgeti(mState, LUA_REGISTRYINDEX, ref);
+}
+
+bool IScriptableComponent::callLuaFunction(int arg_count, int result_count)
+{
+	if (lua_pcall(mState, arg_count, result_count, 0))
 	{
 		std::cerr << "Lua Error: " << lua_tostring(mState, -1);
 		std::cerr << std::endl;
 		lua_pop(mState, 1);
+		return false;
 	}
+	return true;
 }
 
-void IScriptableComponent::setGameConstants()
+void IScriptableComponent::setGameConstants(lua_State* state)
 {
 	// set game constants
-	setLuaGlobal("CONST_FIELD_WIDTH", RIGHT_PLANE);
-	setLuaGlobal("CONST_GROUND_HEIGHT", 600 - GROUND_PLANE_HEIGHT_MAX);
-	setLuaGlobal("CONST_BALL_GRAVITY", -BALL_GRAVITATION);
-	setLuaGlobal("CONST_BALL_RADIUS", BALL_RADIUS);
-	setLuaGlobal("CONST_BLOBBY_JUMP", BLOBBY_JUMP_ACCELERATION);
-	setLuaGlobal("CONST_BLOBBY_BODY_RADIUS", BLOBBY_LOWER_RADIUS);
-	setLuaGlobal("CONST_BLOBBY_HEAD_RADIUS", BLOBBY_UPPER_RADIUS);
-	setLuaGlobal("CONST_BLOBBY_HEAD_OFFSET", BLOBBY_UPPER_SPHERE);
-	setLuaGlobal("CONST_BLOBBY_BODY_OFFSET", -BLOBBY_LOWER_SPHERE);
-	setLuaGlobal("CONST_BALL_HITSPEED", BALL_COLLISION_VELOCITY);
-	setLuaGlobal("CONST_BLOBBY_HEIGHT", BLOBBY_HEIGHT);
-	setLuaGlobal("CONST_BLOBBY_GRAVITY", -GRAVITATION);
-	setLuaGlobal("CONST_BLOBBY_SPEED", BLOBBY_SPEED);
-	setLuaGlobal("CONST_NET_HEIGHT", 600 - NET_SPHERE_POSITION);
-	setLuaGlobal("CONST_NET_RADIUS", NET_RADIUS);
-	setLuaGlobal("NO_PLAYER", NO_PLAYER);
-	setLuaGlobal("LEFT_PLAYER", LEFT_PLAYER);
-	setLuaGlobal("RIGHT_PLAYER", RIGHT_PLAYER);
+	setNumber(state, "CONST_FIELD_WIDTH", RIGHT_PLANE);
+	setNumber(state, "CONST_GROUND_HEIGHT", 600 - GROUND_PLANE_HEIGHT_MAX);
+	setNumber(state, "CONST_BALL_GRAVITY", -BALL_GRAVITATION);
+	setNumber(state, "CONST_BALL_RADIUS", BALL_RADIUS);
+	setNumber(state, "CONST_BLOBBY_JUMP", BLOBBY_JUMP_ACCELERATION);
+	setNumber(state, "CONST_BLOBBY_BODY_RADIUS", BLOBBY_LOWER_RADIUS);
+	setNumber(state, "CONST_BLOBBY_HEAD_RADIUS", BLOBBY_UPPER_RADIUS);
+	setNumber(state, "CONST_BLOBBY_HEAD_OFFSET", BLOBBY_UPPER_SPHERE);
+	setNumber(state, "CONST_BLOBBY_BODY_OFFSET", -BLOBBY_LOWER_SPHERE);
+	setNumber(state, "CONST_BALL_HITSPEED", BALL_COLLISION_VELOCITY);
+	setNumber(state, "CONST_BLOBBY_HEIGHT", BLOBBY_HEIGHT);
+	setNumber(state, "CONST_BLOBBY_GRAVITY", -GRAVITATION);
+	setNumber(state, "CONST_BLOBBY_SPEED", BLOBBY_SPEED);
+	setNumber(state, "CONST_NET_HEIGHT", 600 - NET_SPHERE_POSITION);
+	setNumber(state, "CONST_NET_RADIUS", NET_RADIUS);
+	setNumber(state, "NO_PLAYER", NO_PLAYER);
+	setNumber(state, "LEFT_PLAYER", LEFT_PLAYER);
+	setNumber(state, "RIGHT_PLAYER", RIGHT_PLAYER);
 }
 
 // helpers
@@ -145,16 +215,9 @@ struct IScriptableComponent::Access
 		auto sc = getScriptComponent( state );
 		return sc->mGame;
 	}
-
-	static PhysicWorld* getWorld( lua_State* state )
-	{
-		auto sc = getScriptComponent( state );
-		return &sc->mDummyWorld;
-	}
 };
 
 inline DuelMatch* getMatch( lua_State* s )  { return IScriptableComponent::Access::getMatch(s); };
-inline PhysicWorld* getWorld( lua_State* s )  { return IScriptableComponent::Access::getWorld(s); };
 
 // standard lua functions
 int get_ball_pos(lua_State* state)
@@ -268,7 +331,6 @@ int get_serving_player( lua_State* state )
 int simulate_steps( lua_State* state )
 {
 	/// \todo should we gather and return all events that happen to the ball on the way?
-	PhysicWorld* world = getWorld( state );
 	// get the initial ball settings
 	lua_checkstack(state, 5);
 	int steps = lua_tointeger( state, 1);
@@ -278,70 +340,140 @@ int simulate_steps( lua_State* state )
 	float vy = lua_tonumber( state, 5);
 	lua_pop( state, 5);
 
-	Vector2 v{vx, -vy};
-	world->setBallPosition( Vector2{x, 600 - y} );
-	world->setBallVelocity( Vector2{vx, -vy});
-	for(int i = 0; i < steps; ++i)
-	{
-		// set ball valid to false to ignore blobby bounces
-		world->step(PlayerInput(), PlayerInput(), false, true);
-	}
+	// the blobs are ignored, as if the ball was not valid
+	Vector2 position{x, 600 - y};
+	Vector2 velocity{vx, -vy};
+	PhysicWorld::simulateBall(position, velocity, steps);
 
-	int ret = lua_pushvector(state, world->getBallPosition(), VectorType::POSITION);
-	ret += lua_pushvector(state, world->getBallVelocity(), VectorType::VELOCITY);
+	int ret = lua_pushvector(state, position, VectorType::POSITION);
+	ret += lua_pushvector(state, velocity, VectorType::VELOCITY);
 	return ret;
 }
 
 int simulate_until(lua_State* state)
 {
 	/// \todo should we gather and return all events that happen to the ball on the way?
-	PhysicWorld* world = getWorld( state );
 	// get the initial ball settings
 	lua_checkstack(state, 6);
 	float x = lua_tonumber( state, 1);
 	float y = lua_tonumber( state, 2);
 	float vx = lua_tonumber( state, 3);
 	float vy = lua_tonumber( state, 4);
-	std::string axis = lua_tostring( state, 5 );
+	const char* axis = lua_tostring( state, 5 );
 	const float coordinate = lua_tonumber( state, 6 );
 	lua_pop( state, 6 );
 
-	const float ival = axis == "x" ? x : y;
-	if(axis != "x" && axis != "y")
+	const bool xAxis = axis && std::strcmp(axis, "x") == 0;
+	if(!xAxis && !(axis && std::strcmp(axis, "y") == 0))
 	{
 		lua_pushstring(state, "invalid condition specified: choose either 'x' or 'y'");
 		lua_error(state);
 	}
+	const float ival = xAxis ? x : y;
 	const bool init = ival < coordinate;
 
-	// setup the world
-	Vector2 v{vx, -vy};
-	world->setBallPosition( Vector2{x, 600 - y} );
-	world->setBallVelocity( Vector2{vx, -vy});
+	Vector2 position{x, 600 - y};
+	Vector2 velocity{vx, -vy};
 
 	int steps = 0;
-	while(coordinate != ival && steps < 75 * 5)
+	if(coordinate != ival)
 	{
-		steps++;
-		// set ball valid to false to ignore blobby bounces
-		world->step(PlayerInput(), PlayerInput(), false, true);
-		// check for the condition
-		auto pos = world->getBallPosition();
-		float v = axis == "x" ? pos.x : 600 - pos.y;
-		if( (v < coordinate) != init )
-			break;
+		// the blobs are ignored, as if the ball was not valid
+		steps = PhysicWorld::simulateBallUntil(position, velocity, [&](const Vector2& pos)
+			{
+				float v = xAxis ? pos.x : 600 - pos.y;
+				return (v < coordinate) != init;
+			}, 75 * 5);
 	}
-	// indicate failure
+	// indicate failure. this includes reaching the coordinate in the last step, as it always did.
 	if(steps == 75 * 5)
 		steps = -1;
 
 	lua_pushinteger(state, steps);
 	int ret = 1;
-	ret += lua_pushvector(state, world->getBallPosition(), VectorType::POSITION);
-	ret += lua_pushvector(state, world->getBallVelocity(), VectorType::VELOCITY);
+	ret += lua_pushvector(state, position, VectorType::POSITION);
+	ret += lua_pushvector(state, velocity, VectorType::VELOCITY);
 	return ret;
 }
 
+// reads candidate i of argument index of simulate_batch, which is either a number or an array
+static float batch_value(lua_State* state, int index, int i)
+{
+	if(!lua_istable(state, index))
+		return lua_tonumber(state, index);
+
+	lua_rawgeti(state, index, i);
+	float value = lua_tonumber(state, -1);
+	lua_pop(state, 1);
+	return value;
+}
+
+/// simulate_batch(steps, x, y, vx, vy) predicts many balls in one call. Every argument is
+/// either a number or an array, numbers are used for all candidates. Returns four arrays
+/// with the resulting positions and velocities, the same values simulate would return.
+int simulate_batch(lua_State* state)
+{
+	lua_settop(state, 5);
+	lua_checkstack(state, 5);
+
+	// all arrays need to have the same length
+	int count = -1;
+	for(int index = 1; index <= 5; ++index)
+	{
+		if(!lua_istable(state, index))
+			continue;
+		int length = lua_rawlen(state, index);
+		if(count != -1 && count != length)
+		{
+			lua_pushstring(state, "simulate_batch: all candidate arrays need to have the same length");
+			lua_error(state);
+		}
+		count = length;
+	}
+	if(count == -1)
+		count = 1;
+
+	for(int i = 0; i < 4; ++i)
+		lua_createtable(state, count, 0);
+
+	Vector2 start;
+	Vector2 startVelocity;
+	Vector2 position;
+	Vector2 velocity;
+	int done = -1;
+	for(int i = 1; i <= count; ++i)
+	{
+		int steps = std::max(0, (int)batch_value(state, 1, i));
+		Vector2 candidate{batch_value(state, 2, i), 600 - batch_value(state, 3, i)};
+		Vector2 candidateVelocity{batch_value(state, 4, i), -batch_value(state, 5, i)};
+
+		// candidates which only differ in the number of steps continue where the last one stopped
+		bool sameStart = done >= 0 && done <= steps &&
+				std::memcmp(&start, &candidate, sizeof(Vector2)) == 0 &&
+				std::memcmp(&startVelocity, &candidateVelocity, sizeof(Vector2)) == 0;
+		if(!sameStart)
+		{
+			start = position = candidate;
+			startVelocity = velocity = candidateVelocity;
+			done = 0;
+		}
+
+		PhysicWorld::simulateBall(position, velocity, steps - done);
+		done = steps;
+
+		lua_pushnumber(state, position.x);
+		lua_rawseti(state, 6, i);
+		lua_pushnumber(state, 600 - position.y);
+		lua_rawseti(state, 7, i);
+		lua_pushnumber(state, velocity.x);
+		lua_rawseti(state, 8, i);
+		lua_pushnumber(state, -velocity.y);
+		lua_rawseti(state, 9, i);
+	}
+
+	return 4;
+}
+
 
 int lua_print(lua_State* state)
 {
@@ -361,23 +493,24 @@ int lua_print(lua_State* state)
 	return 0;
 }
 
-void IScriptableComponent::setGameFunctions()
+void IScriptableComponent::setGameFunctions(lua_State* state)
 {
-	lua_register(mState, "get_ball_pos", get_ball_pos);
-	lua_register(mState, "get_ball_vel", get_ball_vel);
-	lua_register(mState, "get_blob_pos", get_blob_pos);
-	lua_register(mState, "get_blob_vel", get_blob_vel);
-	lua_register(mState, "get_score", get_score);
-	lua_register(mState, "get_touches", get_touches);
-	lua_register(mState, "is_ball_valid", get_ball_valid);
-	lua_register(mState, "is_game_running", get_game_running);
-	lua_register(mState, "get_serving_player", get_serving_player);
-	lua_register(mState, "simulate", simulate_steps);
-	lua_register(mState, "simulate_until", simulate_until);
+	lua_register(state, "get_ball_pos", get_ball_pos);
+	lua_register(state, "get_ball_vel", get_ball_vel);
+	lua_register(state, "get_blob_pos", get_blob_pos);
+	lua_register(state, "get_blob_vel", get_blob_vel);
+	lua_register(state, "get_score", get_score);
+	lua_register(state, "get_touches", get_touches);
+	lua_register(state, "is_ball_valid", get_ball_valid);
+	lua_register(state, "is_game_running", get_game_running);
+	lua_register(state, "get_serving_player", get_serving_player);
+	lua_register(state, "simulate", simulate_steps);
+	lua_register(state, "simulate_until", simulate_until);
+	lua_register(state, "simulate_batch", simulate_batch);
 
 	#ifndef NDEBUG
 	// only enable this function in debug builds.
-	lua_register(mState, "set_ball_data", set_ball_data);
-	lua_register(mState, "set_blob_data", set_blob_data);
+	lua_register(state, "set_ball_data", set_ball_data);
+	lua_register(state, "set_blob_data", set_blob_data);
 	#endif
 }
@@ -21,10 +21,11 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #pragma once
 
 #include <string>
-#include "PhysicWorld.h"
+#include <vector>
 
 struct lua_State;
 struct DuelMatch;
+class LuaStatePool;
 
 /*! \class IScriptableComponent
 	\brief Base class for lua scripted objects.
@@ -36,27 +37,45 @@ class IScriptableComponent
 public:
 	struct Access;
 protected:
+	/// creates a new lua state with the libraries, game constants and game functions
 	IScriptableComponent();
+	/// uses a state of \p pool, which has to be prepared by initState. The state is
+	/// returned to the pool on destruction.
+	explicit IScriptableComponent(LuaStatePool& pool);
 	virtual ~IScriptableComponent();
 
+	/// opens the libraries and registers the game constants and functions
+	static void initState(lua_State* state);
+	/// runs the script \p file in \p state. \throw ScriptException on lua errors
+	static void runScript(lua_State* state, const std::string& file);
+
 	void openScript(std::string file);
 	void setLuaGlobal(const char* name, double value);
 	bool getLuaFunction(const char* name) const;
+	/// stores the global function \p name in the lua registry, so it can be called
+	/// without looking it up by name. The reference is released with the component.
+	/// \return the reference, or LUA_NOREF if \p name is not a function
+	int getLuaFunctionRef(const char* name);
+	/// pushes a function stored by getLuaFunctionRef onto the stack
+	void pushLuaFunction(int ref) const;
 
 	// calls a lua function that is on the stack and performs error handling
-	void callLuaFunction(int arg_count = 0);
+	// returns false if the function raised an error; the error is popped then.
+	bool callLuaFunction(int arg_count = 0, int result_count = 0);
 
 	// load lua functions
-	void setGameConstants();
-	void setGameFunctions();
+	static void setGameConstants(lua_State* state);
+	static void setGameFunctions(lua_State* state);
 	void setMatch( DuelMatch* m ) { mGame = m; };
 	DuelMatch* getMatch() const { return mGame; };
 
 	lua_State* mState;
 
 private:
+	void registerComponent();
+
+	LuaStatePool* mPool;
 	DuelMatch* mGame;
-	// we save a dummy physic world here to do simulations
-	PhysicWorld mDummyWorld;
+	std::vector<int> mFunctionRefs;
 };
 
@@ -0,0 +1,92 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+
+/* header include */
+#include "InputHistory.h"
+
+/* includes */
+#include "raknet/BitStream.h"
+
+/* implementation */
+
+InputHistory::InputHistory() : mNewestTick(0), mCount(0), mLastChange(0)
+{
+}
+
+void InputHistory::add(unsigned int tick, const PlayerInputAbs& input)
+{
+	if(mCount == 0 || !(mInputs[mNewestTick % SIZE] == input))
+		mLastChange = 0;
+	 else
+		mLastChange++;
+
+	mNewestTick = tick;
+	mInputs[tick % SIZE] = input;
+	if(mCount < SIZE)
+		mCount++;
+}
+
+bool InputHistory::hasRecentChange() const
+{
+	return mCount < SIZE || mLastChange < SIZE;
+}
+
+bool InputHistory::isWritable() const
+{
+	for(int i = 0; i < mCount; ++i)
+	{
+		if(!mInputs[(mNewestTick - i) % SIZE].isRelative())
+			return false;
+	}
+	return true;
+}
+
+void InputHistory::writeTo(RakNet::BitStream& stream) const
+{
+	stream.Write( mNewestTick );
+	stream.Write( (unsigned char)mCount );
+	for(int i = mCount - 1; i >= 0; --i)
+	{
+		PlayerInput input = mInputs[(mNewestTick - i) % SIZE].toPlayerInput(0);
+		stream.Write( input.left );
+		stream.Write( input.right );
+		stream.Write( input.up );
+	}
+}
+
+int InputHistory::readFrom(RakNet::BitStream& stream, unsigned int& newestTick, PlayerInputAbs* inputs)
+{
+	unsigned char count;
+	if(!stream.Read(newestTick) || !stream.Read(count))
+		return 0;
+	if(count > SIZE || stream.GetNumberOfUnreadBits() < 3 * count)
+		return 0;
+
+	for(int i = 0; i < count; ++i)
+	{
+		bool left, right, jump;
+		stream.Read(left);
+		stream.Read(right);
+		stream.Read(jump);
+		inputs[i] = PlayerInputAbs(left, right, jump);
+	}
+	return count;
+}
@@ -0,0 +1,70 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+
+#pragma once
+
+#include "PlayerInput.h"
+#include "BlobbyDebug.h"
+
+namespace RakNet
+{
+	class BitStream;
+}
+
+/*! \class InputHistory
+	\brief the last inputs of the local player, for sending them redundantly
+	\details Each ID_INPUT_HISTORY packet contains the last SIZE inputs with their ticks,
+			three bits per input. So a change of the input reaches the server as long as
+			one of the SIZE packets sent after it arrives.
+			The client only has to send a packet every frame as long as the input has
+			changed during the last SIZE ticks. After that, heartbeats are enough: the
+			server knows that ticks it never received repeat the previous input.
+			Only relative inputs can be written this way.
+*/
+class InputHistory : public ObjectCounter<InputHistory>
+{
+	public:
+		InputHistory();
+
+		/// adds the input of the next tick
+		void add(unsigned int tick, const PlayerInputAbs& input);
+
+		/// whether the input changed during the last SIZE ticks, or the history is not full yet
+		bool hasRecentChange() const;
+		/// whether all inputs in the history are relative inputs, so they can be written
+		bool isWritable() const;
+
+		/// writes the newest tick, the number of inputs and the inputs, oldest first
+		void writeTo(RakNet::BitStream& stream) const;
+
+		/// reads the data written by writeTo. \p inputs must have room for SIZE inputs.
+		/// \return the number of inputs read, which belong to the ticks up to \p newestTick,
+		///			or 0 if the stream was too short.
+		static int readFrom(RakNet::BitStream& stream, unsigned int& newestTick, PlayerInputAbs* inputs);
+
+		static const int SIZE = 8;
+
+	private:
+		PlayerInputAbs mInputs[SIZE];
+		unsigned int mNewestTick;
+		int mCount;
+		int mLastChange;			// number of ticks since the input last changed
+};
@@ -26,6 +26,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <boost/make_shared.hpp>
 
+#include "AsyncInputSource.h"
 #include "IUserConfigReader.h"
 #include "LocalInputSource.h"
 #include "ScriptedInputSource.h"
@@ -43,8 +44,16 @@ boost::shared_ptr<InputSource> InputSourceFactory::createInputSource( boost::sha
 		}
 		else
 		{
-			return boost::make_shared<ScriptedInputSource>("scripts/" + config->getString(prefix + "_script_name"),
+			auto bot = boost::make_shared<ScriptedInputSource>("scripts/" + config->getString(prefix + "_script_name"),
 					side, config->getInteger(prefix + "_script_strength"));
+
+			// with a time budget, the bot thinks on its own thread, so it cannot slow down the game
+			int budget = config->getInteger("bot_time_budget");
+			if (budget > 0)
+			{
+				return boost::make_shared<AsyncInputSource>(bot, side, std::chrono::microseconds(budget));
+			}
+			return bot;
 		}
 	} catch (std::exception& e)
 	{
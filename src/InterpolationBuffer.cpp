@@ -0,0 +1,177 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+
+/* header include */
+#include "InterpolationBuffer.h"
+
+/* includes */
+#include <cmath>
+
+/* implementation */
+
+namespace
+{
+	// weight of a new sample in the running averages
+	const double AVERAGE_WEIGHT = 1.0 / 16;
+	// how fast the delay follows its target. This is slow, so changes of the delay
+	// are not visible as changes of the speed of the remote objects.
+	const double DELAY_ADAPTION = 1.0 / 64;
+	// how fast the clock offset follows slower snapshots, to compensate for clock drift
+	const double OFFSET_DRIFT = 1.0 / 512;
+	// snapshots which are late by more than this re-synchronize the clocks, e.g. after a pause
+	const double RESYNC_DEVIATION = 50;
+	// objects which moved farther than this between two snapshots were reset, not moved
+	const float TELEPORT_DISTANCE = 100;
+	// the ball rotation wraps around at this value, see PhysicWorld
+	const float FULL_ROTATION = 6.25;
+
+	Vector2 lerp(const Vector2& a, const Vector2& b, float t)
+	{
+		if((b - a).length() > TELEPORT_DISTANCE)
+			return t < 0.5 ? a : b;
+		return a + (b - a) * t;
+	}
+
+	float lerp(float a, float b, float t)
+	{
+		return a + (b - a) * t;
+	}
+
+	float interpolateRotation(float a, float b, float t)
+	{
+		// take the short way around
+		if(b - a > FULL_ROTATION / 2)
+			a += FULL_ROTATION;
+		else if(a - b > FULL_ROTATION / 2)
+			b += FULL_ROTATION;
+		return std::fmod(a + (b - a) * t, FULL_ROTATION);
+	}
+}
+
+InterpolationBuffer::InterpolationBuffer()
+{
+	clear();
+}
+
+void InterpolationBuffer::add(unsigned int step, double time, const DuelMatchState& state)
+{
+	double offset = time - step;
+
+	if(mCount == 0)
+	{
+		mOffset = offset;
+	}
+	 else
+	{
+		const Snapshot& newest = mSnapshots[mNewest];
+		int gap = step - newest.step;
+		if(gap <= 0)
+			return;
+
+		mInterval += (gap - mInterval) * AVERAGE_WEIGHT;
+
+		// the fastest snapshots define the offset between the clocks, all others are late
+		double deviation = offset - mOffset;
+		if(deviation < 0 || deviation > RESYNC_DEVIATION)
+		{
+			mOffset = offset;
+			deviation = 0;
+		}
+		 else
+		{
+			mOffset += deviation * OFFSET_DRIFT;
+		}
+
+		mJitter += (deviation - mJitter) * AVERAGE_WEIGHT;
+	}
+
+	mNewest = (mNewest + 1) % SIZE;
+	if(mCount < SIZE)
+		++mCount;
+	mSnapshots[mNewest].step = step;
+	mSnapshots[mNewest].state = state;
+
+	// wait for the next snapshot, and for late snapshots
+	double target = mInterval + 2 * mJitter;
+	mDelay += (target - mDelay) * DELAY_ADAPTION;
+}
+
+bool InterpolationBuffer::interpolate(double time, DuelMatchState& state) const
+{
+	if(mCount == 0)
+		return false;
+
+	double step = time - mOffset - mDelay;
+
+	// find the newest snapshot that is not newer than the drawn step
+	int later = mNewest;
+	int earlier = mNewest;
+	for(int i = 1; i < mCount && mSnapshots[earlier].step > step; ++i)
+	{
+		later = earlier;
+		earlier = (earlier + SIZE - 1) % SIZE;
+	}
+
+	const Snapshot& a = mSnapshots[earlier];
+	const Snapshot& b = mSnapshots[later];
+	state = a.state;
+
+	// don't extrapolate beyond the newest or before the oldest snapshot
+	if(earlier == later || step <= a.step)
+		return true;
+
+	float t = (step - a.step) / (b.step - a.step);
+	PhysicState& world = state.worldState;
+	const PhysicState& from = a.state.worldState;
+	const PhysicState& to = b.state.worldState;
+	for(int i = 0; i < MAX_PLAYERS; ++i)
+	{
+		world.blobPosition[i] = lerp(from.blobPosition[i], to.blobPosition[i], t);
+		world.blobVelocity[i] = lerp(from.blobVelocity[i], to.blobVelocity[i], t);
+		world.blobState[i] = lerp(from.blobState[i], to.blobState[i], t);
+	}
+	world.ballPosition = lerp(from.ballPosition, to.ballPosition, t);
+	world.ballVelocity = lerp(from.ballVelocity, to.ballVelocity, t);
+	world.ballRotation = interpolateRotation(from.ballRotation, to.ballRotation, t);
+	world.ballAngularVelocity = lerp(from.ballAngularVelocity, to.ballAngularVelocity, t);
+
+	return true;
+}
+
+double InterpolationBuffer::getDelay() const
+{
+	return mDelay;
+}
+
+double InterpolationBuffer::getJitter() const
+{
+	return mJitter;
+}
+
+void InterpolationBuffer::clear()
+{
+	mCount = 0;
+	mNewest = 0;
+	mOffset = 0;
+	mJitter = 0;
+	mInterval = 1;
+	mDelay = 1;
+}
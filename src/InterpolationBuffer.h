@@ -0,0 +1,77 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+
+#pragma once
+
+#include "DuelMatchState.h"
+#include "BlobbyDebug.h"
+
+/*! \class InterpolationBuffer
+	\brief renders the remote game state a little in the past, between two received snapshots
+	\details The server does not necessarily send a snapshot every step, and snapshots don't
+			arrive at regular intervals. Instead of drawing the last snapshot as soon as it
+			arrives, the client keeps the last snapshots together with the server step they
+			belong to, and draws the state that lies a small delay behind the newest one,
+			interpolated between the two snapshots around it.
+			The delay adapts to the measured snapshot interval and arrival jitter: it has to be
+			large enough that the next snapshot usually arrives before it is needed, but every
+			additional step of delay makes the remote objects lag behind.
+			All times are measured in game steps.
+*/
+class InterpolationBuffer : public ObjectCounter<InterpolationBuffer>
+{
+	public:
+		InterpolationBuffer();
+
+		/// adds the snapshot of server step \p step, which was received at client time \p time.
+		/// Snapshots that are older than the newest one are ignored.
+		void add(unsigned int step, double time, const DuelMatchState& state);
+
+		/// calculates the state that is drawn at client time \p time.
+		/// \return false, if no snapshot has been received yet.
+		bool interpolate(double time, DuelMatchState& state) const;
+
+		/// number of steps the drawn state lags behind the newest snapshot at the
+		/// time it arrives
+		double getDelay() const;
+		/// average deviation of the arrival times from the expected arrival times
+		double getJitter() const;
+
+		void clear();
+
+		static const int SIZE = 32;
+
+	private:
+		struct Snapshot
+		{
+			unsigned int step;
+			DuelMatchState state;
+		};
+
+		Snapshot mSnapshots[SIZE];
+		int mCount;					// number of valid snapshots
+		int mNewest;				// index of the newest snapshot
+
+		double mOffset;				// client time minus server step of the fastest snapshots
+		double mJitter;
+		double mInterval;			// average number of steps between two snapshots
+		double mDelay;
+};
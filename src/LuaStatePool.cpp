@@ -0,0 +1,205 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "LuaStatePool.h"
+
+/* includes */
+extern "C"
+{
+#include "lua/lua.h"
+#include "lua/lauxlib.h"
+}
+
+/* implementation */
+
+namespace
+{
+	// registry keys of the copies of the globals and of the tables stored in globals
+	// after initialisation
+	const char* INITIAL_GLOBALS = "__POOL_INITIAL_GLOBALS";
+	const char* INITIAL_TABLES = "__POOL_INITIAL_TABLES";
+
+	// pushes a copy of the table at \p index, the values are not copied recursively
+	void pushCopy(lua_State* state, int index)
+	{
+		index = lua_absindex(state, index);
+		lua_newtable(state);
+		lua_pushnil(state);
+		while(lua_next(state, index))
+		{
+			// copy key and value to the new table, keep the key for lua_next
+			lua_pushvalue(state, -2);
+			lua_insert(state, -2);
+			lua_rawset(state, -4);
+		}
+	}
+
+	void saveGlobals(lua_State* state)
+	{
+		lua_settop(state, 0);
+		lua_pushglobaltable(state);									// 1: globals
+		pushCopy(state, 1);
+		lua_setfield(state, LUA_REGISTRYINDEX, INITIAL_GLOBALS);
+
+		// the tables in the globals, e.g. the standard libraries, are copied as well, so a
+		// script can't replace math.floor for the next game. The copies are keyed by the tables.
+		lua_newtable(state);										// 2: copies of the tables
+		lua_pushnil(state);
+		while(lua_next(state, 1))
+		{
+			if(lua_istable(state, -1) && !lua_rawequal(state, -1, 1))
+			{
+				pushCopy(state, -1);
+				lua_rawset(state, 2);
+			}
+			 else
+			{
+				lua_pop(state, 1);
+			}
+		}
+		lua_setfield(state, LUA_REGISTRYINDEX, INITIAL_TABLES);
+		lua_settop(state, 0);
+	}
+
+	// resets the table at \p table to its copy at \p copy. Keys that were added are removed.
+	void restoreTable(lua_State* state, int table, int copy)
+	{
+		int top = lua_gettop(state);
+
+		// collect the keys that were added, we must not remove them while traversing the table
+		lua_newtable(state);
+		int addedKeys = top + 1;
+		int added = 0;
+		lua_pushnil(state);
+		while(lua_next(state, table))
+		{
+			lua_pop(state, 1);
+			lua_pushvalue(state, -1);
+			lua_rawget(state, copy);
+			bool known = !lua_isnil(state, -1);
+			lua_pop(state, 1);
+			if(!known)
+			{
+				lua_pushvalue(state, -1);
+				lua_rawseti(state, addedKeys, ++added);
+			}
+		}
+
+		for(int i = 1; i <= added; ++i)
+		{
+			lua_rawgeti(state, addedKeys, i);
+			lua_pushnil(state);
+			lua_rawset(state, table);
+		}
+
+		// reset the values of the initial keys
+		lua_pushnil(state);
+		while(lua_next(state, copy))
+		{
+			lua_pushvalue(state, -2);
+			lua_insert(state, -2);
+			lua_rawset(state, table);
+		}
+
+		lua_settop(state, top);
+	}
+
+	void restoreGlobals(lua_State* state)
+	{
+		lua_settop(state, 0);
+		lua_getfield(state, LUA_REGISTRYINDEX, INITIAL_GLOBALS);	// 1: initial globals
+		lua_pushglobaltable(state);									// 2: globals
+		restoreTable(state, 2, 1);
+
+		lua_getfield(state, LUA_REGISTRYINDEX, INITIAL_TABLES);		// 3: copies of the tables
+		lua_pushnil(state);
+		while(lua_next(state, 3))
+		{
+			// 4: table, 5: its copy
+			restoreTable(state, 4, 5);
+			lua_pop(state, 1);
+		}
+
+		lua_settop(state, 0);
+	}
+}
+
+LuaStatePool::LuaStatePool(Initializer initializer, std::size_t capacity) :
+	mInitializer(initializer), mCapacity(capacity)
+{
+}
+
+LuaStatePool::~LuaStatePool()
+{
+	for(lua_State* state : mStates)
+		lua_close(state);
+}
+
+lua_State* LuaStatePool::acquire()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if(!mStates.empty())
+		{
+			lua_State* state = mStates.back();
+			mStates.pop_back();
+			return state;
+		}
+	}
+
+	lua_State* state = luaL_newstate();
+	try
+	{
+		mInitializer(state);
+	}
+	catch(...)
+	{
+		lua_close(state);
+		throw;
+	}
+
+	lua_settop(state, 0);
+	saveGlobals(state);
+	return state;
+}
+
+void LuaStatePool::release(lua_State* state)
+{
+	restoreGlobals(state);
+	// free the garbage of the last user now, and not during the next game
+	lua_gc(state, LUA_GCCOLLECT, 0);
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	if(mStates.size() < mCapacity)
+	{
+		mStates.push_back(state);
+	}
+	 else
+	{
+		lua_close(state);
+	}
+}
+
+std::size_t LuaStatePool::getAvailable() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mStates.size();
+}
@@ -0,0 +1,70 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "BlobbyDebug.h"
+
+struct lua_State;
+
+/*! \class LuaStatePool
+	\brief keeps prepared lua states for reuse
+	\details Preparing a lua state for a script (opening the libraries, registering
+			the C functions and running the api scripts) costs more than running the
+			script itself. The pool prepares each state once with its initializer and
+			remembers which globals the state has at that point, and the contents of the
+			tables stored in them, e.g. the standard libraries. When a state is released,
+			all globals and these tables are reset to their initial contents, keys that
+			were added later are removed, and the state is handed out again by the next
+			acquire. Tables nested deeper are not reset, so the initializer should not
+			create such tables that scripts are expected to modify.
+			The pool can be used from several threads.
+*/
+class LuaStatePool : public ObjectCounter<LuaStatePool>
+{
+	public:
+		typedef std::function<void(lua_State*)> Initializer;
+
+		/// \p initializer prepares a new state. It may throw, the state is closed then.
+		/// At most \p capacity released states are kept.
+		explicit LuaStatePool(Initializer initializer, std::size_t capacity = 16);
+		~LuaStatePool();
+
+		/// returns a prepared state, which is either newly created or a released one.
+		/// \throw whatever the initializer throws
+		lua_State* acquire();
+		/// resets \p state and keeps it for reuse. \p state has to be acquired from this pool.
+		void release(lua_State* state);
+
+		/// number of states that are ready to be acquired
+		std::size_t getAvailable() const;
+
+	private:
+		Initializer mInitializer;
+		std::size_t mCapacity;
+
+		mutable std::mutex mMutex;
+		std::vector<lua_State*> mStates;
+};
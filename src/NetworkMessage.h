@@ -48,7 +48,9 @@ enum MessageType
 	ID_RULES_CHECKSUM,
 	ID_RULES,
 	ID_SERVER_STATUS,
-	ID_LOBBY
+	ID_LOBBY,
+	ID_GAME_UPDATE_DELTA,	// send delta compressed game status from server to client [unreliable]
+	ID_INPUT_HISTORY		// send the last inputs from client to server [unreliable]
 };
 
 // General Information:
@@ -69,6 +71,35 @@ enum MessageType
 // 		left keypress (bool)
 // 		right keypress (bool)
 // 		up keypress (bool)
+//		[optional] last received snapshot (unsigned int)
+//		[optional] keyframe request (bool)
+//		[optional] snapshot encoding (unsigned char, SnapshotCodec::Encoding)
+//		[optional] input tick (unsigned int)
+//	Clients that append the optional snapshot acknowledgement receive
+//	ID_GAME_UPDATE_DELTA instead of ID_GAME_UPDATE.
+//	The input tick is only sent once the client has received an
+//	ID_GAME_UPDATE_DELTA, because older servers do not expect it.
+//	If the input tick is sent, the server buffers the inputs and uses them
+//	in the order of their ticks, one per step (see InputJitterBuffer).
+//
+// ID_INPUT_HISTORY
+// 	Description:
+// 		Replaces ID_INPUT_UPDATE for relative (keyboard and joystick) input,
+//		once the client knows the server sends ID_GAME_UPDATE_DELTA.
+//		Contains the inputs of the last ticks (see InputHistory), so a lost
+//		packet does not lose an input. The client sends it every frame as long
+//		as the input has changed during the last ticks, otherwise only as a
+//		heartbeat every few frames. Ticks that are not sent repeat the previous
+//		input.
+// 	Structure:
+// 		ID_INPUT_HISTORY
+// 		timestamp (int)
+//		last received snapshot (unsigned int)
+//		keyframe request (bool)
+//		snapshot encoding (unsigned char, SnapshotCodec::Encoding)
+//		newest input tick (unsigned int)
+//		number of inputs (unsigned char)
+//		inputs, oldest first: left, right, up keypress (3 bits each)
 //
 // ID_PHYSIC_UPDATE:
 // 	Description:
@@ -82,6 +113,32 @@ enum MessageType
 //		packet_number (unsigned char)
 // 		Physic data (analysed by PhysicWorld)
 //
+// ID_GAME_UPDATE_DELTA
+// 	Description:
+// 		Like ID_GAME_UPDATE, but the state is encoded by SnapshotCodec, either
+//		as keyframe or as delta against the snapshot with number
+//		(snapshot number - base offset), which the client has acknowledged.
+//		Keyframes are sent periodically and when the client requests one.
+//		Depending on the server configuration, this is not sent every step.
+//		The server step lets the client place the snapshot on the server timeline.
+// 	Structure:
+// 		ID_GAME_UPDATE_DELTA
+// 		timestamp (int)
+//		snapshot number (unsigned int)
+//		keyframe (bool)
+//		[if not keyframe] base offset (unsigned char)
+//		quantized (bool)
+//		input tick of the last input of this client the server has simulated (unsigned int)
+//		server step (unsigned int)
+// 		state data (SnapshotCodec)
+//		[optional] state hash follows (bool)
+//		[optional] DuelMatchState::hash of the state the server has simulated in the step
+//			of the input tick, high and low half (2 unsigned int)
+//	The hash is only sent with every few snapshots. It is not the hash of the
+//	(possibly quantized) state data, but of the exact state. The client compares
+//	it with the state it has simulated for the same input tick, so it notices if
+//	its simulation has silently diverged from the server's.
+//
 // ID_GAME_READY
 // 	Description:
 // 		Message sent from server to client when all clients are
@@ -22,6 +22,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "PhysicState.h"
 
 /* includes */
+#include <ostream>
+
 #include "GameConstants.h"
 #include "GenericIO.h"
 
@@ -67,3 +69,16 @@ void PhysicState::swapSides()
 	ballAngularVelocity = -ballAngularVelocity;
 	ballRotation = 2*M_PI - ballRotation;
 }
+
+std::ostream& operator<<(std::ostream& stream, const PhysicState& state)
+{
+	// enough digits to tell every two floats apart
+	std::streamsize precision = stream.precision(9);
+	stream << "PHYSIC STATE [ " << state.blobPosition[LEFT_PLAYER] << " " << state.blobVelocity[LEFT_PLAYER]
+			<< " " << state.blobState[LEFT_PLAYER] << "  " << state.blobPosition[RIGHT_PLAYER] << " "
+			<< state.blobVelocity[RIGHT_PLAYER] << " " << state.blobState[RIGHT_PLAYER] << "  "
+			<< state.ballPosition << " " << state.ballVelocity << " " << state.ballRotation << " "
+			<< state.ballAngularVelocity << "]";
+	stream.precision(precision);
+	return stream;
+}
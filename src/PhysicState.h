@@ -20,6 +20,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #pragma once
 
+#include <iosfwd>
+
 #include "Global.h"
 #include "Vector.h"
 #include "GenericIOFwd.h"
@@ -42,3 +44,5 @@ struct PhysicState
 
 	void swapSides();
 };
+
+std::ostream& operator<<(std::ostream&, const PhysicState&);
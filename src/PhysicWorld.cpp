@@ -22,6 +22,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "PhysicWorld.h"
 
 /* includes */
+#include <algorithm>
 #include <limits>
 #include <iostream>
 
@@ -29,14 +30,56 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "GameConstants.h"
 #include "MatchEvents.h"
+#include "FloatDeterminism.h"
+#include "PhysicWorldDetail.h"
 
 /* implementation */
-// Gamefeeling relevant constants:
-const float BLOBBY_ANIMATION_SPEED = 0.5;
+namespace
+{
+	inline void stepBall(Vector2& position, Vector2& velocity)
+	{
+		detail::moveBall(position, velocity);
+		detail::ballWorldCollisions(position, velocity, [](const MatchEvent&) {});
+	}
 
-// helper function for setting FPU precision
-inline short set_fpu_single_precision();
-void reset_fpu_flags(short flags);
+	// A lower bound for the number of steps the ball flies before any of the tests in
+	// ballWorldCollisions can become true. For these steps, moveBall alone gives exactly
+	// the same results as stepBall. The margin covers the rounding errors of the stepping.
+	inline int freeFlightSteps(const Vector2& position, const Vector2& velocity)
+	{
+		const int MAX_STEPS = 1 << 16;
+		const double MARGIN = 1;
+		// the net tests are only done near the net
+		const double NET_DISTANCE = NET_RADIUS + BALL_RADIUS + 1 + MARGIN;
+
+		// horizontally, the ball has to stay between a wall and the net
+		double x = position.x;
+		double vx = velocity.x;
+		double left = x < NET_POSITION_X ? LEFT_PLANE + BALL_RADIUS + MARGIN : NET_POSITION_X + NET_DISTANCE;
+		double right = x < NET_POSITION_X ? NET_POSITION_X - NET_DISTANCE : RIGHT_PLANE - BALL_RADIUS - MARGIN;
+		if (!(x > left && x < right))
+			return 0;
+
+		double steps = MAX_STEPS;
+		if (vx > 0)
+			steps = (right - x) / vx;
+		else if (vx < 0)
+			steps = (left - x) / vx;
+
+		// vertically, it must not reach the ground. After k steps, it is at y + k vy + g/2 k^2
+		double y = position.y;
+		double vy = velocity.y;
+		double bottom = GROUND_PLANE_HEIGHT_MAX - BALL_RADIUS - MARGIN;
+		if (!(y < bottom))
+			return 0;
+		steps = std::min(steps, (-vy + std::sqrt(vy * vy + 2 * BALL_GRAVITATION * (bottom - y))) / BALL_GRAVITATION);
+
+		// this also catches NaN
+		if (!(steps >= 2))
+			return 0;
+		return steps < MAX_STEPS ? (int)steps - 1 : MAX_STEPS;
+	}
+}
 
 PhysicWorld::PhysicWorld()
 : mBallPosition(Vector2(200, STANDARD_BALL_HEIGHT))
@@ -69,25 +112,9 @@ bool PhysicWorld::blobHitGround(PlayerSide player) const
 		return false;
 }
 
-bool PhysicWorld::playerTopBallCollision(int player) const
-{
-	Vector2 blobpos{mBlobPosition[player].x, mBlobPosition[player].y - BLOBBY_UPPER_SPHERE};
-	return circleCircleCollision( mBallPosition, BALL_RADIUS,
-								blobpos, BLOBBY_UPPER_RADIUS );
-}
-
-inline bool PhysicWorld::playerBottomBallCollision(int player) const
+bool PhysicWorld::circleCircleCollision(const Vector2& pos1, float rad1, const Vector2& pos2, float rad2)
 {
-	Vector2 blobpos{mBlobPosition[player].x, mBlobPosition[player].y + BLOBBY_LOWER_SPHERE};
-	return circleCircleCollision( mBallPosition, BALL_RADIUS,
-								blobpos, BLOBBY_LOWER_RADIUS );
-}
-
-inline bool PhysicWorld::circleCircleCollision(const Vector2& pos1, float rad1, const Vector2& pos2, float rad2)
-{
-	Vector2 distance = pos1 - pos2;
-	float mxdist = rad1 + rad2;
-	return distance.lengthSQ() < mxdist * mxdist;
+	return detail::circleCircleCollision(pos1, rad1, pos2, rad2);
 }
 
 float PhysicWorld::getBallRotation() const
@@ -184,39 +211,14 @@ void PhysicWorld::handleBlob(PlayerSide player, PlayerInput input)
 
 bool PhysicWorld::handleBlobbyBallCollision(PlayerSide player)
 {
-	Vector2 circlepos = mBlobPosition[player];
-	// check for impact
-	if(playerBottomBallCollision(player))
-	{
-		circlepos.y += BLOBBY_LOWER_SPHERE;
-	}
-	 else if(playerTopBallCollision(player))
-	{
-		circlepos.y -= BLOBBY_LOWER_SPHERE;
-	} else
-	{	// no impact!
-		return false;
-	}
-
-	// ok, if we get here, there actually was a collision
-
-	// calculate hit intensity
-	mLastHitIntensity = Vector2(mBallVelocity, mBlobVelocity[player]).length() / 25.0;
-	mLastHitIntensity = mLastHitIntensity > 1.0 ? 1.0 : mLastHitIntensity;
-
-	// set ball velocity
-	mBallVelocity = -Vector2(mBallPosition, circlepos);
-	mBallVelocity = mBallVelocity.normalise();
-	mBallVelocity = mBallVelocity.scale(BALL_COLLISION_VELOCITY);
-	mBallPosition += mBallVelocity;
-	return true;
+	return detail::blobBallCollision(mBallPosition, mBallVelocity, mBlobPosition[player], mBlobVelocity[player], mLastHitIntensity);
 }
 
 void PhysicWorld::step(const PlayerInput& leftInput, const PlayerInput& rightInput,
 					bool isBallValid, bool isGameRunning)
 {
 	// Determistic IEEE 754 floating point computations
-	short fpf = set_fpu_single_precision();
+	ScopedFloatPrecision precision;
 
 	// Compute independent actions
 	handleBlob(LEFT_PLAYER, leftInput);
@@ -225,11 +227,7 @@ void PhysicWorld::step(const PlayerInput& leftInput, const PlayerInput& rightInp
 	// Move ball when game is running
 	if (isGameRunning)
 	{
-		// dt = 1 !!
-		// move ball ds = a/2 * dt^2 + v * dt
-		mBallPosition += Vector2(0, 0.5f * BALL_GRAVITATION) + mBallVelocity;
-		// dv = a*dt
-		mBallVelocity.y += BALL_GRAVITATION;
+		detail::moveBall(mBallPosition, mBallVelocity);
 	}
 
 	// Collision detection
@@ -270,81 +268,69 @@ void PhysicWorld::step(const PlayerInput& leftInput, const PlayerInput& rightInp
 		mBallRotation = 6.25 + mBallRotation;
 	else if (mBallRotation >= 6.25)
 		mBallRotation = mBallRotation - 6.25;
-
-
-	reset_fpu_flags(fpf);
 }
 
 void PhysicWorld::handleBallWorldCollisions()
 {
-	// Ball to ground Collision
-	if (mBallPosition.y + BALL_RADIUS > GROUND_PLANE_HEIGHT_MAX)
-	{
-		mBallVelocity = mBallVelocity.reflectY();
-		mBallVelocity = mBallVelocity.scale(0.95);
-		mBallPosition.y = GROUND_PLANE_HEIGHT_MAX - BALL_RADIUS;
-		mCallback( MatchEvent{MatchEvent::BALL_HIT_GROUND, mBallPosition.x > NET_POSITION_X ? RIGHT_PLAYER : LEFT_PLAYER, 0} );
-	}
+	detail::ballWorldCollisions(mBallPosition, mBallVelocity, mCallback);
+}
 
-	// Border Collision
-	if (mBallPosition.x - BALL_RADIUS <= LEFT_PLANE && mBallVelocity.x < 0.0)
-	{
-		mBallVelocity = mBallVelocity.reflectX();
-		// set the ball's position
-		mBallPosition.x = LEFT_PLANE + BALL_RADIUS;
-		mCallback( MatchEvent{MatchEvent::BALL_HIT_WALL, LEFT_PLAYER, 0} );
-	}
-	else if (mBallPosition.x + BALL_RADIUS >= RIGHT_PLANE && mBallVelocity.x > 0.0)
-	{
-		mBallVelocity = mBallVelocity.reflectX();
-		// set the ball's position
-		mBallPosition.x = RIGHT_PLANE - BALL_RADIUS;
-		mCallback( MatchEvent{MatchEvent::BALL_HIT_WALL, RIGHT_PLAYER, 0} );
-	}
-	else if (mBallPosition.y > NET_SPHERE_POSITION &&
-			fabs(mBallPosition.x - NET_POSITION_X) < BALL_RADIUS + NET_RADIUS)
+void PhysicWorld::simulateBall(Vector2& position, Vector2& velocity, int steps)
+{
+	ScopedFloatPrecision precision;
+	// work on local copies, so they can be kept in registers
+	Vector2 pos = position;
+	Vector2 vel = velocity;
+	while(steps > 0)
 	{
-		bool right = mBallPosition.x - NET_POSITION_X > 0;
-		mBallVelocity = mBallVelocity.reflectX();
-		// set the ball's position so that it touches the net
-		mBallPosition.x = NET_POSITION_X + (right ? (BALL_RADIUS + NET_RADIUS) : (-BALL_RADIUS - NET_RADIUS));
+		// skip the collision tests as long as the ball cannot collide
+		int flight = std::min(steps, freeFlightSteps(pos, vel));
+		for(int i = 0; i < flight; ++i)
+		{
+			detail::moveBall(pos, vel);
+		}
+		steps -= flight;
 
-		mCallback( MatchEvent{MatchEvent::BALL_HIT_NET, right ? RIGHT_PLAYER : LEFT_PLAYER, 0} );
+		if(steps > 0)
+		{
+			stepBall(pos, vel);
+			--steps;
+		}
 	}
-	else
-	{
-		// Net Collisions
-
-		float ballNetDistance = Vector2(mBallPosition, Vector2(NET_POSITION_X, NET_SPHERE_POSITION)).length();
+	position = pos;
+	velocity = vel;
+}
 
-		if (ballNetDistance < NET_RADIUS + BALL_RADIUS)
+int PhysicWorld::simulateBallUntil(Vector2& position, Vector2& velocity,
+									const std::function<bool(const Vector2&)>& stop, int maxSteps)
+{
+	ScopedFloatPrecision precision;
+	Vector2 pos = position;
+	Vector2 vel = velocity;
+	int steps = 0;
+	bool stopped = false;
+	while(steps < maxSteps && !stopped)
+	{
+		int flight = std::min(maxSteps - steps, freeFlightSteps(pos, vel));
+		for(int i = 0; i < flight && !stopped; ++i)
 		{
-			// calculate
-			Vector2 normal = Vector2(mBallPosition,	Vector2(NET_POSITION_X, NET_SPHERE_POSITION)).normalise();
-
-			// normal component of kinetic energy
-			float perp_ekin = normal.dotProduct(mBallVelocity);
-			perp_ekin *= perp_ekin;
-			// parallel component of kinetic energy
-			float para_ekin = mBallVelocity.length() * mBallVelocity.length() - perp_ekin;
-
-			// the normal component is damped stronger than the parallel component
-			// the values are ~ 0.85 and ca. 0.95, because speed is sqrt(ekin)
-			perp_ekin *= 0.7;
-			para_ekin *= 0.9;
-
-			float nspeed = sqrt(perp_ekin + para_ekin);
-
-			mBallVelocity = Vector2(mBallVelocity.reflect(normal).normalise().scale(nspeed));
-
-			// pushes the ball out of the net
-			mBallPosition = (Vector2(NET_POSITION_X, NET_SPHERE_POSITION) - normal * (NET_RADIUS + BALL_RADIUS));
+			detail::moveBall(pos, vel);
+			++steps;
+			stopped = stop(pos);
+		}
 
-			mCallback( MatchEvent{MatchEvent::BALL_HIT_NET_TOP, NO_PLAYER, 0} );
+		if(steps < maxSteps && !stopped)
+		{
+			stepBall(pos, vel);
+			++steps;
+			stopped = stop(pos);
 		}
-		// mBallVelocity = mBallVelocity.reflect( Vector2( mBallPosition, Vector2 (NET_POSITION_X, temp) ).normalise()).scale(0.75);
 	}
+	position = pos;
+	velocity = vel;
+	return stopped ? steps : -1;
 }
+
 Vector2 PhysicWorld::getBallPosition() const
 {
 	return mBallPosition;
@@ -408,39 +394,3 @@ void PhysicWorld::setEventCallback( event_callback_fn cb )
 {
 	mCallback = cb;
 }
-
-inline short set_fpu_single_precision()
-{
-	short fl = 0;
-	#if defined(i386) || defined(__x86_64) // We need to set a precision for diverse x86 hardware
-	#if defined(__GNUC__)
-		volatile short cw;
-		asm volatile ("fstcw %0" : "=m"(cw));
-		fl = cw;
-		cw = cw & 0xfcff;
-		asm volatile ("fldcw %0" :: "m"(cw));
-	#elif defined(_MSC_VER)
-		short cw;
-		asm fstcw cw;
-		fl = cw;
-		cw = cw & 0xfcff;
-		asm fldcw cw;
-	#endif
-	#else
-	#warning FPU precision may not conform to IEEE 754
-	#endif
-	return fl;
-}
-
-void reset_fpu_flags(short flags)
-{
-	#if defined(i386) || defined(__x86_64) // We need to set a precision for diverse x86 hardware
-	#if defined(__GNUC__)
-		asm volatile ("fldcw %0" :: "m"(flags));
-	#elif defined(_MSC_VER)
-		asm fldcw flags;
-	#endif
-	#else
-	#warning FPU precision may not conform to IEEE 754
-	#endif
-}
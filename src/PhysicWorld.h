@@ -73,14 +73,21 @@ class PhysicWorld : public ObjectCounter<PhysicWorld>
 		/// this function calculates whether two circles overlap.
 		static bool circleCircleCollision(const Vector2& pos1, float rad_1, const Vector2& pos2, float rad_2);
 
+		// ball prediction
+		/// moves a ball that does not interact with the blobs by \p steps steps. The
+		/// results are exactly what step computes with isBallValid == false, but the
+		/// blobs, the rotation and the events are skipped, which makes it much cheaper.
+		static void simulateBall(Vector2& position, Vector2& velocity, int steps);
+		/// like simulateBall, but stops after the step for which \p stop returns true.
+		/// \return the number of steps done, or -1 if \p stop did not return true within \p maxSteps steps.
+		static int simulateBallUntil(Vector2& position, Vector2& velocity,
+									const std::function<bool(const Vector2&)>& stop, int maxSteps);
+
 	private:
 		// Blobby animation methods
 		void blobbyStartAnimation(PlayerSide player);
 		void blobbyAnimationStep(PlayerSide player);
 
-		inline bool playerTopBallCollision(int player) const;
-		inline bool playerBottomBallCollision(int player) const;
-
 		// Do all blobby-related physic stuff which is independent from states
 		void handleBlob(PlayerSide player, PlayerInput input);
 
@@ -0,0 +1,433 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "PhysicWorldBatch.h"
+
+/* includes */
+#include <cassert>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "PhysicWorld.h"
+#include "FloatDeterminism.h"
+#include "PhysicWorldDetail.h"
+
+/* implementation */
+
+namespace
+{
+	// The kernels are written once against these functions, which work on a pack of
+	// LANES floats. Comparisons return masks, which are used with both, either and select.
+	// Every function is a single IEEE operation, exactly like its scalar counterpart.
+#if defined(__AVX__)
+	typedef __m256 Pack;
+	typedef __m256 Mask;
+	const int LANES = 8;
+
+	inline Pack load(const float* p) { return _mm256_loadu_ps(p); }
+	inline void store(float* p, Pack v) { _mm256_storeu_ps(p, v); }
+	inline Pack set(float v) { return _mm256_set1_ps(v); }
+	inline Pack add(Pack a, Pack b) { return _mm256_add_ps(a, b); }
+	inline Pack sub(Pack a, Pack b) { return _mm256_sub_ps(a, b); }
+	inline Pack mul(Pack a, Pack b) { return _mm256_mul_ps(a, b); }
+	inline Pack div(Pack a, Pack b) { return _mm256_div_ps(a, b); }
+	inline Pack sqrt(Pack a) { return _mm256_sqrt_ps(a); }
+	inline Pack abs(Pack a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a); }
+	inline Mask less(Pack a, Pack b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	inline Mask lessEqual(Pack a, Pack b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+	inline Mask equal(Pack a, Pack b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+	inline Mask both(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+	inline Mask either(Mask a, Mask b) { return _mm256_or_ps(a, b); }
+	inline Mask negate(Mask a) { return _mm256_xor_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(-1))); }
+	inline Pack select(Mask m, Pack a, Pack b) { return _mm256_blendv_ps(b, a, m); }
+	inline int bits(Mask m) { return _mm256_movemask_ps(m); }
+#elif defined(__SSE2__)
+	typedef __m128 Pack;
+	typedef __m128 Mask;
+	const int LANES = 4;
+
+	inline Pack load(const float* p) { return _mm_loadu_ps(p); }
+	inline void store(float* p, Pack v) { _mm_storeu_ps(p, v); }
+	inline Pack set(float v) { return _mm_set1_ps(v); }
+	inline Pack add(Pack a, Pack b) { return _mm_add_ps(a, b); }
+	inline Pack sub(Pack a, Pack b) { return _mm_sub_ps(a, b); }
+	inline Pack mul(Pack a, Pack b) { return _mm_mul_ps(a, b); }
+	inline Pack div(Pack a, Pack b) { return _mm_div_ps(a, b); }
+	inline Pack sqrt(Pack a) { return _mm_sqrt_ps(a); }
+	inline Pack abs(Pack a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a); }
+	inline Mask less(Pack a, Pack b) { return _mm_cmplt_ps(a, b); }
+	inline Mask lessEqual(Pack a, Pack b) { return _mm_cmple_ps(a, b); }
+	inline Mask equal(Pack a, Pack b) { return _mm_cmpeq_ps(a, b); }
+	inline Mask both(Mask a, Mask b) { return _mm_and_ps(a, b); }
+	inline Mask either(Mask a, Mask b) { return _mm_or_ps(a, b); }
+	inline Mask negate(Mask a) { return _mm_xor_ps(a, _mm_castsi128_ps(_mm_set1_epi32(-1))); }
+	inline Pack select(Mask m, Pack a, Pack b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+	inline int bits(Mask m) { return _mm_movemask_ps(m); }
+#else
+	typedef float Pack;
+	typedef bool Mask;
+	const int LANES = 1;
+
+	inline Pack load(const float* p) { return *p; }
+	inline void store(float* p, Pack v) { *p = v; }
+	inline Pack set(float v) { return v; }
+	inline Pack add(Pack a, Pack b) { return a + b; }
+	inline Pack sub(Pack a, Pack b) { return a - b; }
+	inline Pack mul(Pack a, Pack b) { return a * b; }
+	inline Pack div(Pack a, Pack b) { return a / b; }
+	inline Pack sqrt(Pack a) { return std::sqrt(a); }
+	inline Pack abs(Pack a) { return std::fabs(a); }
+	inline Mask less(Pack a, Pack b) { return a < b; }
+	inline Mask lessEqual(Pack a, Pack b) { return a <= b; }
+	inline Mask equal(Pack a, Pack b) { return a == b; }
+	inline Mask both(Mask a, Mask b) { return a && b; }
+	inline Mask either(Mask a, Mask b) { return a || b; }
+	inline Mask negate(Mask a) { return !a; }
+	inline Pack select(Mask m, Pack a, Pack b) { return m ? a : b; }
+	inline int bits(Mask m) { return m; }
+#endif
+
+	inline Mask greater(Pack a, Pack b) { return less(b, a); }
+	inline Mask greaterEqual(Pack a, Pack b) { return lessEqual(b, a); }
+
+	// PhysicWorld::handleBlob, for LANES blobs
+	inline void handleBlobs(Pack& x, Pack& y, Pack& vx, Pack& vy, Pack& state, Pack& speed,
+							Mask up, Mask left, Mask right)
+	{
+		const Pack zero = set(0);
+
+		Mask onGround = greaterEqual(y, set(GROUND_PLANE_HEIGHT));
+		Pack gravity = select(up, set(GRAVITATION - BLOBBY_JUMP_BUFFER), set(GRAVITATION));
+		Mask jump = both(up, onGround);
+		vy = select(jump, set(BLOBBY_JUMP_ACCELERATION), vy);
+		Mask start = either(jump, both(either(left, right), onGround));
+
+		vx = sub(select(right, set(BLOBBY_SPEED), zero), select(left, set(BLOBBY_SPEED), zero));
+
+		// the same operations as Vector2(0, 0.5f * gravity) + velocity
+		x = add(x, add(zero, vx));
+		y = add(y, add(mul(set(0.5f), gravity), vy));
+		vy = add(vy, gravity);
+
+		// Hitting the ground
+		Mask landed = greater(y, set(GROUND_PLANE_HEIGHT));
+		start = either(start, both(landed, greater(vy, set(3.5))));
+		y = select(landed, set(GROUND_PLANE_HEIGHT), y);
+		vy = select(landed, zero, vy);
+
+		// blobbyStartAnimation
+		speed = select(both(start, equal(speed, zero)), set(BLOBBY_ANIMATION_SPEED), speed);
+
+		// blobbyAnimationStep
+		Mask negative = less(state, zero);
+		speed = select(negative, zero, speed);
+		state = select(negative, zero, state);
+		speed = select(greaterEqual(state, set(4.5)), set(-BLOBBY_ANIMATION_SPEED), speed);
+		state = add(state, speed);
+		state = select(greaterEqual(state, set(5)), set(4.99), state);
+	}
+
+	// detail::circleCircleCollision
+	inline Mask circleCollision(Pack ballX, Pack ballY, Pack x, Pack y, float radius)
+	{
+		Pack dx = sub(ballX, x);
+		Pack dy = sub(ballY, y);
+		float mxdist = BALL_RADIUS + radius;
+		return less(add(mul(dx, dx), mul(dy, dy)), set(mxdist * mxdist));
+	}
+
+	// whether detail::blobBallCollision finds a collision
+	inline Mask blobBallCollision(Pack ballX, Pack ballY, Pack x, Pack y)
+	{
+		return either(circleCollision(ballX, ballY, x, add(y, set(BLOBBY_LOWER_SPHERE)), BLOBBY_LOWER_RADIUS),
+						circleCollision(ballX, ballY, x, sub(y, set(BLOBBY_UPPER_SPHERE)), BLOBBY_UPPER_RADIUS));
+	}
+
+	// whether any of the tests in detail::ballWorldCollisions is true
+	inline Mask ballWorldCollision(Pack x, Pack y, Pack vx)
+	{
+		const Pack zero = set(0);
+		Mask ground = greater(add(y, set(BALL_RADIUS)), set(GROUND_PLANE_HEIGHT_MAX));
+		Mask leftWall = both(lessEqual(sub(x, set(BALL_RADIUS)), set(LEFT_PLANE)), less(vx, zero));
+		Mask rightWall = both(greaterEqual(add(x, set(BALL_RADIUS)), set(RIGHT_PLANE)), greater(vx, zero));
+		Pack netDistance = abs(sub(x, set(NET_POSITION_X)));
+		Mask net = both(greater(y, set(NET_SPHERE_POSITION)), less(netDistance, set(BALL_RADIUS + NET_RADIUS)));
+		Mask netTop = both(less(netDistance, set(NET_RADIUS + BALL_RADIUS + 1)),
+							less(abs(sub(y, set(NET_SPHERE_POSITION))), set(NET_RADIUS + BALL_RADIUS + 1)));
+		return either(either(ground, either(leftWall, rightWall)), either(net, netTop));
+	}
+}
+
+PhysicWorldBatch::PhysicWorldBatch()
+{
+}
+
+PhysicWorldBatch::~PhysicWorldBatch()
+{
+}
+
+unsigned int PhysicWorldBatch::addWorld()
+{
+	unsigned int world;
+	if(!mFree.empty())
+	{
+		world = mFree.back();
+		mFree.pop_back();
+	}
+	 else
+	{
+		world = size();
+		resize(world + 1);
+	}
+
+	mActive[world] = true;
+	setState(world, PhysicWorld().getState());
+	for(int player = LEFT_PLAYER; player < MAX_PLAYERS; ++player)
+		mBlobAnimationSpeed[player][world] = 0;
+	setInput(world, PlayerInput(), PlayerInput(), false, false);
+	return world;
+}
+
+void PhysicWorldBatch::removeWorld(unsigned int world)
+{
+	assert(world < size() && mActive[world]);
+	mActive[world] = false;
+	mFree.push_back(world);
+}
+
+unsigned int PhysicWorldBatch::size() const
+{
+	return mActive.size();
+}
+
+unsigned int PhysicWorldBatch::getWorldCount() const
+{
+	return size() - mFree.size();
+}
+
+void PhysicWorldBatch::resize(unsigned int worlds)
+{
+	// pad with new worlds, so the kernels never see uninitialised values
+	PhysicState fresh = PhysicWorld().getState();
+	unsigned int padded = (worlds + LANES - 1) / LANES * LANES;
+	for(int player = LEFT_PLAYER; player < MAX_PLAYERS; ++player)
+	{
+		mBlobX[player].resize(padded, fresh.blobPosition[player].x);
+		mBlobY[player].resize(padded, fresh.blobPosition[player].y);
+		mBlobVelocityX[player].resize(padded, 0);
+		mBlobVelocityY[player].resize(padded, 0);
+		mBlobState[player].resize(padded, 0);
+		mBlobAnimationSpeed[player].resize(padded, 0);
+		mInputUp[player].resize(padded, 0);
+		mInputLeft[player].resize(padded, 0);
+		mInputRight[player].resize(padded, 0);
+	}
+	mBallX.resize(padded, fresh.ballPosition.x);
+	mBallY.resize(padded, fresh.ballPosition.y);
+	mBallVelocityX.resize(padded, 0);
+	mBallVelocityY.resize(padded, 0);
+	mBallRotation.resize(padded, 0);
+	mBallAngularVelocity.resize(padded, fresh.ballAngularVelocity);
+	mBallValid.resize(padded, 0);
+	mGameRunning.resize(padded, 0);
+
+	mActive.resize(worlds, false);
+}
+
+void PhysicWorldBatch::setInput(unsigned int world, const PlayerInput& left, const PlayerInput& right,
+								bool isBallValid, bool isGameRunning)
+{
+	const PlayerInput input[MAX_PLAYERS] = {left, right};
+	for(int player = LEFT_PLAYER; player < MAX_PLAYERS; ++player)
+	{
+		mInputUp[player][world] = input[player].up;
+		mInputLeft[player][world] = input[player].left;
+		mInputRight[player][world] = input[player].right;
+	}
+	mBallValid[world] = isBallValid;
+	mGameRunning[world] = isGameRunning;
+}
+
+const std::vector<PhysicWorldBatch::Event>& PhysicWorldBatch::getEvents() const
+{
+	return mEvents;
+}
+
+PhysicState PhysicWorldBatch::getState(unsigned int world) const
+{
+	PhysicState state;
+	for(int player = LEFT_PLAYER; player < MAX_PLAYERS; ++player)
+	{
+		state.blobPosition[player] = Vector2(mBlobX[player][world], mBlobY[player][world]);
+		state.blobVelocity[player] = Vector2(mBlobVelocityX[player][world], mBlobVelocityY[player][world]);
+		state.blobState[player] = mBlobState[player][world];
+	}
+	state.ballPosition = Vector2(mBallX[world], mBallY[world]);
+	state.ballVelocity = Vector2(mBallVelocityX[world], mBallVelocityY[world]);
+	state.ballRotation = mBallRotation[world];
+	state.ballAngularVelocity = mBallAngularVelocity[world];
+	return state;
+}
+
+void PhysicWorldBatch::setState(unsigned int world, const PhysicState& state)
+{
+	// like PhysicWorld::setState, this keeps the animation speed of the blobs
+	for(int player = LEFT_PLAYER; player < MAX_PLAYERS; ++player)
+	{
+		mBlobX[player][world] = state.blobPosition[player].x;
+		mBlobY[player][world] = state.blobPosition[player].y;
+		mBlobVelocityX[player][world] = state.blobVelocity[player].x;
+		mBlobVelocityY[player][world] = state.blobVelocity[player].y;
+		mBlobState[player][world] = state.blobState[player];
+	}
+	mBallX[world] = state.ballPosition.x;
+	mBallY[world] = state.ballPosition.y;
+	mBallVelocityX[world] = state.ballVelocity.x;
+	mBallVelocityY[world] = state.ballVelocity.y;
+	mBallRotation[world] = state.ballRotation;
+	mBallAngularVelocity[world] = state.ballAngularVelocity;
+}
+
+int PhysicWorldBatch::getLaneCount()
+{
+	return LANES;
+}
+
+void PhysicWorldBatch::step()
+{
+	ScopedFloatPrecision precision;
+	mEvents.clear();
+
+	const Pack zero = set(0);
+	for(unsigned int i = 0; i < size(); i += LANES)
+	{
+		// blobs
+		Pack blobX[MAX_PLAYERS];
+		Pack blobY[MAX_PLAYERS];
+		for(int player = LEFT_PLAYER; player < MAX_PLAYERS; ++player)
+		{
+			blobX[player] = load(&mBlobX[player][i]);
+			blobY[player] = load(&mBlobY[player][i]);
+			Pack vx = load(&mBlobVelocityX[player][i]);
+			Pack vy = load(&mBlobVelocityY[player][i]);
+			Pack state = load(&mBlobState[player][i]);
+			Pack speed = load(&mBlobAnimationSpeed[player][i]);
+
+			handleBlobs(blobX[player], blobY[player], vx, vy, state, speed,
+						greater(load(&mInputUp[player][i]), zero),
+						greater(load(&mInputLeft[player][i]), zero),
+						greater(load(&mInputRight[player][i]), zero));
+
+			store(&mBlobX[player][i], blobX[player]);
+			store(&mBlobY[player][i], blobY[player]);
+			store(&mBlobVelocityX[player][i], vx);
+			store(&mBlobVelocityY[player][i], vy);
+			store(&mBlobState[player][i], state);
+			store(&mBlobAnimationSpeed[player][i], speed);
+		}
+
+		// ball movement, same operations as detail::moveBall
+		Mask running = greater(load(&mGameRunning[i]), zero);
+		Pack ballX = load(&mBallX[i]);
+		Pack ballY = load(&mBallY[i]);
+		Pack ballVX = load(&mBallVelocityX[i]);
+		Pack ballVY = load(&mBallVelocityY[i]);
+		ballX = select(running, add(ballX, add(zero, ballVX)), ballX);
+		ballY = select(running, add(ballY, add(set(0.5f * BALL_GRAVITATION), ballVY)), ballY);
+		ballVY = select(running, add(ballVY, set(BALL_GRAVITATION)), ballVY);
+		store(&mBallX[i], ballX);
+		store(&mBallY[i], ballY);
+		store(&mBallVelocityY[i], ballVY);
+
+		// find the worlds with collisions. If the ball hits the left blob, the right blob
+		// is tested with the new ball position by handleCollisions.
+		Mask blobHit = both(greater(load(&mBallValid[i]), zero),
+							either(blobBallCollision(ballX, ballY, blobX[LEFT_PLAYER], blobY[LEFT_PLAYER]),
+									blobBallCollision(ballX, ballY, blobX[RIGHT_PLAYER], blobY[RIGHT_PLAYER])));
+		int collisions = bits(either(blobHit, ballWorldCollision(ballX, ballY, ballVX)));
+		for(int lane = 0; collisions != 0; ++lane, collisions >>= 1)
+		{
+			if((collisions & 1) && i + lane < size() && mActive[i + lane])
+				handleCollisions(i + lane);
+		}
+
+		// Collision between blobby and the net
+		Pack left = load(&mBlobX[LEFT_PLAYER][i]);
+		left = select(greater(add(left, set(BLOBBY_LOWER_RADIUS)), set(NET_POSITION_X - NET_RADIUS)),
+						set(NET_POSITION_X - NET_RADIUS - BLOBBY_LOWER_RADIUS), left);
+		Pack right = load(&mBlobX[RIGHT_PLAYER][i]);
+		right = select(less(sub(right, set(BLOBBY_LOWER_RADIUS)), set(NET_POSITION_X + NET_RADIUS)),
+						set(NET_POSITION_X + NET_RADIUS + BLOBBY_LOWER_RADIUS), right);
+
+		// Collision between blobby and the border
+		left = select(less(left, set(LEFT_PLANE)), set(LEFT_PLANE), left);
+		right = select(greater(right, set(RIGHT_PLANE)), set(RIGHT_PLANE), right);
+		store(&mBlobX[LEFT_PLAYER][i], left);
+		store(&mBlobX[RIGHT_PLAYER][i], right);
+
+		// Velocity Integration
+		ballVX = load(&mBallVelocityX[i]);
+		ballVY = load(&mBallVelocityY[i]);
+		Pack rotation = load(&mBallRotation[i]);
+		Pack angular = load(&mBallAngularVelocity[i]);
+		Pack turn = mul(angular, div(sqrt(add(mul(ballVX, ballVX), mul(ballVY, ballVY))), set(6)));
+		rotation = select(negate(running), sub(rotation, angular),
+							select(greater(ballVX, zero), add(rotation, turn), sub(rotation, turn)));
+
+		// Overflow-Protection
+		Mask low = lessEqual(rotation, zero);
+		Mask high = greaterEqual(rotation, set(6.25));
+		rotation = select(low, add(set(6.25), rotation), select(high, sub(rotation, set(6.25)), rotation));
+		store(&mBallRotation[i], rotation);
+	}
+}
+
+void PhysicWorldBatch::handleCollisions(unsigned int world)
+{
+	Vector2 position(mBallX[world], mBallY[world]);
+	Vector2 velocity(mBallVelocityX[world], mBallVelocityY[world]);
+
+	if(mBallValid[world] > 0)
+	{
+		for(int player = LEFT_PLAYER; player < MAX_PLAYERS; ++player)
+		{
+			Vector2 blobPosition(mBlobX[player][world], mBlobY[player][world]);
+			Vector2 blobVelocity(mBlobVelocityX[player][world], mBlobVelocityY[player][world]);
+			float intensity;
+			if(detail::blobBallCollision(position, velocity, blobPosition, blobVelocity, intensity))
+				mEvents.push_back( Event{world, MatchEvent{MatchEvent::BALL_HIT_BLOB, (PlayerSide)player, intensity}} );
+		}
+	}
+
+	detail::ballWorldCollisions(position, velocity, [this, world](const MatchEvent& event)
+	{
+		mEvents.push_back( Event{world, event} );
+	});
+
+	mBallX[world] = position.x;
+	mBallY[world] = position.y;
+	mBallVelocityX[world] = velocity.x;
+	mBallVelocityY[world] = velocity.y;
+}
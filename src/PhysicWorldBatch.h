@@ -0,0 +1,108 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <vector>
+
+#include "Global.h"
+#include "PlayerInput.h"
+#include "PhysicState.h"
+#include "MatchEvents.h"
+#include "BlobbyDebug.h"
+
+/*! \class PhysicWorldBatch
+	\brief steps the physics of many matches at once
+	\details The blobs and balls of all worlds are stored as structure of arrays, and each
+			step advances them with SIMD kernels: AVX if the compiler targets it, SSE2 on
+			every x86-64, and plain scalar code otherwise. The kernels move blobs and balls
+			and test for all collisions. Only the worlds in which the ball actually hits a
+			blob, a wall, the ground or the net handle that collision, and they do it with
+			exactly the code PhysicWorld uses. All floating point operations are the same
+			as in PhysicWorld::step, so each world gives bit-identical results.
+			The events of a step are collected in one array, ordered by world.
+			World indices stay valid until the world is removed, and removed
+			slots are reused by addWorld.
+*/
+class PhysicWorldBatch : public ObjectCounter<PhysicWorldBatch>
+{
+	public:
+		struct Event
+		{
+			unsigned int world;
+			MatchEvent event;
+		};
+
+		PhysicWorldBatch();
+		~PhysicWorldBatch();
+
+		/// adds a world, which starts like a new PhysicWorld, and returns its index.
+		unsigned int addWorld();
+		void removeWorld(unsigned int world);
+		/// number of worlds, including removed slots
+		unsigned int size() const;
+		/// number of worlds that were added and not removed
+		unsigned int getWorldCount() const;
+
+		/// sets the input and the game state flags used by the next steps of \p world
+		void setInput(unsigned int world, const PlayerInput& left, const PlayerInput& right,
+						bool isBallValid, bool isGameRunning);
+
+		/// steps all worlds, like PhysicWorld::step
+		void step();
+
+		/// events of the last step, ordered by world
+		const std::vector<Event>& getEvents() const;
+
+		PhysicState getState(unsigned int world) const;
+		void setState(unsigned int world, const PhysicState& state);
+
+		/// number of worlds a kernel processes at once
+		static int getLaneCount();
+
+	private:
+		void resize(unsigned int worlds);
+		void handleCollisions(unsigned int world);
+
+		// one entry per world, padded to a multiple of the lane count
+		std::vector<float> mBlobX[MAX_PLAYERS];
+		std::vector<float> mBlobY[MAX_PLAYERS];
+		std::vector<float> mBlobVelocityX[MAX_PLAYERS];
+		std::vector<float> mBlobVelocityY[MAX_PLAYERS];
+		std::vector<float> mBlobState[MAX_PLAYERS];
+		std::vector<float> mBlobAnimationSpeed[MAX_PLAYERS];
+		std::vector<float> mBallX;
+		std::vector<float> mBallY;
+		std::vector<float> mBallVelocityX;
+		std::vector<float> mBallVelocityY;
+		std::vector<float> mBallRotation;
+		std::vector<float> mBallAngularVelocity;
+
+		// input and flags, 1 for pressed/true and 0 otherwise
+		std::vector<float> mInputUp[MAX_PLAYERS];
+		std::vector<float> mInputLeft[MAX_PLAYERS];
+		std::vector<float> mInputRight[MAX_PLAYERS];
+		std::vector<float> mBallValid;
+		std::vector<float> mGameRunning;
+
+		std::vector<bool> mActive;
+		std::vector<unsigned int> mFree;
+		std::vector<Event> mEvents;
+};
@@ -0,0 +1,178 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+/** \file PhysicWorldDetail.h
+
+	The parts of PhysicWorld::step that are shared with the ball prediction and with
+	PhysicWorldBatch. Everything that has to give bit-identical results in all of them
+	is computed here, so there is only one implementation of it.
+*/
+
+#include <cmath>
+
+#include "Vector.h"
+#include "GameConstants.h"
+#include "MatchEvents.h"
+
+// Gamefeeling relevant constants:
+const float BLOBBY_ANIMATION_SPEED = 0.5;
+
+namespace detail
+{
+	/// this function calculates whether two circles overlap.
+	inline bool circleCircleCollision(const Vector2& pos1, float rad1, const Vector2& pos2, float rad2)
+	{
+		Vector2 distance = pos1 - pos2;
+		float mxdist = rad1 + rad2;
+		return distance.lengthSQ() < mxdist * mxdist;
+	}
+
+	inline bool blobTopBallCollision(const Vector2& ballPosition, const Vector2& blobPosition)
+	{
+		Vector2 blobpos{blobPosition.x, blobPosition.y - BLOBBY_UPPER_SPHERE};
+		return circleCircleCollision( ballPosition, BALL_RADIUS, blobpos, BLOBBY_UPPER_RADIUS );
+	}
+
+	inline bool blobBottomBallCollision(const Vector2& ballPosition, const Vector2& blobPosition)
+	{
+		Vector2 blobpos{blobPosition.x, blobPosition.y + BLOBBY_LOWER_SPHERE};
+		return circleCircleCollision( ballPosition, BALL_RADIUS, blobpos, BLOBBY_LOWER_RADIUS );
+	}
+
+	/// Detects and handles a collision of the ball with a blob. Returns true, and sets
+	/// \p intensity to the hit intensity, if there was a collision.
+	inline bool blobBallCollision(Vector2& ballPosition, Vector2& ballVelocity,
+								const Vector2& blobPosition, const Vector2& blobVelocity, float& intensity)
+	{
+		Vector2 circlepos = blobPosition;
+		// check for impact
+		if(blobBottomBallCollision(ballPosition, blobPosition))
+		{
+			circlepos.y += BLOBBY_LOWER_SPHERE;
+		}
+		 else if(blobTopBallCollision(ballPosition, blobPosition))
+		{
+			circlepos.y -= BLOBBY_LOWER_SPHERE;
+		} else
+		{	// no impact!
+			return false;
+		}
+
+		// ok, if we get here, there actually was a collision
+
+		// calculate hit intensity
+		intensity = Vector2(ballVelocity, blobVelocity).length() / 25.0;
+		intensity = intensity > 1.0 ? 1.0 : intensity;
+
+		// set ball velocity
+		ballVelocity = -Vector2(ballPosition, circlepos);
+		ballVelocity = ballVelocity.normalise();
+		ballVelocity = ballVelocity.scale(BALL_COLLISION_VELOCITY);
+		ballPosition += ballVelocity;
+		return true;
+	}
+
+	// The collisions of the ball with ground, walls and net. This is shared by step,
+	// the ball prediction and the batch, so all compute exactly the same trajectories.
+	template<class Callback>
+	inline void ballWorldCollisions(Vector2& position, Vector2& velocity, Callback&& callback)
+	{
+		// Ball to ground Collision
+		if (position.y + BALL_RADIUS > GROUND_PLANE_HEIGHT_MAX)
+		{
+			velocity = velocity.reflectY();
+			velocity = velocity.scale(0.95);
+			position.y = GROUND_PLANE_HEIGHT_MAX - BALL_RADIUS;
+			callback( MatchEvent{MatchEvent::BALL_HIT_GROUND, position.x > NET_POSITION_X ? RIGHT_PLAYER : LEFT_PLAYER, 0} );
+		}
+
+		// Border Collision
+		if (position.x - BALL_RADIUS <= LEFT_PLANE && velocity.x < 0.0)
+		{
+			velocity = velocity.reflectX();
+			// set the ball's position
+			position.x = LEFT_PLANE + BALL_RADIUS;
+			callback( MatchEvent{MatchEvent::BALL_HIT_WALL, LEFT_PLAYER, 0} );
+		}
+		else if (position.x + BALL_RADIUS >= RIGHT_PLANE && velocity.x > 0.0)
+		{
+			velocity = velocity.reflectX();
+			// set the ball's position
+			position.x = RIGHT_PLANE - BALL_RADIUS;
+			callback( MatchEvent{MatchEvent::BALL_HIT_WALL, RIGHT_PLAYER, 0} );
+		}
+		else if (position.y > NET_SPHERE_POSITION &&
+				fabs(position.x - NET_POSITION_X) < BALL_RADIUS + NET_RADIUS)
+		{
+			bool right = position.x - NET_POSITION_X > 0;
+			velocity = velocity.reflectX();
+			// set the ball's position so that it touches the net
+			position.x = NET_POSITION_X + (right ? (BALL_RADIUS + NET_RADIUS) : (-BALL_RADIUS - NET_RADIUS));
+
+			callback( MatchEvent{MatchEvent::BALL_HIT_NET, right ? RIGHT_PLAYER : LEFT_PLAYER, 0} );
+		}
+		// Net Collisions
+		// the ball can only touch the net sphere if it is inside its bounding box. The box
+		// is a bit larger than necessary, so the exact test below decides in all border cases.
+		else if (fabs(position.x - NET_POSITION_X) < NET_RADIUS + BALL_RADIUS + 1 &&
+				fabs(position.y - NET_SPHERE_POSITION) < NET_RADIUS + BALL_RADIUS + 1)
+		{
+			float ballNetDistance = Vector2(position, Vector2(NET_POSITION_X, NET_SPHERE_POSITION)).length();
+
+			if (ballNetDistance < NET_RADIUS + BALL_RADIUS)
+			{
+				// calculate
+				Vector2 normal = Vector2(position,	Vector2(NET_POSITION_X, NET_SPHERE_POSITION)).normalise();
+
+				// normal component of kinetic energy
+				float perp_ekin = normal.dotProduct(velocity);
+				perp_ekin *= perp_ekin;
+				// parallel component of kinetic energy
+				float para_ekin = velocity.length() * velocity.length() - perp_ekin;
+
+				// the normal component is damped stronger than the parallel component
+				// the values are ~ 0.85 and ca. 0.95, because speed is sqrt(ekin)
+				perp_ekin *= 0.7;
+				para_ekin *= 0.9;
+
+				float nspeed = sqrt(perp_ekin + para_ekin);
+
+				velocity = Vector2(velocity.reflect(normal).normalise().scale(nspeed));
+
+				// pushes the ball out of the net
+				position = (Vector2(NET_POSITION_X, NET_SPHERE_POSITION) - normal * (NET_RADIUS + BALL_RADIUS));
+
+				callback( MatchEvent{MatchEvent::BALL_HIT_NET_TOP, NO_PLAYER, 0} );
+			}
+		}
+	}
+
+	// moves the ball in flight, exactly as step does
+	inline void moveBall(Vector2& position, Vector2& velocity)
+	{
+		// dt = 1 !!
+		// move ball ds = a/2 * dt^2 + v * dt
+		position += Vector2(0, 0.5f * BALL_GRAVITATION) + velocity;
+		// dv = a*dt
+		velocity.y += BALL_GRAVITATION;
+	}
+}
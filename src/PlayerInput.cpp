@@ -124,6 +124,16 @@ void PlayerInputAbs::swapSides()
 	mTarget = RIGHT_PLANE - mTarget;
 }
 
+bool PlayerInputAbs::isRelative() const
+{
+	return mFlags & F_RELATIVE;
+}
+
+bool PlayerInputAbs::operator==(const PlayerInputAbs& other) const
+{
+	return mFlags == other.mFlags && mTarget == other.mTarget;
+}
+
 PlayerInput PlayerInputAbs::toPlayerInput( const DuelMatch* match ) const
 {
 	if( mFlags & F_RELATIVE)
@@ -78,6 +78,11 @@ class PlayerInputAbs
 
 		void swapSides();
 
+		/// relative inputs are simple key presses, absolute inputs set a target position
+		bool isRelative() const;
+
+		bool operator==(const PlayerInputAbs& other) const;
+
 		// we need some way of getting information about the game, for which we use the match
 		// currently.
 		PlayerInput toPlayerInput( const DuelMatch* match ) const;
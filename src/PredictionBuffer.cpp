@@ -0,0 +1,144 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "PredictionBuffer.h"
+
+/* includes */
+#include <cmath>
+
+#include "DuelMatch.h"
+#include "InputSource.h"
+
+/* implementation */
+
+namespace
+{
+	// larger than the error of quantized snapshots
+	const float PREDICTION_TOLERANCE = 1.f / 32;
+
+	bool near(float a, float b)
+	{
+		return std::abs(a - b) <= PREDICTION_TOLERANCE;
+	}
+
+	bool near(const Vector2& a, const Vector2& b)
+	{
+		return near(a.x, b.x) && near(a.y, b.y);
+	}
+}
+
+PredictionBuffer::PredictionBuffer()
+{
+	clear();
+}
+
+void PredictionBuffer::store(unsigned int tick, const PlayerInputAbs& input, const DuelMatchState& state)
+{
+	Frame& frame = mFrames[tick % SIZE];
+	frame.valid = true;
+	frame.tick = tick;
+	frame.input = input;
+	frame.state = state;
+}
+
+const PlayerInputAbs* PredictionBuffer::findInput(unsigned int tick) const
+{
+	const Frame& frame = mFrames[tick % SIZE];
+	if(frame.valid && frame.tick == tick)
+		return &frame.input;
+	return 0;
+}
+
+const DuelMatchState* PredictionBuffer::findState(unsigned int tick) const
+{
+	const Frame& frame = mFrames[tick % SIZE];
+	if(frame.valid && frame.tick == tick)
+		return &frame.state;
+	return 0;
+}
+
+bool PredictionBuffer::checkHash(unsigned int serverTick, const DuelMatchState& serverState, std::uint64_t serverHash) const
+{
+	const DuelMatchState* predicted = findState(serverTick);
+	if(!predicted)
+		return true;
+
+	for(int i = 0; i < MAX_PLAYERS; ++i)
+	{
+		if(!(predicted->playerInput[i] == serverState.playerInput[i]))
+			return true;
+	}
+
+	return predicted->hash() == serverHash;
+}
+
+void PredictionBuffer::clear()
+{
+	for(auto& frame : mFrames)
+		frame.valid = false;
+}
+
+bool PredictionBuffer::reconcile(DuelMatch& match, PlayerSide side, unsigned int serverTick,
+								const DuelMatchState& serverState, unsigned int currentTick, bool exact)
+{
+	// if we predicted what the server calculated, there is nothing to correct
+	const DuelMatchState* predicted = findState(serverTick);
+	if(predicted && predictionMatches(*predicted, serverState) && (!exact || predicted->hash() == serverState.hash()))
+		return false;
+
+	// rewind to the server state and simulate the inputs the server has not seen yet
+	match.setState(serverState);
+	for(unsigned int tick = serverTick + 1; (int)(currentTick - tick) > 0; ++tick)
+	{
+		const PlayerInputAbs* input = findInput(tick);
+		if(!input)
+			break;
+
+		match.getInputSource(side)->setInput(*input);
+		match.resimulateStep();
+		store(tick, *input, match.getState());
+	}
+	return true;
+}
+
+bool predictionMatches(const DuelMatchState& predicted, const DuelMatchState& authoritative)
+{
+	const PhysicState& p = predicted.worldState;
+	const PhysicState& a = authoritative.worldState;
+	for(int i = 0; i < MAX_PLAYERS; ++i)
+	{
+		if(!near(p.blobPosition[i], a.blobPosition[i]) || !near(p.blobVelocity[i], a.blobVelocity[i]))
+			return false;
+		if(!(predicted.playerInput[i] == authoritative.playerInput[i]))
+			return false;
+	}
+	if(!near(p.ballPosition, a.ballPosition) || !near(p.ballVelocity, a.ballVelocity) ||
+		!near(p.ballAngularVelocity, a.ballAngularVelocity))
+		return false;
+
+	const GameLogicState& pl = predicted.logicState;
+	const GameLogicState& al = authoritative.logicState;
+	return pl.leftScore == al.leftScore && pl.rightScore == al.rightScore &&
+			pl.hitCount[LEFT_PLAYER] == al.hitCount[LEFT_PLAYER] &&
+			pl.hitCount[RIGHT_PLAYER] == al.hitCount[RIGHT_PLAYER] &&
+			pl.servingPlayer == al.servingPlayer &&
+			pl.isGameRunning == al.isGameRunning && pl.isBallValid == al.isBallValid;
+}
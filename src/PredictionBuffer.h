@@ -0,0 +1,84 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include "DuelMatchState.h"
+#include "PlayerInput.h"
+#include "BlobbyDebug.h"
+
+class DuelMatch;
+
+/*! \class PredictionBuffer
+	\brief local inputs and predicted states of the last frames, indexed by input tick
+	\details The network client simulates its own input immediately. When the server
+			state for an input tick arrives, the client compares it with the state it
+			predicted for that tick. If they differ, it rewinds to the server state and
+			simulates the inputs the server has not seen yet again, which are taken
+			from this buffer.
+*/
+class PredictionBuffer : public ObjectCounter<PredictionBuffer>
+{
+	public:
+		PredictionBuffer();
+
+		/// remembers the input of tick \p tick and the state after simulating it
+		void store(unsigned int tick, const PlayerInputAbs& input, const DuelMatchState& state);
+
+		/// returns NULL if \p tick is no longer (or was never) in the buffer
+		const PlayerInputAbs* findInput(unsigned int tick) const;
+		const DuelMatchState* findState(unsigned int tick) const;
+
+		void clear();
+
+		/// corrects the prediction of \p match with \p serverState, the state the server calculated
+		/// after the input of tick \p serverTick. If the state predicted for that tick does not agree
+		/// with it, \p match is rewound to \p serverState, and the stored inputs of \p side for the
+		/// ticks after \p serverTick and before \p currentTick are simulated again.
+		/// If \p exact is set, \p serverState is not quantized, and differences within the
+		/// precision of the network encoding are corrected as well, so the prediction stays
+		/// bitwise identical to the server's simulation.
+		/// \return false, if the prediction was correct and \p match has not been changed.
+		bool reconcile(DuelMatch& match, PlayerSide side, unsigned int serverTick,
+						const DuelMatchState& serverState, unsigned int currentTick, bool exact = false);
+
+		/// compares the hash of the state predicted for tick \p serverTick with \p serverHash,
+		/// the hash of \p serverState. If the inputs of a player were guessed wrong, the states
+		/// are expected to differ, so they are not compared.
+		/// \return false, if the hashes differ.
+		bool checkHash(unsigned int serverTick, const DuelMatchState& serverState, std::uint64_t serverHash) const;
+
+		static const int SIZE = 128;
+
+	private:
+		struct Frame
+		{
+			bool valid;
+			unsigned int tick;
+			PlayerInputAbs input;
+			DuelMatchState state;
+		};
+
+		Frame mFrames[SIZE];
+};
+
+/// checks whether a predicted state agrees with the state calculated by the server, within the
+///	precision of the network encoding.
+bool predictionMatches(const DuelMatchState& predicted, const DuelMatchState& authoritative);
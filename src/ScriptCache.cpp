@@ -0,0 +1,120 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "ScriptCache.h"
+
+/* includes */
+#include <map>
+#include <mutex>
+
+extern "C"
+{
+#include "lua/lua.h"
+#include "lua/lauxlib.h"
+}
+
+#include "Crc32.h"
+#include "FileRead.h"
+
+/* implementation */
+
+namespace
+{
+	std::mutex cacheMutex;
+	std::map<std::string, boost::shared_ptr<const CachedScript>> cache;
+
+	int writeChunk(lua_State* state, const void* data, size_t size, void* target)
+	{
+		static_cast<std::string*>(target)->append(static_cast<const char*>(data), size);
+		return 0;
+	}
+}
+
+boost::shared_ptr<const CachedScript> ScriptCache::get(const std::string& name)
+{
+	std::string filename = FileRead::makeLuaFilename(name);
+
+	// the lock is only held to look up and store the script, never while reading or compiling
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		auto cached = cache.find(filename);
+		if(cached != cache.end())
+			return cached->second;
+	}
+
+	FileRead file(filename);
+	std::string source(file.length(), '\0');
+	if(!source.empty())
+		file.readRawBytes(&source[0], source.size());
+	file.close();
+
+	boost::shared_ptr<const CachedScript> script = compile(filename, source);
+
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	cache[filename] = script;
+	return script;
+}
+
+int ScriptCache::load(lua_State* state, const CachedScript& script)
+{
+	if(script.bytecode.empty())
+	{
+		lua_pushstring(state, script.error.c_str());
+		return LUA_ERRSYNTAX;
+	}
+
+	return luaL_loadbufferx(state, script.bytecode.data(), script.bytecode.size(), script.filename.c_str(), "b");
+}
+
+boost::shared_ptr<CachedScript> ScriptCache::compile(const std::string& filename, const std::string& source)
+{
+	boost::shared_ptr<CachedScript> script(new CachedScript);
+	script->filename = filename;
+	script->source = source;
+	script->checksum = legacyChecksum(source.data(), source.size());
+
+	lua_State* state = luaL_newstate();
+	if(luaL_loadbufferx(state, source.data(), source.size(), filename.c_str(), "t") == LUA_OK)
+	{
+		lua_dump(state, writeChunk, &script->bytecode);
+	}
+	 else
+	{
+		script->error = lua_tostring(state, -1);
+	}
+	lua_close(state);
+
+	return script;
+}
+
+void ScriptCache::invalidate(const std::string& name)
+{
+	std::string filename = FileRead::makeLuaFilename(name);
+
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	cache.erase(filename);
+}
+
+void ScriptCache::clear()
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	cache.clear();
+}
@@ -0,0 +1,81 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <string>
+#include <inttypes.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include "BlobbyDebug.h"
+
+struct lua_State;
+
+/*! \struct CachedScript
+	\brief a lua script file, loaded and compiled once
+	\details Cached scripts are immutable, so they can be shared between all games
+			and threads that use the same file.
+*/
+struct CachedScript : public ObjectCounter<CachedScript>
+{
+	/// name of the file, as used for lua error messages
+	std::string filename;
+	/// contents of the file
+	std::string source;
+	/// checksum of the file for the network protocol, see legacyChecksum
+	uint32_t checksum;
+	/// compiled chunk, as written by lua_dump. Empty if the script does not compile.
+	std::string bytecode;
+	/// the error message of the lua compiler, if the script does not compile
+	std::string error;
+};
+
+/*! \class ScriptCache
+	\brief process wide cache of lua scripts
+	\details Every game loads the api scripts and its rules script into a new lua state.
+			The cache compiles each file only once and hands out the shared precompiled
+			chunk, so starting a game does not run the lua parser, and a cached script is
+			returned without reading the file. Code that writes or replaces a script file
+			(e.g. rules received from a server) has to call invalidate afterwards.
+			All functions can be called from any thread.
+*/
+class ScriptCache
+{
+	public:
+		/// returns the script \p filename, ".lua" is appended if necessary.
+		/// \throw FileLoadException if the file could not be read
+		static boost::shared_ptr<const CachedScript> get(const std::string& filename);
+
+		/// loads the compiled chunk of \p script as a function onto the stack of \p state.
+		/// \return the result of lua_load, if the script does not compile, the error message
+		///			is pushed instead.
+		static int load(lua_State* state, const CachedScript& script);
+
+		/// creates a cached script from \p source, without adding it to the cache.
+		static boost::shared_ptr<CachedScript> compile(const std::string& filename, const std::string& source);
+
+		/// removes the script \p filename from the cache, so the next call to get reads
+		/// the file again. ".lua" is appended if necessary.
+		static void invalidate(const std::string& filename);
+
+		/// removes all scripts from the cache
+		static void clear();
+};
@@ -0,0 +1,36 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <chrono>
+
+/*! \class ScriptTime
+	\brief time the current thread spent in lua scripts
+	\details The script handlers are called from deep within DuelMatch::step, so they
+			just add up their time here, and the caller collects it after the step.
+*/
+class ScriptTime
+{
+	public:
+		static void add(std::chrono::steady_clock::duration duration);
+		/// returns the time spent since the last call and resets it
+		static std::chrono::steady_clock::duration take();
+};
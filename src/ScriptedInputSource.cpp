@@ -26,8 +26,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <algorithm>
 #include <iostream>
 
-#include <SDL2/SDL.h>
-
 extern "C"
 {
 #include "lua/lua.h"
@@ -37,19 +35,79 @@ extern "C"
 
 #include "DuelMatch.h"
 #include "IUserConfigReader.h"
+#include "LuaStatePool.h"
+#include "TimeSource.h"
 
 /* implementation */
 
+namespace
+{
+	const char* const RANDOM_ENGINE = "__C++_BotRandom__";
+
+	std::default_random_engine& getRandomEngine(lua_State* state)
+	{
+		lua_pushstring(state, RANDOM_ENGINE);
+		lua_gettable(state, LUA_REGISTRYINDEX);
+		void* engine = lua_touserdata(state, -1);
+		lua_pop(state, 1);
+		if(!engine)
+			luaL_error(state, "no random engine set");
+		return *(std::default_random_engine*)engine;
+	}
+
+	// replacement of math.random, which draws from the random engine of the bot instead of
+	// the global rand(). So the bots of a match do not influence each other, and a bot
+	// makes the same decisions, regardless of what else runs in the program.
+	// Arguments and results are the same as in the lua math library.
+	int lua_random(lua_State* state)
+	{
+		double r = std::uniform_real_distribution<double>(0, 1)(getRandomEngine(state));
+		switch (lua_gettop(state))
+		{
+			case 0:
+				lua_pushnumber(state, r);
+				break;
+			case 1:
+			{
+				lua_Number u = luaL_checknumber(state, 1);
+				luaL_argcheck(state, 1 <= u, 1, "interval is empty");
+				lua_pushnumber(state, std::floor(r * u) + 1);
+				break;
+			}
+			case 2:
+			{
+				lua_Number l = luaL_checknumber(state, 1);
+				lua_Number u = luaL_checknumber(state, 2);
+				luaL_argcheck(state, l <= u, 2, "interval is empty");
+				lua_pushnumber(state, std::floor(r * (u - l + 1)) + l);
+				break;
+			}
+			default:
+				return luaL_error(state, "wrong number of arguments");
+		}
+		return 1;
+	}
+
+	int lua_randomseed(lua_State* state)
+	{
+		getRandomEngine(state).seed(luaL_checkunsigned(state, 1));
+		return 0;
+	}
+}
+
 ScriptedInputSource::ScriptedInputSource(const std::string& filename, PlayerSide playerside, unsigned int difficulty)
-: mDifficulty(difficulty)
+: IScriptableComponent( getStatePool() )
+, mDifficulty(difficulty)
 , mSide(playerside)
 , mDelayDistribution( difficulty/3, difficulty/2 )
+// bots should not play the same way in every game. Use seedRandom for reproducible games.
+, mRandom( std::random_device()() )
 {
-	mStartTime = SDL_GetTicks();
+	mStartTime = TimeSource::ticks();
 
-	// set game constants
-	setGameConstants();
-	setGameFunctions();
+	lua_pushstring(mState, RANDOM_ENGINE);
+	lua_pushlightuserdata(mState, &mRandom);
+	lua_settable(mState, LUA_REGISTRYINDEX);
 
 	// push infos into script
 	lua_pushnumber(mState, mDifficulty / 25.0);
@@ -61,13 +119,13 @@ ScriptedInputSource::ScriptedInputSource(const std::string& filename, PlayerSide
 	lua_pushinteger(mState, mSide);
 	lua_setglobal(mState, "__SIDE");
 
-	openScript("api");
+	// bot_api depends on the globals set above, so only api is run by the pool
 	openScript("bot_api");
 	openScript(filename);
 
 	// check whether all required lua functions are available
-	bool step = getLuaFunction("__OnStep");
-	if (!step)
+	mStepFunction = getLuaFunctionRef("__OnStep");
+	if (mStepFunction == LUA_NOREF)
 	{
 		std::string error_message = "Missing bot functions, check bot_api.lua! ";
 		std::cerr << "Lua Error: " << error_message << std::endl;
@@ -83,18 +141,38 @@ ScriptedInputSource::ScriptedInputSource(const std::string& filename, PlayerSide
 
 ScriptedInputSource::~ScriptedInputSource()
 {
+	// the state is reused by other bots
+	lua_pushstring(mState, RANDOM_ENGINE);
+	lua_pushnil(mState);
+	lua_settable(mState, LUA_REGISTRYINDEX);
+}
+
+LuaStatePool& ScriptedInputSource::getStatePool()
+{
+	static LuaStatePool pool([](lua_State* state)
+		{
+			initState(state);
+
+			lua_getglobal(state, "math");
+			lua_pushcfunction(state, lua_random);
+			lua_setfield(state, -2, "random");
+			lua_pushcfunction(state, lua_randomseed);
+			lua_setfield(state, -2, "randomseed");
+			lua_pop(state, 1);
+
+			runScript(state, "api");
+		}, 2);
+	return pool;
+}
+
+void ScriptedInputSource::seedRandom(unsigned int seed)
+{
+	mRandom.seed(seed);
 }
 
 PlayerInputAbs ScriptedInputSource::getNextInput()
 {
 	bool serving = false;
-	// reset input
-	lua_pushboolean(mState, false);
-	lua_setglobal(mState, "__WANT_LEFT");
-	lua_pushboolean(mState, false);
-	lua_setglobal(mState, "__WANT_RIGHT");
-	lua_pushboolean(mState, false);
-	lua_setglobal(mState, "__WANT_JUMP");
 
 	if (getMatch() == 0)
 	{
@@ -103,8 +181,18 @@ PlayerInputAbs ScriptedInputSource::getNextInput()
 	{
 		IScriptableComponent::setMatch( const_cast<DuelMatch*>(getMatch()) );
 	}
-	lua_getglobal(mState, "__OnStep");
-	callLuaFunction();
+	// __OnStep returns the wanted input
+	pushLuaFunction(mStepFunction);
+	bool wantleft = false;
+	bool wantright = false;
+	bool wantjump = false;
+	if (callLuaFunction(0, 3))
+	{
+		wantleft = lua_toboolean(mState, -3);
+		wantright = lua_toboolean(mState, -2);
+		wantjump = lua_toboolean(mState, -1);
+		lua_pop(mState, 3);
+	}
 
 	if (!getMatch()->getBallActive() && mSide ==
 			// if no player is serving player, assume the left one is
@@ -113,15 +201,6 @@ PlayerInputAbs ScriptedInputSource::getNextInput()
 		serving = true;
 	}
 
-	// read input info from lua script
-	lua_getglobal(mState, "__WANT_LEFT");
-	lua_getglobal(mState, "__WANT_RIGHT");
-	lua_getglobal(mState, "__WANT_JUMP");
-	bool wantleft = lua_toboolean(mState, -3);
-	bool wantright = lua_toboolean(mState, -2);
-	bool wantjump = lua_toboolean(mState, -1);
-	lua_pop(mState, 3);
-
 	int stacksize = lua_gettop(mState);
 	if (stacksize > 0)
 	{
@@ -131,7 +210,7 @@ PlayerInputAbs ScriptedInputSource::getNextInput()
 		lua_pop(mState, stacksize);
 	}
 
-	if (mStartTime + WAITING_TIME > SDL_GetTicks() && serving)
+	if (mStartTime + WAITING_TIME > TimeSource::ticks() && serving)
 		return PlayerInputAbs();
 
 	// random jump delay depending on difficulty
@@ -57,11 +57,19 @@ class ScriptedInputSource : public InputSource, public IScriptableComponent
 		~ScriptedInputSource();
 
 		virtual PlayerInputAbs getNextInput();
+
+		/// seeds the random numbers of the bot, which are used for the jump
+		/// delay and math.random. Bots with the same seed play the same way.
+		void seedRandom(unsigned int seed);
 		using InputSource::getMatch;
 
 	private:
+		/// lua states with the game functions and the api script
+		static LuaStatePool& getStatePool();
 
 		unsigned int mStartTime;
+		// registry reference of __OnStep
+		int mStepFunction;
 
 		// ki strength values
 		int mDifficulty;
@@ -72,5 +80,6 @@ class ScriptedInputSource : public InputSource, public IScriptableComponent
 		bool mLastJump = false;
 		double mJumpDelay = 0;
 		std::normal_distribution<double> mDelayDistribution;
+		// used for the jump delay and for math.random of the script
 		std::default_random_engine mRandom;
 };
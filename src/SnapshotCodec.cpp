@@ -0,0 +1,462 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "SnapshotCodec.h"
+
+/* includes */
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "raknet/BitStream.h"
+
+/* implementation */
+
+namespace
+{
+	const int PHYSIC_FIELDS = 16;
+	const int LOGIC_FIELDS = 10;
+	// logic fields which contain a PlayerSide instead of a counter
+	const int SERVING_PLAYER_FIELD = 4;
+	const int WINNING_PLAYER_FIELD = 5;
+
+	// fixed point format of a float: value = min + code / 2^fractionBits, with code < 2^bits
+	struct Quantization
+	{
+		float min;
+		int fractionBits;
+		int bits;
+	};
+
+	const Quantization POSITION = { -1024.f, 6, 17 };
+	const Quantization VELOCITY = { -64.f, 8, 15 };
+	const Quantization BLOB_STATE = { 0.f, 6, 9 };
+	const Quantization ROTATION = { 0.f, 10, 13 };
+	const Quantization ANGULAR_VELOCITY = { -4.f, 12, 15 };
+
+	// in the order of getPhysicFields
+	const Quantization* const PHYSIC_QUANTIZATION[PHYSIC_FIELDS] = {
+		&POSITION, &POSITION, &VELOCITY, &VELOCITY,
+		&POSITION, &POSITION, &VELOCITY, &VELOCITY,
+		&BLOB_STATE, &BLOB_STATE,
+		&POSITION, &POSITION,
+		&VELOCITY, &VELOCITY,
+		&ROTATION, &ANGULAR_VELOCITY };
+
+	// collects pointers to all floats of the physic state, in the order in which
+	// they are serialized by the generic serializer.
+	void getPhysicFields(const PhysicState& s, const float* fields[PHYSIC_FIELDS])
+	{
+		const float* f[PHYSIC_FIELDS] = {
+			&s.blobPosition[LEFT_PLAYER].x, &s.blobPosition[LEFT_PLAYER].y,
+			&s.blobVelocity[LEFT_PLAYER].x, &s.blobVelocity[LEFT_PLAYER].y,
+			&s.blobPosition[RIGHT_PLAYER].x, &s.blobPosition[RIGHT_PLAYER].y,
+			&s.blobVelocity[RIGHT_PLAYER].x, &s.blobVelocity[RIGHT_PLAYER].y,
+			&s.blobState[LEFT_PLAYER], &s.blobState[RIGHT_PLAYER],
+			&s.ballPosition.x, &s.ballPosition.y,
+			&s.ballVelocity.x, &s.ballVelocity.y,
+			&s.ballRotation, &s.ballAngularVelocity };
+		std::memcpy(fields, f, sizeof(f));
+	}
+
+	// the integer fields of the logic state. the two booleans are handled separately.
+	void getLogicFields(const GameLogicState& s, unsigned int fields[LOGIC_FIELDS])
+	{
+		const unsigned int f[LOGIC_FIELDS] = {
+			s.leftScore, s.rightScore,
+			s.hitCount[LEFT_PLAYER], s.hitCount[RIGHT_PLAYER],
+			(unsigned int)s.servingPlayer, (unsigned int)s.winningPlayer,
+			s.squish[LEFT_PLAYER], s.squish[RIGHT_PLAYER],
+			s.squishWall, s.squishGround };
+		std::memcpy(fields, f, sizeof(f));
+	}
+
+	void setLogicFields(GameLogicState& s, const unsigned int fields[LOGIC_FIELDS])
+	{
+		s.leftScore = fields[0];
+		s.rightScore = fields[1];
+		s.hitCount[LEFT_PLAYER] = fields[2];
+		s.hitCount[RIGHT_PLAYER] = fields[3];
+		s.servingPlayer = (PlayerSide)fields[SERVING_PLAYER_FIELD];
+		s.winningPlayer = (PlayerSide)fields[WINNING_PLAYER_FIELD];
+		s.squish[LEFT_PLAYER] = fields[6];
+		s.squish[RIGHT_PLAYER] = fields[7];
+		s.squishWall = fields[8];
+		s.squishGround = fields[9];
+	}
+
+	// WriteBits writes whole bytes first, so the value is written starting with its most significant byte
+	void writeBits(RakNet::BitStream& stream, unsigned int value, int bits)
+	{
+		while(bits > 0)
+		{
+			int count = std::min(bits, 8);
+			unsigned char byte = (value >> (bits - count)) & 0xFF;
+			stream.WriteBits(&byte, count);
+			bits -= count;
+		}
+	}
+
+	bool readBits(RakNet::BitStream& stream, unsigned int& value, int bits)
+	{
+		value = 0;
+		while(bits > 0)
+		{
+			int count = std::min(bits, 8);
+			unsigned char byte;
+			if(!stream.ReadBits(&byte, count))
+				return false;
+			value = (value << count) | byte;
+			bits -= count;
+		}
+		return true;
+	}
+
+	// a float as it is sent: either a fixed point code, or the bits of the float itself.
+	// raw floats are compared bitwise, so even -0 and NaN are transmitted exactly
+	struct FloatCode
+	{
+		bool raw;
+		unsigned int value;
+
+		bool operator==(const FloatCode& other) const
+		{
+			return raw == other.raw && value == other.value;
+		}
+	};
+
+	FloatCode encodeFloat(float value, const Quantization* quantization)
+	{
+		FloatCode code;
+		if(quantization)
+		{
+			// calculated in double, so the only rounding error is the quantization itself
+			double rounded = std::floor(std::ldexp((double)value, quantization->fractionBits) + 0.5)
+								- std::ldexp((double)quantization->min, quantization->fractionBits);
+			// false for NaN, too
+			if(rounded >= 0 && rounded < (double)(1u << quantization->bits))
+			{
+				code.raw = false;
+				code.value = (unsigned int)rounded;
+				return code;
+			}
+		}
+
+		code.raw = true;
+		std::memcpy(&code.value, &value, sizeof(float));
+		return code;
+	}
+
+	float decodeFloat(const FloatCode& code, const Quantization* quantization)
+	{
+		if(code.raw)
+		{
+			float value;
+			std::memcpy(&value, &code.value, sizeof(float));
+			return value;
+		}
+		return quantization->min + std::ldexp((float)code.value, -quantization->fractionBits);
+	}
+
+	void writeFloat(RakNet::BitStream& stream, const FloatCode& code, const Quantization* quantization)
+	{
+		if(quantization)
+			stream.Write(code.raw);
+		if(code.raw)
+			stream.Write(code.value);
+		else
+			writeBits(stream, code.value, quantization->bits);
+	}
+
+	bool readFloat(RakNet::BitStream& stream, FloatCode& code, const Quantization* quantization)
+	{
+		code.raw = true;
+		if(quantization && !stream.Read(code.raw))
+			return false;
+		if(code.raw)
+			return stream.Read(code.value);
+		return readBits(stream, code.value, quantization->bits);
+	}
+
+	void writeLogicField(RakNet::BitStream& stream, int field, unsigned int value, bool quantized)
+	{
+		if(!quantized)
+		{
+			stream.Write(value);
+		}
+		 else if(field == SERVING_PLAYER_FIELD || field == WINNING_PLAYER_FIELD)
+		{
+			// NO_PLAYER, LEFT_PLAYER or RIGHT_PLAYER
+			writeBits(stream, value + 1, 2);
+		}
+		 else
+		{
+			// scores and counters are small nearly always
+			bool large = value >= 16;
+			stream.Write(large);
+			if(large)
+				stream.Write(value);
+			else
+				writeBits(stream, value, 4);
+		}
+	}
+
+	bool readLogicField(RakNet::BitStream& stream, int field, unsigned int& value, bool quantized)
+	{
+		if(!quantized)
+			return stream.Read(value);
+
+		if(field == SERVING_PLAYER_FIELD || field == WINNING_PLAYER_FIELD)
+		{
+			bool ok = readBits(stream, value, 2);
+			value -= 1;
+			return ok;
+		}
+
+		bool large;
+		if(!stream.Read(large))
+			return false;
+		if(large)
+			return stream.Read(value);
+		return readBits(stream, value, 4);
+	}
+
+	void writeInput(RakNet::BitStream& stream, const PlayerInput& input)
+	{
+		unsigned char all = input.getAll();
+		stream.WriteBits(&all, 3);
+	}
+
+	bool readInput(RakNet::BitStream& stream, PlayerInput& input)
+	{
+		unsigned char all = 0;
+		bool ok = stream.ReadBits(&all, 3);
+		input.setAll(all);
+		return ok;
+	}
+}
+
+SnapshotCodec::SnapshotCodec(Encoding encoding) : mEncoding(encoding)
+{
+}
+
+SnapshotCodec::Encoding SnapshotCodec::getEncoding() const
+{
+	return mEncoding;
+}
+
+void SnapshotCodec::encode(RakNet::BitStream& stream, const DuelMatchState& state, const DuelMatchState* base) const
+{
+	bool quantized = mEncoding == QUANTIZED_ENCODING;
+
+	// physic state
+	const float* fields[PHYSIC_FIELDS];
+	getPhysicFields(state.worldState, fields);
+	FloatCode codes[PHYSIC_FIELDS];
+	for(int i = 0; i < PHYSIC_FIELDS; ++i)
+		codes[i] = encodeFloat(*fields[i], quantized ? PHYSIC_QUANTIZATION[i] : 0);
+
+	if(base)
+	{
+		const float* baseFields[PHYSIC_FIELDS];
+		getPhysicFields(base->worldState, baseFields);
+
+		// fields are compared as they are sent, so changes below the quantization step cost nothing
+		bool changed[PHYSIC_FIELDS];
+		bool anyChanged = false;
+		for(int i = 0; i < PHYSIC_FIELDS; ++i)
+		{
+			changed[i] = !(codes[i] == encodeFloat(*baseFields[i], quantized ? PHYSIC_QUANTIZATION[i] : 0));
+			anyChanged = anyChanged || changed[i];
+		}
+
+		stream.Write(anyChanged);
+		if(anyChanged)
+		{
+			for(int i = 0; i < PHYSIC_FIELDS; ++i)
+			{
+				stream.Write(changed[i]);
+				if(changed[i])
+					writeFloat(stream, codes[i], quantized ? PHYSIC_QUANTIZATION[i] : 0);
+			}
+		}
+	}
+	 else
+	{
+		for(int i = 0; i < PHYSIC_FIELDS; ++i)
+			writeFloat(stream, codes[i], quantized ? PHYSIC_QUANTIZATION[i] : 0);
+	}
+
+	// logic state
+	unsigned int logic[LOGIC_FIELDS];
+	getLogicFields(state.logicState, logic);
+
+	if(base)
+	{
+		unsigned int baseLogic[LOGIC_FIELDS];
+		getLogicFields(base->logicState, baseLogic);
+
+		bool anyChanged = state.logicState.isGameRunning != base->logicState.isGameRunning ||
+							state.logicState.isBallValid != base->logicState.isBallValid;
+		for(int i = 0; i < LOGIC_FIELDS; ++i)
+			anyChanged = anyChanged || logic[i] != baseLogic[i];
+
+		stream.Write(anyChanged);
+		if(anyChanged)
+		{
+			for(int i = 0; i < LOGIC_FIELDS; ++i)
+			{
+				stream.Write(logic[i] != baseLogic[i]);
+				if(logic[i] != baseLogic[i])
+					writeLogicField(stream, i, logic[i], quantized);
+			}
+			stream.Write(state.logicState.isGameRunning);
+			stream.Write(state.logicState.isBallValid);
+		}
+	}
+	 else
+	{
+		for(int i = 0; i < LOGIC_FIELDS; ++i)
+			writeLogicField(stream, i, logic[i], quantized);
+		stream.Write(state.logicState.isGameRunning);
+		stream.Write(state.logicState.isBallValid);
+	}
+
+	// input
+	if(base)
+	{
+		bool changed = !(state.playerInput[LEFT_PLAYER] == base->playerInput[LEFT_PLAYER]) ||
+						!(state.playerInput[RIGHT_PLAYER] == base->playerInput[RIGHT_PLAYER]);
+		stream.Write(changed);
+		if(!changed)
+			return;
+	}
+	writeInput(stream, state.playerInput[LEFT_PLAYER]);
+	writeInput(stream, state.playerInput[RIGHT_PLAYER]);
+}
+
+bool SnapshotCodec::decode(RakNet::BitStream& stream, DuelMatchState& state, const DuelMatchState* base) const
+{
+	bool quantized = mEncoding == QUANTIZED_ENCODING;
+	bool ok = true;
+	if(base)
+		state = *base;
+
+	// physic state
+	const float* fields[PHYSIC_FIELDS];
+	getPhysicFields(state.worldState, fields);
+
+	bool changed = true;
+	if(base)
+		ok = ok && stream.Read(changed);
+
+	for(int i = 0; ok && changed && i < PHYSIC_FIELDS; ++i)
+	{
+		bool fieldChanged = true;
+		if(base)
+			ok = ok && stream.Read(fieldChanged);
+		if(ok && fieldChanged)
+		{
+			const Quantization* quantization = quantized ? PHYSIC_QUANTIZATION[i] : 0;
+			FloatCode code;
+			ok = readFloat(stream, code, quantization);
+			*const_cast<float*>(fields[i]) = decodeFloat(code, quantization);
+		}
+	}
+
+	// logic state
+	changed = true;
+	if(base)
+		ok = ok && stream.Read(changed);
+
+	if(ok && changed)
+	{
+		unsigned int logic[LOGIC_FIELDS];
+		getLogicFields(state.logicState, logic);
+		for(int i = 0; i < LOGIC_FIELDS; ++i)
+		{
+			bool fieldChanged = true;
+			if(base)
+				ok = ok && stream.Read(fieldChanged);
+			if(fieldChanged)
+				ok = ok && readLogicField(stream, i, logic[i], quantized);
+		}
+		setLogicFields(state.logicState, logic);
+		ok = ok && stream.Read(state.logicState.isGameRunning);
+		ok = ok && stream.Read(state.logicState.isBallValid);
+	}
+
+	// input
+	changed = true;
+	if(base)
+		ok = ok && stream.Read(changed);
+
+	if(ok && changed)
+	{
+		ok = ok && readInput(stream, state.playerInput[LEFT_PLAYER]);
+		ok = ok && readInput(stream, state.playerInput[RIGHT_PLAYER]);
+	}
+
+	return ok;
+}
+
+DuelMatchState SnapshotCodec::quantize(const DuelMatchState& state) const
+{
+	DuelMatchState result = state;
+	if(mEncoding != QUANTIZED_ENCODING)
+		return result;
+
+	// only the physic state is rounded, everything else is sent exactly
+	const float* fields[PHYSIC_FIELDS];
+	getPhysicFields(result.worldState, fields);
+	for(int i = 0; i < PHYSIC_FIELDS; ++i)
+	{
+		*const_cast<float*>(fields[i]) = decodeFloat(encodeFloat(*fields[i], PHYSIC_QUANTIZATION[i]), PHYSIC_QUANTIZATION[i]);
+	}
+	return result;
+}
+
+SnapshotHistory::SnapshotHistory()
+{
+	clear();
+}
+
+void SnapshotHistory::store(unsigned int sequence, const DuelMatchState& state)
+{
+	Entry& entry = mEntries[sequence % SIZE];
+	entry.valid = true;
+	entry.sequence = sequence;
+	entry.state = state;
+}
+
+const DuelMatchState* SnapshotHistory::find(unsigned int sequence) const
+{
+	const Entry& entry = mEntries[sequence % SIZE];
+	if(entry.valid && entry.sequence == sequence)
+		return &entry.state;
+	return 0;
+}
+
+void SnapshotHistory::clear()
+{
+	for(auto& entry : mEntries)
+		entry.valid = false;
+}
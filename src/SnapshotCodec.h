@@ -0,0 +1,114 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include "DuelMatchState.h"
+#include "BlobbyDebug.h"
+
+namespace RakNet
+{
+	class BitStream;
+}
+
+/*! \class SnapshotCodec
+	\brief encodes DuelMatchStates relative to an older state
+	\details A snapshot is either a keyframe, which contains every field of the state,
+			or a delta against a base snapshot the receiver already has. In a delta, every
+			field is preceded by a single bit which tells whether it has changed, and each
+			group of fields (physics, logic, input) by a bit which tells whether anything in
+			that group has changed at all. So an unchanged score costs nothing as long as
+			anything else in the logic state changed, and an unchanged logic state costs a
+			single bit.
+
+			With EXACT_ENCODING, floats are sent as they are and compared bitwise, so
+			decoding reproduces the encoded state exactly.
+
+			With QUANTIZED_ENCODING, the physic state is rounded to fixed point numbers
+			and bit packed. The maximum errors are
+				positions:					1/128 (17 bits, range -1024 to 1024)
+				velocities:					1/512 (15 bits, range -64 to 64)
+				blob animation state:		1/128 (9 bits, range 0 to 8)
+				ball rotation:				1/2048 (13 bits, range 0 to 8)
+				ball angular velocity:		1/8192 (15 bits, range -4 to 4)
+			which is far below a pixel. Values outside these ranges are sent as raw floats.
+			The steps are powers of two, so a decoded value is quantized to the same code
+			again, and deltas against a decoded base are exact.
+			Scores and counters use 5 bits if they are smaller than 16, the serving and
+			winning player use 2 bits.
+*/
+class SnapshotCodec : public ObjectCounter<SnapshotCodec>
+{
+	public:
+		enum Encoding
+		{
+			EXACT_ENCODING,
+			QUANTIZED_ENCODING
+		};
+
+		explicit SnapshotCodec(Encoding encoding = EXACT_ENCODING);
+
+		Encoding getEncoding() const;
+
+		/// writes \p state to \p stream. If \p base is NULL, a keyframe is written.
+		void encode(RakNet::BitStream& stream, const DuelMatchState& state, const DuelMatchState* base) const;
+
+		/// reads a state written by encode. \p base has to be the same state that was used
+		/// for encoding, or NULL for a keyframe.
+		/// \return false, if the stream ended prematurely.
+		bool decode(RakNet::BitStream& stream, DuelMatchState& state, const DuelMatchState* base) const;
+
+		/// returns the state which decode reconstructs from the data encode writes for \p state,
+		/// i.e. \p state itself for EXACT_ENCODING and the rounded state for QUANTIZED_ENCODING.
+		DuelMatchState quantize(const DuelMatchState& state) const;
+
+	private:
+		Encoding mEncoding;
+};
+
+/*! \class SnapshotHistory
+	\brief ring buffer of the last snapshots, indexed by their sequence number
+	\details Used on the server to remember what was sent to a client, and on the
+			client to remember what was received, so both sides can find the base
+			snapshot of a delta.
+*/
+class SnapshotHistory : public ObjectCounter<SnapshotHistory>
+{
+	public:
+		SnapshotHistory();
+
+		void store(unsigned int sequence, const DuelMatchState& state);
+		/// returns the snapshot with sequence number \p sequence, or NULL if it
+		/// is no longer (or was never) in the history.
+		const DuelMatchState* find(unsigned int sequence) const;
+		void clear();
+
+		static const int SIZE = 32;
+
+	private:
+		struct Entry
+		{
+			bool valid;
+			unsigned int sequence;
+			DuelMatchState state;
+		};
+
+		Entry mEntries[SIZE];
+};
@@ -23,15 +23,18 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 /* includes */
 #include <algorithm>
+#include <thread>
 
-#include <SDL2/SDL.h>
+#include "TimeSource.h"
 
 /* implementation */
 /// this is required to reduce rounding errors. now we have a resolution of
-/// 1s. This is much better than SDL_Delay can handle, but we prevent 
+/// 1s. This is much better than a millisecond delay can handle, but we prevent 
 /// accumulation errors.
 const int PRECISION_FACTOR = 1000;
 
+const int SpeedController::MAX_LAG_FRAMES;
+
 SpeedController* SpeedController::mMainInstance = NULL;
 
 SpeedController::SpeedController(float gameFPS)
@@ -40,10 +43,13 @@ SpeedController::SpeedController(float gameFPS)
 	mFramedrop = false;
 	mDrawFPS = true;
 	mFPSCounter = 0;
-	mOldTicks = SDL_GetTicks();
+	mOldTicks = TimeSource::ticks();
 	mFPS = 0;
 	mBeginSecond = mOldTicks;
 	mCounter = 0;
+	mTimingMode = MILLISECOND_TIMING;
+	mSpinBudget = std::chrono::milliseconds(1);
+	mLastDeadline = clock_type::now();
 }
 
 SpeedController::~SpeedController()
@@ -59,6 +65,14 @@ void SpeedController::setGameSpeed(float fps)
 	/// \todo maybe we should reset only if speed changed?
 	mBeginSecond = mOldTicks;
 	mCounter = 0;
+	mLastDeadline = clock_type::now();
+}
+
+void SpeedController::setTimingMode(TimingMode mode)
+{
+	mTimingMode = mode;
+	mLastDeadline = clock_type::now();
+	mStatistics.reset();
 }
 
 bool SpeedController::doFramedrop() const
@@ -67,30 +81,57 @@ bool SpeedController::doFramedrop() const
 }
 
 void SpeedController::update()
+{
+	static int lastTicks = TimeSource::ticks();
+
+	// deadlines are wall clock time points, so with a simulated time source we
+	// always wait in milliseconds, which only advances the simulated time.
+	if (mTimingMode == DEADLINE_TIMING && TimeSource::current().isRealTime())
+		waitDeadline();
+	else
+		waitMilliseconds();
+
+	//calculate the FPS of drawn frames:
+	if (mDrawFPS)
+	{
+		if (lastTicks >= mOldTicks + 1000)
+		{
+			mOldTicks = lastTicks;
+			mFPS = mFPSCounter;
+			mFPSCounter = 0;
+		}
+
+		if (!mFramedrop)
+			mFPSCounter++;
+	}
+
+	//update for next call:
+	lastTicks = TimeSource::ticks();
+}
+
+void SpeedController::waitMilliseconds()
 {
 	int rateTicks = std::max( static_cast<int>(PRECISION_FACTOR * 1000 / mGameFPS), 1);
-	
-	static int lastTicks = SDL_GetTicks();
 
 	if (mCounter == mGameFPS)
 	{
-		const int delta = SDL_GetTicks() - mBeginSecond;
+		const int delta = TimeSource::ticks() - mBeginSecond;
 		int wait = 1000 - delta;
 		if (wait > 0)
-			SDL_Delay(wait);
+			TimeSource::current().delay(wait);
 	}
-	if (mBeginSecond + 1000 <= SDL_GetTicks())
+	if (mBeginSecond + 1000 <= TimeSource::ticks())
 	{
-		mBeginSecond = SDL_GetTicks();
+		mBeginSecond = TimeSource::ticks();
 		mCounter = 0;
 	}
 
-	const int delta = SDL_GetTicks() - mBeginSecond;
+	const int delta = TimeSource::ticks() - mBeginSecond;
 	if ( (PRECISION_FACTOR * delta) / rateTicks <= mCounter)
 	{
 		int wait = ((mCounter+1)*rateTicks/PRECISION_FACTOR) - delta;
 		if (wait > 0)
-			SDL_Delay(wait);
+			TimeSource::current().delay(wait);
 	}
 	
 	// do we need framedrop?
@@ -104,23 +145,56 @@ void SpeedController::update()
 		mFramedrop = false;
 
 	mCounter++;
+}
 
-	//calculate the FPS of drawn frames:
-	if (mDrawFPS)
-	{
-		if (lastTicks >= mOldTicks + 1000)
-		{
-			mOldTicks = lastTicks;
-			mFPS = mFPSCounter;
-			mFPSCounter = 0;
-		}
+void SpeedController::waitDeadline()
+{
+	const clock_type::duration period = std::chrono::duration_cast<clock_type::duration>(
+											std::chrono::duration<double>(1.0 / mGameFPS) );
+	const clock_type::time_point deadline = mLastDeadline + period;
 
-		if (!mFramedrop)
-			mFPSCounter++;
-	}
+	// do we need framedrop? same rule as in waitMilliseconds: if we are already
+	// late, we skip drawing, but never twice in a row.
+	mFramedrop = clock_type::now() > deadline && !mFramedrop;
 
-	//update for next call:
-	lastTicks = SDL_GetTicks();
+	clock_type::time_point now = waitUntil(deadline, mSpinBudget);
+	mStatistics.add(now - deadline);
+	mLastDeadline = advanceDeadline(deadline, now, period);
 }
 
+SpeedController::clock_type::time_point SpeedController::advanceDeadline(clock_type::time_point deadline,
+		clock_type::time_point now, clock_type::duration period)
+{
+	// advance the deadline by exactly one frame, so we don't drift. If we lag
+	// behind too much (e.g. because the window was dragged), we start anew.
+	if (now - deadline > MAX_LAG_FRAMES * period)
+		return now;
+	return deadline;
+}
 
+SpeedController::clock_type::time_point SpeedController::waitUntil(clock_type::time_point deadline, clock_type::duration spin)
+{
+	clock_type::time_point now = clock_type::now();
+	if (deadline - now > spin)
+		std::this_thread::sleep_until(deadline - spin);
+
+	while ((now = clock_type::now()) < deadline)
+		std::this_thread::yield();
+
+	return now;
+}
+
+void TimingStatistics::add(std::chrono::steady_clock::duration overshoot)
+{
+	double us = std::chrono::duration<double, std::micro>(overshoot).count();
+	frames++;
+	if (us > 1000)
+		lateFrames++;
+	meanOvershoot += (us - meanOvershoot) / frames;
+	maxOvershoot = std::max(maxOvershoot, us);
+}
+
+void TimingStatistics::reset()
+{
+	*this = TimingStatistics();
+}
@@ -25,8 +25,25 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #pragma once
 
+#include <chrono>
+
 #include "BlobbyDebug.h"
 
+/// \brief statistics about the accuracy of timed waits
+/// \details The overshoot is the time between the requested deadline and
+/// the moment the wait actually returned. All times are in microseconds.
+struct TimingStatistics
+{
+	void add(std::chrono::steady_clock::duration overshoot);
+	void reset();
+
+	unsigned frames = 0;
+	/// number of frames that overshot by more than a millisecond
+	unsigned lateFrames = 0;
+	double meanOvershoot = 0;
+	double maxOvershoot = 0;
+};
+
 /// \brief class controlling game speed
 /// \details This class can control the game speed and the displayed FPS.
 /// It is updated once a frame and waits the necessary time.
@@ -36,11 +53,27 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 /// FPS is reached with framedropping
 /// The class can report how much time is actually waited. If this value
 /// is close to zero, the real speed can be altered.
+/// There are two timing modes: MILLISECOND_TIMING waits in whole milliseconds
+/// with the TimeSource of the current thread and re-anchors every second. DEADLINE_TIMING keeps absolute
+/// std::chrono::steady_clock deadlines that advance by exactly one frame period,
+/// so there is no drift and non-integer rates are possible. It sleeps until
+/// shortly before the deadline and spins for the rest of the time (the spin
+/// budget), and records how much each frame overshot its deadline.
+/// If the current TimeSource is not the real time, MILLISECOND_TIMING is always
+/// used, so waiting just advances the simulated time.
 
 
 class SpeedController : public ObjectCounter<SpeedController>
 {
 	public:
+		typedef std::chrono::steady_clock clock_type;
+
+		enum TimingMode
+		{
+			MILLISECOND_TIMING,
+			DEADLINE_TIMING
+		};
+
 		SpeedController(float gameFPS);
 		~SpeedController();
 
@@ -58,9 +91,34 @@ class SpeedController : public ObjectCounter<SpeedController>
 	/// This updates everything and waits the necessary time
 		void update();
 
+		void setTimingMode(TimingMode mode);
+		TimingMode getTimingMode() const { return mTimingMode; }
+	/// sets how long before a deadline we stop sleeping and start busy waiting.
+	/// only used in DEADLINE_TIMING mode.
+		void setSpinBudget(clock_type::duration budget) { mSpinBudget = budget; }
+	/// overshoot statistics, only collected in DEADLINE_TIMING mode
+		const TimingStatistics& getTimingStatistics() const { return mStatistics; }
+		void resetTimingStatistics() { mStatistics.reset(); }
+
+	/// sleeps until \p spin before \p deadline, and busy waits for the remaining time.
+	/// returns the time at which the wait ended.
+		static clock_type::time_point waitUntil(clock_type::time_point deadline, clock_type::duration spin);
+
+	/// if a deadline is missed by more than this number of frames, the
+	/// deadline is reset instead of trying to catch up.
+		static const int MAX_LAG_FRAMES = 5;
+	/// returns the deadline from which the next frame is timed, after the frame due at
+	/// \p deadline has ended at \p now. That is \p deadline itself, so late frames are
+	/// caught up with, unless the frame is more than MAX_LAG_FRAMES periods late.
+		static clock_type::time_point advanceDeadline(clock_type::time_point deadline,
+				clock_type::time_point now, clock_type::duration period);
+
 		static void setMainInstance(SpeedController* inst) { mMainInstance = inst; }
 		static SpeedController* getMainInstance() { return mMainInstance; }
 	private:
+		void waitMilliseconds();
+		void waitDeadline();
+
 		float mGameFPS;
 		int mFPS;
 		int mFPSCounter;
@@ -72,6 +130,12 @@ class SpeedController : public ObjectCounter<SpeedController>
 		// internal data
 		unsigned int mBeginSecond;
 		int mCounter;
+
+		// deadline timing
+		TimingMode mTimingMode;
+		clock_type::duration mSpinBudget;
+		clock_type::time_point mLastDeadline;
+		TimingStatistics mStatistics;
 };
 
 
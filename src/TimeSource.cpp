@@ -0,0 +1,119 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "TimeSource.h"
+
+/* includes */
+#include <thread>
+
+/* implementation */
+
+TimeSource::~TimeSource()
+{
+}
+
+TimeSource*& TimeSource::currentPointer()
+{
+	thread_local TimeSource* source = nullptr;
+	return source;
+}
+
+TimeSource& TimeSource::current()
+{
+	TimeSource* source = currentPointer();
+	return source ? *source : realTime();
+}
+
+unsigned int TimeSource::ticks()
+{
+	return current().getTicks();
+}
+
+TimeSource& TimeSource::realTime()
+{
+	static RealTimeSource source;
+	return source;
+}
+
+// ---------------------------------------------------------------------------------------
+//	RealTimeSource
+// ---------------------------------------------------------------------------------------
+
+RealTimeSource::RealTimeSource() : mStart(std::chrono::steady_clock::now())
+{
+}
+
+unsigned int RealTimeSource::getTicks() const
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - mStart).count();
+}
+
+void RealTimeSource::delay(unsigned int ms)
+{
+	std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+bool RealTimeSource::isRealTime() const
+{
+	return true;
+}
+
+// ---------------------------------------------------------------------------------------
+//	VirtualTimeSource
+// ---------------------------------------------------------------------------------------
+
+VirtualTimeSource::VirtualTimeSource(double startTicks) : mTicks(startTicks)
+{
+}
+
+unsigned int VirtualTimeSource::getTicks() const
+{
+	return mTicks;
+}
+
+void VirtualTimeSource::delay(unsigned int ms)
+{
+	advance(ms);
+}
+
+bool VirtualTimeSource::isRealTime() const
+{
+	return false;
+}
+
+void VirtualTimeSource::advance(double ms)
+{
+	mTicks += ms;
+}
+
+// ---------------------------------------------------------------------------------------
+//	ScopedTimeSource
+// ---------------------------------------------------------------------------------------
+
+ScopedTimeSource::ScopedTimeSource(TimeSource& source) : mPrevious(TimeSource::currentPointer())
+{
+	TimeSource::currentPointer() = &source;
+}
+
+ScopedTimeSource::~ScopedTimeSource()
+{
+	TimeSource::currentPointer() = mPrevious;
+}
@@ -0,0 +1,110 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <chrono>
+
+/*! \class TimeSource
+	\brief source of the millisecond ticks that drive game timing
+	\details Clock, SpeedController and the bots do not ask SDL or the operating
+			system for the time, but the time source of the current thread. By default
+			this is the real time. A ScopedTimeSource replaces it for the current
+			thread, e.g. with a VirtualTimeSource, which only advances when told to. This
+			way a match can be simulated faster than real time, and still see the same
+			time passing between two steps as a match running at normal speed.
+*/
+class TimeSource
+{
+	public:
+		virtual ~TimeSource();
+
+		/// milliseconds since an arbitrary, fixed point in time
+		virtual unsigned int getTicks() const = 0;
+		/// waits until \p ms milliseconds have passed
+		virtual void delay(unsigned int ms) = 0;
+		/// whether this source follows the wall clock
+		virtual bool isRealTime() const = 0;
+
+		/// the time source of the current thread
+		static TimeSource& current();
+		/// shortcut for current().getTicks()
+		static unsigned int ticks();
+		/// the wall clock, shared by all threads
+		static TimeSource& realTime();
+
+	private:
+		friend class ScopedTimeSource;
+		static TimeSource*& currentPointer();
+};
+
+/*! \class RealTimeSource
+	\brief wall clock time source, based on std::chrono::steady_clock
+*/
+class RealTimeSource : public TimeSource
+{
+	public:
+		RealTimeSource();
+
+		unsigned int getTicks() const override;
+		void delay(unsigned int ms) override;
+		bool isRealTime() const override;
+
+	private:
+		std::chrono::steady_clock::time_point mStart;
+};
+
+/*! \class VirtualTimeSource
+	\brief time source that advances only when told to
+	\details Time is stored with sub-millisecond precision, so advancing by
+			1000 / 75 ms every step does not accumulate rounding errors. delay()
+			returns immediately, and advances the time by the requested amount.
+*/
+class VirtualTimeSource : public TimeSource
+{
+	public:
+		explicit VirtualTimeSource(double startTicks = 0);
+
+		unsigned int getTicks() const override;
+		void delay(unsigned int ms) override;
+		bool isRealTime() const override;
+
+		/// advances the time by \p ms milliseconds
+		void advance(double ms);
+
+	private:
+		double mTicks;
+};
+
+/*! \class ScopedTimeSource
+	\brief makes a time source the current one of this thread, as long as it lives
+*/
+class ScopedTimeSource
+{
+	public:
+		explicit ScopedTimeSource(TimeSource& source);
+		~ScopedTimeSource();
+
+		ScopedTimeSource(const ScopedTimeSource&) = delete;
+		ScopedTimeSource& operator=(const ScopedTimeSource&) = delete;
+
+	private:
+		TimeSource* mPrevious;
+};
@@ -0,0 +1,205 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "Trace.h"
+
+/* includes */
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+/* implementation */
+
+namespace
+{
+	typedef TraceRecorder::clock_type clock_type;
+
+	struct TraceEvent
+	{
+		const char* name;
+		clock_type::time_point begin;
+		clock_type::time_point end;
+	};
+
+	// a ring buffer of spans. Only its thread writes to it, the spans up to head are
+	// published with release semantics so writeChromeTrace can read them.
+	struct TraceBuffer
+	{
+		int thread;
+		const char* name;
+		std::atomic<std::uint64_t> head;
+		std::vector<TraceEvent> events;
+	};
+
+	// all buffers that were ever created. Buffers are never deleted, so spans of
+	// threads that have already finished can still be written.
+	struct TraceRegistry
+	{
+		std::mutex mutex;
+		std::vector<std::unique_ptr<TraceBuffer>> buffers;
+		clock_type::time_point begin;
+		clock_type::time_point end;
+	};
+
+	TraceRegistry& getRegistry()
+	{
+		static TraceRegistry registry;
+		return registry;
+	}
+
+	thread_local TraceBuffer* threadBuffer = nullptr;
+	thread_local const char* threadName = nullptr;
+
+	TraceBuffer& getThreadBuffer()
+	{
+		if(!threadBuffer)
+		{
+			TraceRegistry& registry = getRegistry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+
+			std::unique_ptr<TraceBuffer> buffer(new TraceBuffer);
+			buffer->thread = registry.buffers.size() + 1;
+			buffer->name = threadName;
+			buffer->head = 0;
+			buffer->events.resize(TraceRecorder::BUFFER_SIZE);
+			threadBuffer = buffer.get();
+			registry.buffers.push_back(std::move(buffer));
+		}
+		return *threadBuffer;
+	}
+
+	double toMicroseconds(clock_type::duration duration)
+	{
+		return std::chrono::duration<double, std::micro>(duration).count();
+	}
+
+	void writeString(std::ostream& stream, const char* string)
+	{
+		stream << '"';
+		for(; *string; ++string)
+		{
+			if(*string == '"' || *string == '\\')
+				stream << '\\';
+			stream << *string;
+		}
+		stream << '"';
+	}
+}
+
+std::atomic<bool> TraceRecorder::mRecording(false);
+
+void TraceRecorder::start()
+{
+	TraceRegistry& registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	registry.begin = clock_type::now();
+	mRecording = true;
+}
+
+void TraceRecorder::stop()
+{
+	TraceRegistry& registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	if(mRecording)
+		registry.end = clock_type::now();
+	mRecording = false;
+}
+
+void TraceRecorder::setThreadName(const char* name)
+{
+	threadName = name;
+	if(threadBuffer)
+	{
+		std::lock_guard<std::mutex> lock(getRegistry().mutex);
+		threadBuffer->name = name;
+	}
+}
+
+void TraceRecorder::record(const char* name, clock_type::time_point begin, clock_type::time_point end)
+{
+	TraceBuffer& buffer = getThreadBuffer();
+	std::uint64_t head = buffer.head.load(std::memory_order_relaxed);
+	TraceEvent& event = buffer.events[head % BUFFER_SIZE];
+	event.name = name;
+	event.begin = begin;
+	event.end = end;
+	buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void TraceRecorder::writeChromeTrace(std::ostream& stream)
+{
+	TraceRegistry& registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	clock_type::time_point begin = registry.begin;
+	clock_type::time_point end = mRecording ? clock_type::now() : registry.end;
+
+	std::ios::fmtflags flags = stream.flags();
+	std::streamsize precision = stream.precision();
+	stream << std::fixed << std::setprecision(3);
+
+	stream << "{\"traceEvents\":[\n";
+	bool first = true;
+	for(const auto& buffer : registry.buffers)
+	{
+		if(buffer->name)
+		{
+			stream << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->thread
+					<< ",\"args\":{\"name\":";
+			writeString(stream, buffer->name);
+			stream << "}}";
+			first = false;
+		}
+
+		// copy the spans first, then check which of them might have been overwritten meanwhile
+		std::uint64_t head = buffer->head.load(std::memory_order_acquire);
+		std::uint64_t oldest = head > BUFFER_SIZE ? head - BUFFER_SIZE : 0;
+		std::vector<TraceEvent> events;
+		for(std::uint64_t i = oldest; i < head; ++i)
+			events.push_back(buffer->events[i % BUFFER_SIZE]);
+
+		// the owning thread may currently be writing the span at index newHead
+		std::uint64_t newHead = buffer->head.load(std::memory_order_acquire);
+		std::uint64_t firstValid = newHead + 1 > BUFFER_SIZE ? newHead + 1 - BUFFER_SIZE : 0;
+
+		for(std::uint64_t i = std::max(oldest, firstValid); i < head; ++i)
+		{
+			const TraceEvent& event = events[i - oldest];
+			if(event.begin < begin || event.end > end)
+				continue;
+
+			stream << (first ? "" : ",\n") << "{\"name\":";
+			writeString(stream, event.name);
+			stream << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread
+					<< ",\"ts\":" << toMicroseconds(event.begin - begin)
+					<< ",\"dur\":" << toMicroseconds(event.end - event.begin) << "}";
+			first = false;
+		}
+	}
+	stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+	stream.flags(flags);
+	stream.precision(precision);
+}
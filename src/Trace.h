@@ -0,0 +1,105 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <iosfwd>
+
+/** \file Trace.h
+	Lightweight profiling of the hot paths. Code marks spans with TRACE_SCOPE("name"),
+	and while a recording is running, each span is stored with its start and end time
+	in a ring buffer of the thread that executed it. The rings are written by their own
+	thread only, so recording needs no locks. A recording can be written as a Chrome
+	trace (load it in chrome://tracing or ui.perfetto.dev).
+	Tracing is only compiled in if BLOBBY_TRACE is defined (cmake -DBLOBBY_TRACE=ON),
+	otherwise the macros expand to nothing.
+*/
+
+/*! \class TraceRecorder
+	\brief starts and stops recordings and writes the recorded spans.
+	\details Each thread keeps the last BUFFER_SIZE spans, older ones are overwritten.
+			The span names have to be string literals, only the pointers are stored.
+*/
+class TraceRecorder
+{
+	public:
+		typedef std::chrono::steady_clock clock_type;
+
+		/// starts recording. Spans recorded earlier are discarded.
+		static void start();
+		/// stops recording. Spans that are running at this time are not recorded.
+		static void stop();
+		static bool isRecording()
+		{
+			return mRecording.load(std::memory_order_relaxed);
+		}
+
+		/// writes the spans of the last recording in Chrome trace_event JSON format
+		static void writeChromeTrace(std::ostream& stream);
+
+		/// sets the name under which the current thread appears in the trace
+		static void setThreadName(const char* name);
+
+		/// adds a span of the current thread
+		static void record(const char* name, clock_type::time_point begin, clock_type::time_point end);
+
+		static const int BUFFER_SIZE = 1 << 17;
+
+	private:
+		static std::atomic<bool> mRecording;
+};
+
+/// records a span from its construction to its destruction
+class TraceScope
+{
+	public:
+		explicit TraceScope(const char* name) : mName(name), mActive(TraceRecorder::isRecording())
+		{
+			if(mActive)
+				mBegin = TraceRecorder::clock_type::now();
+		}
+
+		~TraceScope()
+		{
+			if(mActive && TraceRecorder::isRecording())
+				TraceRecorder::record(mName, mBegin, TraceRecorder::clock_type::now());
+		}
+
+	private:
+		const char* mName;
+		bool mActive;
+		TraceRecorder::clock_type::time_point mBegin;
+};
+
+#ifdef BLOBBY_TRACE
+
+#define TRACE_CONCAT_IMP(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMP(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_THREAD_NAME(name) TraceRecorder::setThreadName(name)
+
+#else
+
+#define TRACE_SCOPE(name)
+#define TRACE_THREAD_NAME(name)
+
+#endif
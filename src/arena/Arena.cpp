@@ -0,0 +1,372 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "Arena.h"
+
+/* includes */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+#include <ostream>
+
+#include <boost/make_shared.hpp>
+
+#include "DuelMatch.h"
+#include "ScriptedInputSource.h"
+#include "WorkStealingPool.h"
+
+/* implementation */
+
+namespace
+{
+	const double ELO_START = 1500;
+	const double ELO_K = 16;
+
+	/// score of the left player, as used for elo and swiss points
+	double leftScore(const Arena::MatchRecord& match)
+	{
+		switch(match.result.winner)
+		{
+			case LEFT_PLAYER:
+				return 1;
+			case RIGHT_PLAYER:
+				return 0;
+			default:
+				return 0.5;
+		}
+	}
+
+	std::string jsonString(const std::string& string)
+	{
+		std::string result = "\"";
+		for(char c : string)
+		{
+			if(c == '"' || c == '\\')
+				result += '\\';
+			result += c;
+		}
+		return result + "\"";
+	}
+
+	const char* scheduleName(Arena::Schedule schedule)
+	{
+		return schedule == Arena::SWISS ? "swiss" : "round-robin";
+	}
+}
+
+Arena::Settings::Settings() :
+		rules(1, DEFAULT_RULES_FILE), schedule(ROUND_ROBIN), rounds(5), games(1),
+		scoreToWin(15), difficulty(0), seed(0), maxSteps(HeadlessMatch::DEFAULT_MAX_STEPS)
+{
+}
+
+double Arena::Standing::getWinRate() const
+{
+	return played > 0 ? (won + 0.5 * drawn) / played : 0;
+}
+
+Arena::Arena(const Settings& settings) : mSettings(settings)
+{
+}
+
+void Arena::run(WorkStealingPool& pool, const std::function<void(const MatchRecord&)>& progress)
+{
+	mMatches.clear();
+	const int bots = mSettings.bots.size();
+
+	if(mSettings.schedule == ROUND_ROBIN)
+	{
+		playRound(pool, 0, roundRobin(bots, mSettings.games), progress);
+		return;
+	}
+
+	std::vector<double> points(bots, 0);
+	std::vector<std::vector<int>> played(bots, std::vector<int>(bots, 0));
+	std::vector<int> byes(bots, 0);
+	for(int round = 0; round < mSettings.rounds; ++round)
+	{
+		int bye;
+		std::vector<Pairing> pairings = swissRound(points, played, byes, bye);
+		if(bye >= 0)
+		{
+			++byes[bye];
+			points[bye] += mSettings.rules.size() * 2 * mSettings.games;
+		}
+
+		// both sides
+		std::vector<Pairing> round_pairings;
+		for(const auto& pairing : pairings)
+		{
+			for(int game = 0; game < mSettings.games; ++game)
+			{
+				round_pairings.push_back(pairing);
+				round_pairings.push_back(Pairing{pairing.right, pairing.left});
+			}
+			++played[pairing.left][pairing.right];
+			++played[pairing.right][pairing.left];
+		}
+
+		std::size_t first = mMatches.size();
+		playRound(pool, round, round_pairings, progress);
+
+		for(std::size_t i = first; i < mMatches.size(); ++i)
+		{
+			points[mMatches[i].bot[LEFT_PLAYER]] += leftScore(mMatches[i]);
+			points[mMatches[i].bot[RIGHT_PLAYER]] += 1 - leftScore(mMatches[i]);
+		}
+	}
+}
+
+void Arena::playRound(WorkStealingPool& pool, int round, const std::vector<Pairing>& pairings,
+						const std::function<void(const MatchRecord&)>& progress)
+{
+	// the records are filled by the workers, so the vector must not grow while they run
+	std::size_t first = mMatches.size();
+	mMatches.resize(first + pairings.size() * mSettings.rules.size());
+
+	std::size_t index = first;
+	for(const auto& rules : mSettings.rules)
+	{
+		for(const auto& pairing : pairings)
+		{
+			MatchRecord& record = mMatches[index];
+			record.index = index++;
+			record.round = round;
+			record.rules = rules;
+			record.bot[LEFT_PLAYER] = pairing.left;
+			record.bot[RIGHT_PLAYER] = pairing.right;
+
+			pool.submit([this, &record, &progress]()
+			{
+				play(record);
+				if(progress)
+				{
+					std::lock_guard<std::mutex> lock(mProgressMutex);
+					progress(record);
+				}
+			});
+		}
+	}
+
+	pool.wait();
+}
+
+void Arena::play(MatchRecord& record) const
+{
+	auto start = std::chrono::steady_clock::now();
+
+	HeadlessMatch match(record.rules, mSettings.scoreToWin, [this, &record](PlayerSide side)
+	{
+		auto bot = boost::make_shared<ScriptedInputSource>("scripts/" + mSettings.bots[record.bot[side]],
+															side, mSettings.difficulty);
+		bot->seedRandom(mSettings.seed + 2 * record.index + side);
+		return bot;
+	});
+	record.result = match.run(mSettings.maxSteps);
+
+	record.duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+const std::vector<Arena::MatchRecord>& Arena::getMatches() const
+{
+	return mMatches;
+}
+
+std::vector<Arena::Standing> Arena::getStandings() const
+{
+	std::vector<Standing> standings(mSettings.bots.size());
+	for(std::size_t i = 0; i < standings.size(); ++i)
+	{
+		standings[i] = Standing{mSettings.bots[i], 0, 0, 0, 0, 0, 0, ELO_START};
+	}
+
+	for(const auto& match : mMatches)
+	{
+		Standing& left = standings[match.bot[LEFT_PLAYER]];
+		Standing& right = standings[match.bot[RIGHT_PLAYER]];
+		double score = leftScore(match);
+
+		++left.played;
+		++right.played;
+		if(score == 1)
+		{
+			++left.won;
+			++right.lost;
+		}
+		 else if(score == 0)
+		{
+			++left.lost;
+			++right.won;
+		}
+		 else
+		{
+			++left.drawn;
+			++right.drawn;
+		}
+		left.scored += match.result.score[LEFT_PLAYER];
+		left.conceded += match.result.score[RIGHT_PLAYER];
+		right.scored += match.result.score[RIGHT_PLAYER];
+		right.conceded += match.result.score[LEFT_PLAYER];
+
+		updateElo(left.elo, right.elo, score);
+	}
+
+	std::stable_sort(standings.begin(), standings.end(), [](const Standing& a, const Standing& b)
+	{
+		return a.elo > b.elo;
+	});
+	return standings;
+}
+
+void Arena::writeMatchesCSV(std::ostream& stream) const
+{
+	stream << "match,round,rules,left,right,left_score,right_score,winner,steps,game_time,duration_ms\n";
+	for(const auto& match : mMatches)
+	{
+		stream << match.index << "," << match.round << "," << match.rules << ","
+				<< mSettings.bots[match.bot[LEFT_PLAYER]] << "," << mSettings.bots[match.bot[RIGHT_PLAYER]] << ","
+				<< match.result.score[LEFT_PLAYER] << "," << match.result.score[RIGHT_PLAYER] << ",";
+		if(match.result.winner != NO_PLAYER)
+			stream << mSettings.bots[match.bot[match.result.winner]];
+		stream << "," << match.result.steps << "," << match.result.gameTime << ","
+				<< match.duration * 1000 << "\n";
+	}
+}
+
+void Arena::writeStandingsCSV(std::ostream& stream) const
+{
+	stream << "bot,played,won,drawn,lost,win_rate,scored,conceded,elo\n";
+	for(const auto& standing : getStandings())
+	{
+		stream << standing.bot << "," << standing.played << "," << standing.won << "," << standing.drawn << ","
+				<< standing.lost << "," << standing.getWinRate() << "," << standing.scored << ","
+				<< standing.conceded << "," << std::round(standing.elo) << "\n";
+	}
+}
+
+void Arena::writeJSON(std::ostream& stream) const
+{
+	stream << "{\n\"settings\": {\"schedule\": " << jsonString(scheduleName(mSettings.schedule))
+			<< ", \"rounds\": " << mSettings.rounds << ", \"games\": " << mSettings.games
+			<< ", \"score_to_win\": " << mSettings.scoreToWin << ", \"difficulty\": " << mSettings.difficulty
+			<< ", \"seed\": " << mSettings.seed << ", \"rules\": [";
+	for(std::size_t i = 0; i < mSettings.rules.size(); ++i)
+		stream << (i ? ", " : "") << jsonString(mSettings.rules[i]);
+	stream << "]},\n\"standings\": [";
+
+	std::vector<Standing> standings = getStandings();
+	for(std::size_t i = 0; i < standings.size(); ++i)
+	{
+		const Standing& standing = standings[i];
+		stream << (i ? ",\n" : "\n") << "{\"bot\": " << jsonString(standing.bot) << ", \"played\": " << standing.played
+				<< ", \"won\": " << standing.won << ", \"drawn\": " << standing.drawn << ", \"lost\": " << standing.lost
+				<< ", \"win_rate\": " << standing.getWinRate() << ", \"scored\": " << standing.scored
+				<< ", \"conceded\": " << standing.conceded << ", \"elo\": " << std::round(standing.elo) << "}";
+	}
+	stream << "],\n\"matches\": [";
+
+	for(std::size_t i = 0; i < mMatches.size(); ++i)
+	{
+		const MatchRecord& match = mMatches[i];
+		stream << (i ? ",\n" : "\n") << "{\"match\": " << match.index << ", \"round\": " << match.round
+				<< ", \"rules\": " << jsonString(match.rules)
+				<< ", \"left\": " << jsonString(mSettings.bots[match.bot[LEFT_PLAYER]])
+				<< ", \"right\": " << jsonString(mSettings.bots[match.bot[RIGHT_PLAYER]])
+				<< ", \"left_score\": " << match.result.score[LEFT_PLAYER]
+				<< ", \"right_score\": " << match.result.score[RIGHT_PLAYER] << ", \"winner\": ";
+		if(match.result.winner != NO_PLAYER)
+			stream << jsonString(mSettings.bots[match.bot[match.result.winner]]);
+		else
+			stream << "null";
+		stream << ", \"steps\": " << match.result.steps << ", \"game_time\": " << match.result.gameTime
+				<< ", \"duration_ms\": " << match.duration * 1000 << "}";
+	}
+	stream << "]\n}\n";
+}
+
+std::vector<Arena::Pairing> Arena::roundRobin(int bots, int games)
+{
+	std::vector<Pairing> pairings;
+	for(int a = 0; a < bots; ++a)
+	{
+		for(int b = a + 1; b < bots; ++b)
+		{
+			for(int game = 0; game < games; ++game)
+			{
+				pairings.push_back(Pairing{a, b});
+				pairings.push_back(Pairing{b, a});
+			}
+		}
+	}
+	return pairings;
+}
+
+std::vector<Arena::Pairing> Arena::swissRound(const std::vector<double>& points,
+							const std::vector<std::vector<int>>& played, const std::vector<int>& byes, int& bye)
+{
+	// ranking, best first. Equal points keep the order of the bots.
+	std::vector<int> ranking(points.size());
+	std::iota(ranking.begin(), ranking.end(), 0);
+	std::stable_sort(ranking.begin(), ranking.end(), [&points](int a, int b) { return points[a] > points[b]; });
+
+	bye = -1;
+	if(ranking.size() % 2 == 1)
+	{
+		auto lowest = ranking.rbegin();
+		for(auto it = ranking.rbegin(); it != ranking.rend(); ++it)
+		{
+			if(byes[*it] < byes[*lowest])
+				lowest = it;
+		}
+		bye = *lowest;
+		ranking.erase(std::next(lowest).base());
+	}
+
+	std::vector<Pairing> pairings;
+	std::vector<bool> paired(ranking.size(), false);
+	for(std::size_t i = 0; i < ranking.size(); ++i)
+	{
+		if(paired[i])
+			continue;
+
+		// the next unpaired bot that was played the fewest times
+		int partner = -1;
+		for(std::size_t j = i + 1; j < ranking.size(); ++j)
+		{
+			if(!paired[j] && (partner < 0 || played[ranking[i]][ranking[j]] < played[ranking[i]][ranking[partner]]))
+				partner = j;
+		}
+
+		paired[i] = true;
+		paired[partner] = true;
+		pairings.push_back(Pairing{ranking[i], ranking[partner]});
+	}
+	return pairings;
+}
+
+void Arena::updateElo(double& left, double& right, double leftScore)
+{
+	double expected = 1 / (1 + std::pow(10, (right - left) / 400));
+	double change = ELO_K * (leftScore - expected);
+	left += change;
+	right -= change;
+}
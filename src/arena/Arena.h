@@ -0,0 +1,147 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <functional>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Global.h"
+#include "HeadlessMatch.h"
+#include "BlobbyDebug.h"
+
+class WorkStealingPool;
+
+/*! \class Arena
+	\brief plays tournaments between bots
+	\details Every match is a HeadlessMatch between two ScriptedInputSources, so a match
+			takes only as long as the computation. The matches of a round are independent
+			and are played in parallel on a WorkStealingPool.
+			In a round robin tournament, every bot plays every other bot on both sides, once
+			per rules file. A swiss tournament is played in rounds, and in each round bots with
+			similar results are paired, so fewer matches are needed to rank many bots.
+			Each bot gets its own random seed for each match, derived from the seed of
+			the tournament and the number of the match, so a tournament can be repeated
+			with exactly the same results.
+*/
+class Arena : public ObjectCounter<Arena>
+{
+	public:
+		enum Schedule
+		{
+			ROUND_ROBIN,
+			SWISS
+		};
+
+		struct Settings
+		{
+			Settings();
+
+			/// names of the bot scripts in scripts/
+			std::vector<std::string> bots;
+			/// rules files in rules/
+			std::vector<std::string> rules;
+			Schedule schedule;
+			/// number of rounds of a swiss tournament
+			int rounds;
+			/// number of matches a pair of bots plays on each side, per rules file and round
+			int games;
+			int scoreToWin;
+			unsigned int difficulty;
+			unsigned int seed;
+			/// matches that take longer are counted as draw
+			unsigned int maxSteps;
+		};
+
+		/// indices of the bots playing on the left and right side
+		struct Pairing
+		{
+			int left;
+			int right;
+		};
+
+		struct MatchRecord
+		{
+			unsigned int index;
+			int round;
+			std::string rules;
+			int bot[MAX_PLAYERS];
+			HeadlessMatch::Result result;
+			/// time the simulation took, in seconds
+			double duration;
+		};
+
+		struct Standing
+		{
+			std::string bot;
+			int played;
+			int won;
+			int drawn;
+			int lost;
+			/// balls won and lost
+			int scored;
+			int conceded;
+			double elo;
+
+			/// a draw counts as half a win
+			double getWinRate() const;
+		};
+
+		explicit Arena(const Settings& settings);
+
+		/// plays all matches of the tournament on \p pool. \p progress is called
+		/// after each match from the worker threads, but never concurrently.
+		/// \throw whatever the creation of a bot or a match throws
+		void run(WorkStealingPool& pool, const std::function<void(const MatchRecord&)>& progress = nullptr);
+
+		/// all played matches, in schedule order
+		const std::vector<MatchRecord>& getMatches() const;
+		/// standings, best elo rating first. The ratings are calculated from the matches
+		/// in schedule order, so they do not depend on the order in which matches finished.
+		std::vector<Standing> getStandings() const;
+
+		void writeMatchesCSV(std::ostream& stream) const;
+		void writeStandingsCSV(std::ostream& stream) const;
+		void writeJSON(std::ostream& stream) const;
+
+		/// every bot plays every other bot \p games times on each side
+		static std::vector<Pairing> roundRobin(int bots, int games);
+		/// pairs bots with similar \p points. Among bots with the same distance in the
+		/// ranking, the one that was played less often (\p played[a][b]) is preferred.
+		/// With an odd number of bots, \p bye is set to the lowest ranked bot with the
+		/// fewest \p byes, which does not play this round. Otherwise it is -1.
+		static std::vector<Pairing> swissRound(const std::vector<double>& points,
+							const std::vector<std::vector<int>>& played, const std::vector<int>& byes, int& bye);
+		/// updates two elo ratings after a match. \p leftScore is 1 if left won,
+		/// 0 if right won and 0.5 for a draw.
+		static void updateElo(double& left, double& right, double leftScore);
+
+	private:
+		void playRound(WorkStealingPool& pool, int round, const std::vector<Pairing>& pairings,
+						const std::function<void(const MatchRecord&)>& progress);
+		void play(MatchRecord& record) const;
+
+		Settings mSettings;
+		std::vector<MatchRecord> mMatches;
+		std::mutex mProgressMutex;
+};
@@ -0,0 +1,180 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "WorkStealingPool.h"
+
+/* includes */
+#include <algorithm>
+#include <cassert>
+
+#include "Trace.h"
+
+/* implementation */
+
+namespace
+{
+	// the pool of the worker running on this thread, and the index of the worker in it.
+	// A worker can submit tasks to other pools, so the index is only valid for that pool.
+	thread_local const WorkStealingPool* currentPool = nullptr;
+	thread_local unsigned currentWorker = 0;
+}
+
+WorkStealingPool::WorkStealingPool(unsigned workers) :
+		mQueued(0), mPending(0), mNextQueue(0), mRunning(true), mStolen(0)
+{
+	if(workers == 0)
+		workers = std::max(std::thread::hardware_concurrency(), 1u);
+
+	for(unsigned i = 0; i < workers; ++i)
+		mQueues.emplace_back(new Queue);
+
+	for(unsigned i = 0; i < workers; ++i)
+		mThreads.emplace_back(&WorkStealingPool::work, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mAllDone.wait(lock, [this]() { return mPending == 0; });
+		mRunning = false;
+	}
+	mTaskAvailable.notify_all();
+
+	for(auto& thread : mThreads)
+		thread.join();
+}
+
+void WorkStealingPool::submit(Task task)
+{
+	unsigned index;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		index = currentPool == this ? currentWorker : mNextQueue++ % mQueues.size();
+		++mPending;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mQueues[index]->mutex);
+		mQueues[index]->tasks.push_back(std::move(task));
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		++mQueued;
+	}
+	mTaskAvailable.notify_one();
+}
+
+void WorkStealingPool::wait()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mAllDone.wait(lock, [this]() { return mPending == 0; });
+
+	if(mError)
+	{
+		std::exception_ptr error = mError;
+		mError = nullptr;
+		std::rethrow_exception(error);
+	}
+}
+
+unsigned WorkStealingPool::getWorkerCount() const
+{
+	return mThreads.size();
+}
+
+unsigned long WorkStealingPool::getStolenCount() const
+{
+	return mStolen;
+}
+
+bool WorkStealingPool::takeTask(unsigned index, Task& task)
+{
+	// newest task of the own queue
+	{
+		Queue& own = *mQueues[index];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if(!own.tasks.empty())
+		{
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			return true;
+		}
+	}
+
+	// oldest task of another queue
+	for(unsigned i = 1; i < mQueues.size(); ++i)
+	{
+		Queue& victim = *mQueues[(index + i) % mQueues.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if(!victim.tasks.empty())
+		{
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			++mStolen;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void WorkStealingPool::work(unsigned index)
+{
+	TRACE_THREAD_NAME("arena worker");
+	currentPool = this;
+	currentWorker = index;
+
+	while(true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mTaskAvailable.wait(lock, [this]() { return mQueued > 0 || !mRunning; });
+			if(mQueued == 0)
+				return;
+			// reserve a task. It may be in any queue, but it can't be taken by somebody else.
+			--mQueued;
+		}
+
+		// a task is only counted after it has been pushed, so there is one for every reservation
+		Task task;
+		bool found = takeTask(index, task);
+		assert(found);
+		(void)found;
+
+		try
+		{
+			task();
+		}
+		catch(...)
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if(!mError)
+				mError = std::current_exception();
+		}
+		task = nullptr;
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		if(--mPending == 0)
+			mAllDone.notify_all();
+	}
+}
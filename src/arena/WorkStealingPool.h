@@ -0,0 +1,88 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "BlobbyDebug.h"
+
+/*! \class WorkStealingPool
+	\brief runs independent tasks on a fixed number of worker threads
+	\details Every worker has its own queue. Tasks submitted by a worker of the pool are put into
+			its own queue, other tasks are distributed over all queues. A worker takes
+			the newest task of its own queue, and when that is empty, steals the oldest
+			task of another queue. So long and short tasks (e.g. matches that end 15:0
+			and matches that go to 20:18) are balanced without a central queue
+			all workers contend for.
+			If a task throws, the exception is rethrown by the next call to wait().
+*/
+class WorkStealingPool : public ObjectCounter<WorkStealingPool>
+{
+	public:
+		typedef std::function<void()> Task;
+
+		/// starts \p workers worker threads, or one per hardware thread if \p workers is 0.
+		explicit WorkStealingPool(unsigned workers = 0);
+		/// waits until all tasks are finished and stops the workers.
+		~WorkStealingPool();
+
+		void submit(Task task);
+		/// blocks until all submitted tasks are finished.
+		/// \throw the first exception thrown by a task since the last wait
+		void wait();
+
+		unsigned getWorkerCount() const;
+		/// number of tasks that were taken from the queue of another worker
+		unsigned long getStolenCount() const;
+
+	private:
+		struct Queue
+		{
+			std::mutex mutex;
+			std::deque<Task> tasks;
+		};
+
+		void work(unsigned index);
+		bool takeTask(unsigned index, Task& task);
+
+		std::vector<std::unique_ptr<Queue>> mQueues;
+		std::vector<std::thread> mThreads;
+
+		std::mutex mMutex;
+		std::condition_variable mTaskAvailable;
+		std::condition_variable mAllDone;
+		// tasks waiting in a queue, and tasks that are not yet finished
+		unsigned mQueued;
+		unsigned mPending;
+		unsigned mNextQueue;
+		bool mRunning;
+		std::exception_ptr mError;
+
+		std::atomic<unsigned long> mStolen;
+};
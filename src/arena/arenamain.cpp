@@ -0,0 +1,318 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "Arena.h"
+
+/* includes */
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include <boost/lexical_cast.hpp>
+
+#include "WorkStealingPool.h"
+#include "FileRead.h"
+#include "FileSystem.h"
+#include "GameLogic.h"
+#include "Global.h"
+
+#if __DESKTOP__
+#ifndef WIN32
+#include "config.h"
+#endif
+#endif
+
+/* implementation */
+
+static Arena::Settings g_settings;
+static unsigned g_workers = 0;
+static bool g_quiet = false;
+static std::string g_matches_csv;
+static std::string g_standings_csv;
+static std::string g_json;
+
+void printHelp();
+void process_arguments(int argc, char** argv);
+void setup_physfs(char* argv0);
+void printStandings(const Arena& arena, std::ostream& stream);
+void writeFile(const std::string& file, std::function<void(std::ostream&)> writer);
+
+int main(int argc, char** argv)
+{
+	process_arguments(argc, argv);
+
+	FileSystem fileSys(argv[0]);
+	setup_physfs(argv[0]);
+
+	if(g_settings.bots.empty())
+		g_settings.bots = fileSys.enumerateFiles("scripts", ".lua");
+
+	if(g_settings.bots.size() < 2)
+	{
+		std::cerr << "at least two bots are needed" << std::endl;
+		return 1;
+	}
+
+	for(auto& rules : g_settings.rules)
+	{
+		if(rules != FALLBACK_RULES_NAME)
+			rules = FileRead::makeLuaFilename(rules);
+	}
+
+	Arena arena(g_settings);
+	WorkStealingPool pool(g_workers);
+
+	std::cout << "playing a " << (g_settings.schedule == Arena::SWISS ? "swiss" : "round robin") << " tournament of "
+			<< g_settings.bots.size() << " bots with " << pool.getWorkerCount() << " threads" << std::endl;
+
+	auto start = std::chrono::steady_clock::now();
+	unsigned finished = 0;
+	try
+	{
+		arena.run(pool, [&finished](const Arena::MatchRecord& match)
+		{
+			++finished;
+			if(!g_quiet)
+			{
+				std::cerr << "\r" << finished << " matches played" << std::flush;
+			}
+		});
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << "\ntournament aborted: " << e.what() << std::endl;
+		return 2;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	if(!g_quiet)
+		std::cerr << "\n";
+	std::cout << arena.getMatches().size() << " matches in " << std::fixed << std::setprecision(1) << seconds << "s ("
+			<< std::setprecision(0) << arena.getMatches().size() / seconds * 60 << " per minute, "
+			<< pool.getStolenCount() << " stolen)\n\n";
+	printStandings(arena, std::cout);
+
+	if(!g_matches_csv.empty())
+		writeFile(g_matches_csv, [&arena](std::ostream& stream) { arena.writeMatchesCSV(stream); });
+	if(!g_standings_csv.empty())
+		writeFile(g_standings_csv, [&arena](std::ostream& stream) { arena.writeStandingsCSV(stream); });
+	if(!g_json.empty())
+		writeFile(g_json, [&arena](std::ostream& stream) { arena.writeJSON(stream); });
+}
+
+// -----------------------------------------------------------------------------------------
+
+void printStandings(const Arena& arena, std::ostream& stream)
+{
+	stream << std::left << std::setw(20) << "bot" << std::right << std::setw(8) << "played" << std::setw(6) << "won"
+			<< std::setw(6) << "drawn" << std::setw(6) << "lost" << std::setw(8) << "win %" << std::setw(8) << "balls"
+			<< std::setw(7) << "elo" << "\n";
+	for(const auto& standing : arena.getStandings())
+	{
+		stream << std::left << std::setw(20) << standing.bot << std::right << std::setw(8) << standing.played
+				<< std::setw(6) << standing.won << std::setw(6) << standing.drawn << std::setw(6) << standing.lost
+				<< std::setw(8) << std::setprecision(1) << standing.getWinRate() * 100
+				<< std::setw(8) << (standing.scored - standing.conceded)
+				<< std::setw(7) << std::setprecision(0) << standing.elo << "\n";
+	}
+}
+
+void writeFile(const std::string& file, std::function<void(std::ostream&)> writer)
+{
+	std::ofstream stream(file);
+	if(!stream)
+	{
+		std::cerr << "could not open " << file << std::endl;
+		return;
+	}
+	writer(stream);
+}
+
+// -----------------------------------------------------------------------------------------
+
+void printHelp()
+{
+	std::cout << "Usage: blobby-arena [OPTION...] [BOT...]" << std::endl;
+	std::cout << "Plays a tournament between the given bots from data/scripts, or all of them." << std::endl;
+	std::cout << "  -s, --schedule <name>        round-robin (default) or swiss" << std::endl;
+	std::cout << "  -r, --rules <file>           rules file from data/rules, can be given several times" << std::endl;
+	std::cout << "  -n, --rounds <n>             number of rounds of a swiss tournament (5)" << std::endl;
+	std::cout << "  -g, --games <n>              matches per pairing, side and round (1)" << std::endl;
+	std::cout << "  -w, --score-to-win <n>       score to win a match (15)" << std::endl;
+	std::cout << "  -d, --difficulty <n>         bot difficulty, 0 is the strongest (0)" << std::endl;
+	std::cout << "  -j, --jobs <n>               number of threads (one per core)" << std::endl;
+	std::cout << "      --seed <n>               seed for the random numbers of the bots (0)" << std::endl;
+	std::cout << "      --max-steps <n>          a match that takes longer is a draw" << std::endl;
+	std::cout << "      --csv <file>             write the matches as csv" << std::endl;
+	std::cout << "      --standings-csv <file>   write the standings as csv" << std::endl;
+	std::cout << "      --json <file>            write standings and matches as json" << std::endl;
+	std::cout << "  -q, --quiet                  don't print the progress" << std::endl;
+	std::cout << "  -h, --help                   This message\n" << std::endl;
+}
+
+// returns the argument of the option at argv[i], and advances i
+const char* option_argument(int argc, char** argv, int& i)
+{
+	if (i + 1 >= argc)
+	{
+		std::cout << "\"" << argv[i] << "\" option needs an argument" << std::endl;
+		printHelp();
+		exit(1);
+	}
+	return argv[++i];
+}
+
+template<class T>
+T numeric_argument(int argc, char** argv, int& i)
+{
+	const char* option = argv[i];
+	try
+	{
+		return boost::lexical_cast<T>( option_argument(argc, argv, i) );
+	}
+	catch (boost::bad_lexical_cast& e)
+	{
+		std::cout << "\"" << option << "\" option needs a number" << std::endl;
+		printHelp();
+		exit(1);
+	}
+}
+
+void process_arguments(int argc, char** argv)
+{
+	bool default_rules = true;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--schedule") == 0 || strcmp(argv[i], "-s") == 0)
+		{
+			std::string schedule = option_argument(argc, argv, i);
+			if (schedule == "swiss")
+				g_settings.schedule = Arena::SWISS;
+			else if (schedule == "round-robin")
+				g_settings.schedule = Arena::ROUND_ROBIN;
+			else
+			{
+				std::cout << "Unknown schedule \"" << schedule << "\"" << std::endl;
+				printHelp();
+				exit(1);
+			}
+			continue;
+		}
+		if (strcmp(argv[i], "--rules") == 0 || strcmp(argv[i], "-r") == 0)
+		{
+			if (default_rules)
+				g_settings.rules.clear();
+			default_rules = false;
+			g_settings.rules.push_back( option_argument(argc, argv, i) );
+			continue;
+		}
+		if (strcmp(argv[i], "--rounds") == 0 || strcmp(argv[i], "-n") == 0)
+		{
+			g_settings.rounds = numeric_argument<int>(argc, argv, i);
+			continue;
+		}
+		if (strcmp(argv[i], "--games") == 0 || strcmp(argv[i], "-g") == 0)
+		{
+			g_settings.games = numeric_argument<int>(argc, argv, i);
+			continue;
+		}
+		if (strcmp(argv[i], "--score-to-win") == 0 || strcmp(argv[i], "-w") == 0)
+		{
+			g_settings.scoreToWin = numeric_argument<int>(argc, argv, i);
+			continue;
+		}
+		if (strcmp(argv[i], "--difficulty") == 0 || strcmp(argv[i], "-d") == 0)
+		{
+			g_settings.difficulty = numeric_argument<unsigned int>(argc, argv, i);
+			continue;
+		}
+		if (strcmp(argv[i], "--jobs") == 0 || strcmp(argv[i], "-j") == 0)
+		{
+			g_workers = numeric_argument<unsigned>(argc, argv, i);
+			continue;
+		}
+		if (strcmp(argv[i], "--seed") == 0)
+		{
+			g_settings.seed = numeric_argument<unsigned int>(argc, argv, i);
+			continue;
+		}
+		if (strcmp(argv[i], "--max-steps") == 0)
+		{
+			g_settings.maxSteps = numeric_argument<unsigned int>(argc, argv, i);
+			continue;
+		}
+		if (strcmp(argv[i], "--csv") == 0)
+		{
+			g_matches_csv = option_argument(argc, argv, i);
+			continue;
+		}
+		if (strcmp(argv[i], "--standings-csv") == 0)
+		{
+			g_standings_csv = option_argument(argc, argv, i);
+			continue;
+		}
+		if (strcmp(argv[i], "--json") == 0)
+		{
+			g_json = option_argument(argc, argv, i);
+			continue;
+		}
+		if (strcmp(argv[i], "--quiet") == 0 || strcmp(argv[i], "-q") == 0)
+		{
+			g_quiet = true;
+			continue;
+		}
+		if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0)
+		{
+			printHelp();
+			exit(0);
+		}
+		if (argv[i][0] == '-')
+		{
+			std::cout << "Unknown option \"" << argv[i] << "\"" << std::endl;
+			printHelp();
+			exit(1);
+		}
+		g_settings.bots.push_back(argv[i]);
+	}
+
+	if (g_settings.games < 1 || g_settings.rounds < 1 || g_settings.scoreToWin < 1)
+	{
+		std::cout << "games, rounds and score to win have to be positive" << std::endl;
+		exit(1);
+	}
+}
+
+void setup_physfs(char* argv0)
+{
+	FileSystem& fs = FileSystem::getSingleton();
+
+	#if __DESKTOP__
+	#ifndef WIN32
+		fs.addToSearchPath(BLOBBY_INSTALL_PREFIX  "/share/blobby");
+		fs.addToSearchPath(BLOBBY_INSTALL_PREFIX  "/share/blobby/rules.zip");
+	#endif
+	#endif
+	fs.addToSearchPath("data");
+	fs.addToSearchPath("data" + fs.getDirSeparator() + "rules.zip");
+}
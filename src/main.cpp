@@ -271,6 +271,8 @@ void setupPHYSFS()
 
 		SpeedController scontroller(gameConfig.getFloat("gamefps"));
 		SpeedController::setMainInstance(&scontroller);
+		scontroller.setTimingMode(SpeedController::DEADLINE_TIMING);
+		scontroller.setSpinBudget(std::chrono::microseconds(gameConfig.getInteger("timing_spin_budget", 1000)));
 		scontroller.setDrawFPS(gameConfig.getBool("showfps"));
 
 		smanager = SoundManager::createSoundManager();
@@ -43,6 +43,7 @@
 #include "GetTime.h"
 #include "PacketEnumerations.h"
 #include "PacketPool.h"
+#include "../Trace.h"
 
 // alloca
 #ifdef _WIN32
@@ -563,6 +564,8 @@ bool RakPeer::Send( const char *data, const long length, PacketPriority priority
 
 bool RakPeer::Send( const RakNet::BitStream * bitStream, PacketPriority priority, PacketReliability reliability, char orderingChannel, PlayerID playerId, bool broadcast )
 {
+	TRACE_SCOPE("RakPeer::Send");
+
 #ifdef _DEBUG
 	assert( bitStream->GetNumberOfBytesUsed() > 0 );
 #endif
@@ -1626,6 +1629,8 @@ void ProcessNetworkPacket( unsigned int binaryAddress, unsigned short port, cons
 // --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 bool RakPeer::RunUpdateCycle( void )
 {
+	TRACE_SCOPE("RakPeer::RunUpdateCycle");
+
 	RakPeer::RemoteSystemStruct * remoteSystem;
 	unsigned remoteSystemIndex;
 	Packet *packet;
@@ -2205,6 +2210,7 @@ void* UpdateNetworkLoop( void* arguments )
 {
 	RakPeer * rakPeer = ( RakPeer * ) arguments;
 
+	TRACE_THREAD_NAME("network");
 	rakPeer->isMainLoopThreadActive = true;
 
 	while ( rakPeer->endThreads == false )
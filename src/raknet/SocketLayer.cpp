@@ -55,7 +55,7 @@ extern void ProcessNetworkPacket( unsigned int binaryAddress, unsigned short por
 #include <cstdio>
 #endif
 
-SocketLayer::SocketLayer()
+SocketLayer::SocketLayer() : bytesSent(0), bytesReceived(0)
 {
 	// Check if the socketlayer is already started
 	if (socketLayerInstanceCount == 0)
@@ -253,6 +253,7 @@ int SocketLayer::RecvFrom( SOCKET s, RakPeer *rakPeer, int *errorCode )
 
 	if ( len != SOCKET_ERROR )
 	{
+		bytesReceived += len;
 		portnum = ntohs( sa.sin_port );
 		//strcpy(ip, inet_ntoa(sa.sin_addr));
 		//if (strcmp(ip, "0.0.0.0")==0)
@@ -315,7 +316,10 @@ int SocketLayer::SendTo( SOCKET s, const char *data, int length, unsigned int bi
 	while ( len == 0 );
 
 	if ( len != SOCKET_ERROR )
+	{
+		bytesSent += len;
 		return 0;
+	}
 
 
 #if defined(_WIN32)
@@ -419,6 +423,16 @@ int SocketLayer::nameToIpStrings(char const * const name, char* const buffer, in
 	return count;
 }
 
+unsigned long long SocketLayer::GetBytesSent() const
+{
+	return bytesSent;
+}
+
+unsigned long long SocketLayer::GetBytesReceived() const
+{
+	return bytesReceived;
+}
+
 
 char const * SocketLayer::ipToString(struct sockaddr const * const socketaddress, char * const buffer, int const bufferSize)
 {
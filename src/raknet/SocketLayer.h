@@ -55,6 +55,8 @@ static const SOCKET INVALID_SOCKET = -1;
 #define SOCKET_ERROR -1
 #endif
 
+#include <atomic>
+
 class RakPeer;
 
 /**
@@ -158,6 +160,11 @@ public:
 	/// @todo This is only for IPv4 but can easilly updated to IPv4/IPv6 or IPv6 only
 	int nameToIpStrings(char const * const name, char* const buffer, int const bufferEntrySize, int const bufferEntryCount);
 
+	/// Number of bytes sent with SendTo, by all peers of this process
+	unsigned long long GetBytesSent() const;
+	/// Number of bytes received with RecvFrom, by all peers of this process
+	unsigned long long GetBytesReceived() const;
+
 private:	
 	/// @brief Convert a socketaddress to an ip string
 	/// @param socketaddress Socketaddress
@@ -175,6 +182,12 @@ private:
 	 * Singleton instance
 	 */
 	static SocketLayer I;
+
+	/**
+	 * Traffic counters, updated from the network threads of all peers
+	 */
+	std::atomic<unsigned long long> bytesSent;
+	std::atomic<unsigned long long> bytesReceived;
 };
 
 #endif
@@ -41,6 +41,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "PhysicState.h"
 #include "GenericIO.h"
 #include "FileRead.h"
+#include "ScriptCache.h"
 #include "FileWrite.h"
 #include "base64.h"
 
@@ -222,9 +223,7 @@ void ReplayRecorder::setGameSpeed(int fps)
 
 void ReplayRecorder::setGameRules( std::string rules )
 {
-	FileRead file(FileRead::makeLuaFilename("rules/"+rules));
-	mGameRules.resize( file.length() );
-	file.readRawBytes(&*mGameRules.begin(), file.length());
+	mGameRules = ScriptCache::get("rules/" + rules)->source;
 	boost::algorithm::trim_all(mGameRules);
 }
 
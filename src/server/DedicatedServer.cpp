@@ -25,6 +25,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <iostream>
 
 #include <boost/make_shared.hpp>
+#include <boost/weak_ptr.hpp>
 
 #include "raknet/RakServer.h"
 #include "raknet/PacketEnumerations.h"
@@ -32,6 +33,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "NetworkMessage.h"
 #include "NetworkGame.h"
 #include "GenericIO.h"
+#include "Metrics.h"
+#include "Trace.h"
 
 #ifndef WIN32
 #ifndef __ANDROID__
@@ -39,10 +42,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #endif
 #endif
 
-extern int SWLS_PacketCount;
-extern int SWLS_Connections;
-extern int SWLS_Games;
-
 void syslog(int pri, const char* format, ...);
 
 DedicatedServer::DedicatedServer(const ServerInfo& info,
@@ -54,6 +53,11 @@ DedicatedServer::DedicatedServer(const ServerInfo& info,
 , mAcceptNewPlayers(true)
 , mPlayerHosted( local_server )
 , mServerInfo(info)
+, mSnapshotInterval(2)
+, mGameRouting(boost::make_shared<GameRoutingTable>())
+, mPacketQueue(PACKET_QUEUE_SIZE)
+// a player hosted server only runs a single game, so it does not need more than one worker
+, mGameScheduler( local_server ? 1 : 0 )
 {
 	if (!mServer->Start(max_clients, 1, mServerInfo.port))
 	{
@@ -76,6 +80,12 @@ DedicatedServer::DedicatedServer(const ServerInfo& info,
 		mMatchMaker.addRuleOption( f );
 
 	mServer->setUpdateCallback([this](){ queuePackets(); });
+
+	mGameScheduler.setTickObserver([](GameScheduler::clock_type::duration lag, GameScheduler::clock_type::duration duration)
+		{
+			getServerMetrics().tickLag.observe(lag);
+			getServerMetrics().tickDuration.observe(duration);
+		});
 }
 
 DedicatedServer::~DedicatedServer()
@@ -85,10 +95,12 @@ DedicatedServer::~DedicatedServer()
 
 void DedicatedServer::queuePackets()
 {
+	TRACE_SCOPE("DedicatedServer::queuePackets");
+
 	packet_ptr packet;
 	while ((packet = mServer->Receive()))
 	{
-		SWLS_PacketCount++;
+		getServerMetrics().packetsReceived.add();
 
 		switch(packet->data[0])
 		{
@@ -100,26 +112,27 @@ void DedicatedServer::queuePackets()
 			case ID_LOBBY:
 			case ID_BLOBBY_SERVER_PRESENT:
 			{
-				std::lock_guard<std::mutex> lock( mPacketQueueMutex );
-				mPacketQueue.push_back( packet );
+				if( !mPacketQueue.push( packet ) )
+					syslog(LOG_ERR, "server packet queue is full, packet %d has to wait in the overflow list", int(packet->data[0]));
 				break;
 			}
 			// game progress packets
 			case ID_INPUT_UPDATE:
+			case ID_INPUT_HISTORY:
 			case ID_PAUSE:
 			case ID_UNPAUSE:
 			case ID_CHAT_MESSAGE:
 			case ID_REPLAY:
 			case ID_RULES:
 			{
-				// disallow player map changes while we sort out packets!
-				std::lock_guard<std::mutex> lock( mPlayerMapMutex );
+				// the routing table is never modified, only replaced, so we can use it without locking
+				auto routing = boost::atomic_load( &mGameRouting );
 
-				auto player = mPlayerMap.find(packet->playerId);
-				// delete the disconnectiong player
-				if( player != mPlayerMap.end() && player->second->getGame() )
+				auto player = routing->find(packet->playerId);
+				auto game = player != routing->end() ? player->second.lock() : boost::shared_ptr<NetworkGame>();
+				if( game )
 				{
-					player->second->getGame() ->injectPacket( packet );
+					game->injectPacket( packet );
 				} else {
 					syslog(LOG_ERR, "received packet from player not in playerlist!");
 				}
@@ -134,22 +147,21 @@ void DedicatedServer::queuePackets()
 
 void DedicatedServer::processPackets()
 {
-	while (!mPacketQueue.empty())
+	TRACE_SCOPE("DedicatedServer::processPackets");
+
+	ServerMetrics& metrics = getServerMetrics();
+	packet_ptr packet;
+	int queued = 0;
+	while (mPacketQueue.pop(packet))
 	{
-		packet_ptr packet;
-		{
-			std::lock_guard<std::mutex> lock(mPacketQueueMutex);
-			packet = mPacketQueue.front();
-			mPacketQueue.pop_front();
-		}
-		SWLS_PacketCount++;
+		++queued;
 
 		switch(packet->data[0])
 		{
 			// connection status changes
 			case ID_NEW_INCOMING_CONNECTION:
 				mConnectedClients++;
-				SWLS_Connections++;
+				metrics.connections.add();
 				syslog(LOG_DEBUG, "New incoming connection from %s, %d clients connected now", packet->playerId.toString().c_str(), mConnectedClients);
 
 				if ( !mAcceptNewPlayers )
@@ -176,12 +188,11 @@ void DedicatedServer::processPackets()
 					if( player->second->getGame() )
 						player->second->getGame()->injectPacket( packet );
 
-					// no longer count this player as connected. protect this change with a mutex
-					{
-						std::lock_guard<std::mutex> lock( mPlayerMapMutex );
-						mPlayerMap.erase( player );
-					}
-					mMatchMaker.removePlayer( player->first );
+					// no longer count this player as connected.
+					PlayerID id = player->first;
+					mPlayerMap.erase( player );
+					updateGameRouting();
+					mMatchMaker.removePlayer( id );
 				}
 				 else
 				{
@@ -200,11 +211,8 @@ void DedicatedServer::processPackets()
 
 				auto newplayer = boost::make_shared<NetworkPlayer>(packet->playerId, stream);
 
-				// add to player map. protect with mutex
-				{
-					std::lock_guard<std::mutex> lock( mPlayerMapMutex );
-					mPlayerMap[packet->playerId] = newplayer;
-				}
+				// add to player map.
+				mPlayerMap[packet->playerId] = newplayer;
 				mMatchMaker.addPlayer(packet->playerId, newplayer);
 				syslog(LOG_DEBUG, "New player \"%s\" connected from %s ", newplayer->getName().c_str(), packet->playerId.toString().c_str());
 
@@ -237,29 +245,22 @@ void DedicatedServer::processPackets()
 				syslog(LOG_DEBUG, "Unknown packet %d received\n", int(packet->data[0]));
 		}
 	}
+
+	metrics.serverQueueDepth.observe(queued);
+	metrics.connectedClients.set(mConnectedClients);
 }
 
 
 void DedicatedServer::updateGames()
 {
+	TRACE_SCOPE("DedicatedServer::updateGames");
+
 	// update new game creation for locally hosted games.
 	if( mPlayerHosted )
 	{
 		mMatchMaker.setAllowNewGames(mMatchMaker.getOpenGamesCount() == 0);
 	}
 
-	// this loop ensures that all games that have finished (eg because one
-	// player left) still process network packets, to let the other player
-	// finalize its interactions (sending replays etc).
-	for(auto it = mPlayerMap.begin(); it != mPlayerMap.end(); ++it)
-	{
-		auto game = it->second->getGame();
-		if(game && !game->isGameValid())
-		{
-			game->processPackets();
-		}
-	}
-
 	// remove dead games from gamelist
 	for (auto iter = mGameList.begin(); iter != mGameList.end();  )
 	{
@@ -269,6 +270,7 @@ void DedicatedServer::updateGames()
 					(*iter)->getPlayerID(LEFT_PLAYER).toString().c_str(),
 					(*iter)->getPlayerID(RIGHT_PLAYER).toString().c_str()
 					);
+			mFinishedGames.push_back(*iter);
 			iter = mGameList.erase(iter);
 		}
 		 else
@@ -276,6 +278,30 @@ void DedicatedServer::updateGames()
 			++iter;
 		}
 	}
+
+	// finished games are released here, on the server thread: once no player references a game
+	// anymore, it is retired, and it is destroyed as soon as its scheduler task has dropped its reference.
+	for (auto iter = mFinishedGames.begin(); iter != mFinishedGames.end();  )
+	{
+		auto& game = *iter;
+		if( !game->isRetired() && std::none_of(mPlayerMap.begin(), mPlayerMap.end(),
+				[&game](const std::pair<const PlayerID, boost::shared_ptr<NetworkPlayer>>& player)
+				{ return player.second->getGame() == game; }) )
+		{
+			game->retire();
+		}
+
+		if( game->isRetired() && game.use_count() == 1 )
+		{
+			iter = mFinishedGames.erase(iter);
+		}
+		 else
+		{
+			++iter;
+		}
+	}
+
+	getServerMetrics().runningGames.set(mGameList.size());
 }
 
 bool DedicatedServer::hasActiveGame() const
@@ -308,6 +334,21 @@ void DedicatedServer::allowNewPlayers( bool allow )
 	mAcceptNewPlayers = allow;
 }
 
+void DedicatedServer::setGameSpinBudget( std::chrono::microseconds budget )
+{
+	mGameScheduler.setSpinBudget( budget );
+}
+
+void DedicatedServer::setSnapshotInterval( unsigned int interval )
+{
+	mSnapshotInterval = interval;
+}
+
+TimingStatistics DedicatedServer::getGameTimingStatistics() const
+{
+	return mGameScheduler.getTimingStatistics();
+}
+
 // debug
 void DedicatedServer::printAllPlayers(std::ostream& stream) const
 {
@@ -394,13 +435,45 @@ void DedicatedServer::createGame(boost::shared_ptr<NetworkPlayer> left,
 {
 	auto newgame = boost::make_shared<NetworkGame>(*mServer.get(), left, right,
 								switchSide, rules, scoreToWin, gamespeed);
+	newgame->setSnapshotInterval( mSnapshotInterval );
 	left->setGame( newgame );
 	right->setGame( newgame );
 
-	SWLS_Games++;
+	getServerMetrics().gamesStarted.add();
+
+	// games that have finished (eg because one player left) still process network packets, to let
+	// the other player finalize its interactions (sending replays etc). The scheduler is the only
+	// consumer of the packet queue of the game. The task keeps a reference to the game until the
+	// server retires it, so the game is never destroyed on a worker thread (see updateGames).
+	mGameScheduler.addTask([newgame]()
+		{
+			if(newgame->isRetired())
+				return false;
+
+			newgame->processPackets();
+			if(newgame->isGameValid())
+			{
+				newgame->step();
+				getServerMetrics().gameSteps.add();
+			}
+			return true;
+		}, gamespeed);
 
 	/// \todo add some logging?
 	syslog(LOG_DEBUG, "Created game \"%s\" vs. \"%s\", rules:%s", left->getName().c_str(), right->getName().c_str(), rules.c_str());
 	mGameList.push_back(newgame);
+	updateGameRouting();
+}
+
+void DedicatedServer::updateGameRouting()
+{
+	auto routing = boost::make_shared<GameRoutingTable>();
+	for( auto& player : mPlayerMap )
+	{
+		if( player.second->getGame() )
+			(*routing)[player.first] = player.second->getGame();
+	}
+
+	boost::atomic_store( &mGameRouting, boost::shared_ptr<const GameRoutingTable>(routing) );
 }
 
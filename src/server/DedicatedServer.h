@@ -23,14 +23,15 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <string>
 #include <map>
 #include <list>
-#include <mutex>
-#include <deque>
 #include <iosfwd>
 #include <boost/scoped_ptr.hpp>
+#include <boost/weak_ptr.hpp>
 
 #include "NetworkPlayer.h"
 #include "NetworkMessage.h"
 #include "server/MatchMaker.h"
+#include "server/GameScheduler.h"
+#include "server/OverflowQueue.h"
 
 class RakServer;
 
@@ -66,6 +67,8 @@ class DedicatedServer
 		int getActiveGamesCount() const;
 		int getWaitingPlayers() const;
 		int getConnectedClients() const;
+		/// timing accuracy of the game steps
+		TimingStatistics getGameTimingStatistics() const;
 
 		const ServerInfo& getServerInfo() const;
 
@@ -76,6 +79,10 @@ class DedicatedServer
 
 		// server settings
 		void allowNewPlayers( bool allow );
+		/// sets how long the game workers busy wait before a step is due
+		void setGameSpinBudget( std::chrono::microseconds budget );
+		/// sets after how many steps new games send delta snapshots to the clients
+		void setSnapshotInterval( unsigned int interval );
 
 	private:
 		// packet handling functions / utility functions
@@ -84,6 +91,9 @@ class DedicatedServer
 		// does not add the game to the active game list
 		void createGame(boost::shared_ptr<NetworkPlayer> left, boost::shared_ptr<NetworkPlayer> right,
 						PlayerSide switchSide, std::string rules, int scoreToWin, float gamespeed);
+		// rebuilds the routing table from the player map. has to be called after
+		// each change of the player map or of the game of a player.
+		void updateGameRouting();
 		// broadcasts the current server  status to all waiting clients
 
 		// member variables
@@ -99,15 +109,28 @@ class DedicatedServer
 		bool mPlayerHosted;
 		// server info with server config
 		ServerInfo mServerInfo;
+		// number of game steps between two snapshots
+		unsigned int mSnapshotInterval;
 
 		// containers for all games and mapping players to their games
 		std::list< boost::shared_ptr<NetworkGame> > mGameList;
+		// games that have finished, but may still be referenced by their players or their scheduler task
+		std::list< boost::shared_ptr<NetworkGame> > mFinishedGames;
 		std::map< PlayerID, boost::shared_ptr<NetworkPlayer>> mPlayerMap;
-		std::mutex mPlayerMapMutex;
 
-		// packet queue
-		std::deque<packet_ptr> mPacketQueue;
-		std::mutex mPacketQueueMutex;
+		// immutable snapshot of the player -> game mapping, used to route game packets
+		// on the raknet thread. it is replaced as a whole (with boost::atomic_store), so
+		// the raknet thread never has to wait for the main thread.
+		typedef std::map< PlayerID, boost::weak_ptr<NetworkGame> > GameRoutingTable;
+		boost::shared_ptr<const GameRoutingTable> mGameRouting;
+
+		// queue for lobby and connection packets. filled by the raknet thread
+		OverflowQueue<packet_ptr> mPacketQueue;
+		static const int PACKET_QUEUE_SIZE = 1024;
 
 		MatchMaker mMatchMaker;
+
+		// worker threads that run the games. declared last, so it is destroyed
+		// (and its workers are stopped) before any of the other members.
+		GameScheduler mGameScheduler;
 };
@@ -0,0 +1,177 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "GameScheduler.h"
+
+/* includes */
+#include <algorithm>
+#include <cassert>
+
+#include "Trace.h"
+
+/* implementation */
+
+const int GameScheduler::MAX_LAG_PERIODS;
+
+GameScheduler::GameScheduler(unsigned workers) : mRunningTasks(0), mRunning(true), mSpinBudget(clock_type::duration::zero())
+{
+	if(workers == 0)
+		workers = std::thread::hardware_concurrency();
+	// hardware_concurrency may return 0 if the value is not computable
+	if(workers == 0)
+		workers = 1;
+
+	for(unsigned i = 0; i < workers; ++i)
+	{
+		mWorkers.push_back( std::thread([this](){ workerLoop(); }) );
+	}
+}
+
+GameScheduler::~GameScheduler()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mRunning = false;
+	}
+	mTaskChanged.notify_all();
+
+	for(auto& worker : mWorkers)
+		worker.join();
+}
+
+void GameScheduler::addTask(TickFunction tick, float rate)
+{
+	assert(rate > 0);
+
+	Task task;
+	task.tick = tick;
+	task.period = std::chrono::duration_cast<clock_type::duration>( std::chrono::duration<double>(1.0 / rate) );
+	task.deadline = clock_type::now();
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	pushTask(task);
+}
+
+void GameScheduler::setSpinBudget(clock_type::duration budget)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mSpinBudget = budget;
+}
+
+TimingStatistics GameScheduler::getTimingStatistics() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mStatistics;
+}
+
+void GameScheduler::setTickObserver(TickObserver observer)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mTickObserver = observer;
+}
+
+unsigned GameScheduler::getWorkerCount() const
+{
+	return mWorkers.size();
+}
+
+unsigned GameScheduler::getTaskCount() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mTasks.size() + mRunningTasks;
+}
+
+bool GameScheduler::laterDeadline(const Task& a, const Task& b)
+{
+	return a.deadline > b.deadline;
+}
+
+// mMutex has to be locked when calling this function
+void GameScheduler::pushTask(const Task& task)
+{
+	mTasks.push_back(task);
+	std::push_heap(mTasks.begin(), mTasks.end(), &GameScheduler::laterDeadline);
+
+	// if the new task is due earlier than all others, the waiting workers have to
+	// recalculate their wakeup time.
+	if( mTasks.front().deadline == task.deadline )
+		mTaskChanged.notify_one();
+}
+
+void GameScheduler::workerLoop()
+{
+	TRACE_THREAD_NAME("game worker");
+
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	while(mRunning)
+	{
+		if(mTasks.empty())
+		{
+			mTaskChanged.wait(lock);
+			continue;
+		}
+
+		// wait until the earliest deadline (minus the spin budget) has been reached.
+		// Adding a more urgent task or shutting down the scheduler wakes us up early.
+		clock_type::time_point wakeup = mTasks.front().deadline - mSpinBudget;
+		if(clock_type::now() < wakeup)
+		{
+			mTaskChanged.wait_until(lock, wakeup);
+			continue;
+		}
+
+		std::pop_heap(mTasks.begin(), mTasks.end(), &GameScheduler::laterDeadline);
+		Task task = std::move(mTasks.back());
+		mTasks.pop_back();
+		++mRunningTasks;
+
+		// there might be more tasks that are due, so let another worker have a look
+		if(!mTasks.empty())
+			mTaskChanged.notify_one();
+
+		const clock_type::duration spin = mSpinBudget;
+		const TickObserver observer = mTickObserver;
+		lock.unlock();
+		// spin for the remaining time. the task is already taken, so no other
+		// worker will wait for it.
+		clock_type::time_point start = SpeedController::waitUntil(task.deadline, spin);
+		bool keep = task.tick();
+		clock_type::time_point end = clock_type::now();
+		if(observer)
+			observer(start - task.deadline, end - start);
+		lock.lock();
+
+		mStatistics.add(start - task.deadline);
+		--mRunningTasks;
+		if(!keep)
+			continue;
+
+		// advance the deadline by exactly one period, so we don't accumulate errors.
+		// if we lag behind too much, we don't try to catch up.
+		task.deadline += task.period;
+		clock_type::time_point now = clock_type::now();
+		if(task.deadline + MAX_LAG_PERIODS * task.period < now)
+			task.deadline = now;
+
+		pushTask(task);
+	}
+}
@@ -0,0 +1,105 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "BlobbyDebug.h"
+#include "SpeedController.h"
+
+/*! \class GameScheduler
+	\brief runs periodic tasks (network games) on a fixed pool of worker threads.
+	\details Each task has its own tick rate. The scheduler keeps an absolute deadline
+			for each task and always hands the task with the earliest deadline to the
+			next free worker, so the number of OS threads no longer grows with the number
+			of running games. A task is never ticked by two workers at the same time.
+			Deadlines advance by exactly one period per tick, so rounding errors do not
+			accumulate. If a task falls behind by more than MAX_LAG_PERIODS periods (e.g.
+			because all workers were busy), its deadline is reset instead of letting
+			it catch up with a burst of ticks.
+			Workers sleep until the spin budget before a deadline and busy wait for the
+			rest of the time, like SpeedController in DEADLINE_TIMING mode. The
+			overshoot of each tick is collected in the timing statistics, and can
+			be reported to a tick observer together with the duration of the tick.
+*/
+class GameScheduler : public ObjectCounter<GameScheduler>
+{
+	public:
+		typedef std::chrono::steady_clock clock_type;
+		/// tick function of a task. When it returns false, the task is removed.
+		typedef std::function<bool()> TickFunction;
+		/// called after each tick with the overshoot of the tick and the time the tick took.
+		typedef std::function<void(clock_type::duration lag, clock_type::duration duration)> TickObserver;
+
+		/// creates the scheduler and starts \p workers worker threads.
+		/// if \p workers is 0, one worker per hardware thread is started.
+		explicit GameScheduler(unsigned workers = 0);
+		~GameScheduler();
+
+		/// adds a task that is ticked \p rate times a second.
+		/// The first tick is scheduled immediately.
+		void addTask(TickFunction tick, float rate);
+
+		/// sets how long before a deadline workers stop sleeping and start busy waiting.
+		/// defaults to 0, because spinning costs cpu time for each running game.
+		void setSpinBudget(clock_type::duration budget);
+		TimingStatistics getTimingStatistics() const;
+		/// sets the function that is called after each tick. It is called from the worker
+		/// threads without holding the scheduler lock, so it may be called by several
+		/// workers at once.
+		void setTickObserver(TickObserver observer);
+
+		unsigned getWorkerCount() const;
+		/// number of tasks that are currently scheduled or running
+		unsigned getTaskCount() const;
+
+		static const int MAX_LAG_PERIODS = 5;
+
+	private:
+		struct Task
+		{
+			TickFunction tick;
+			clock_type::duration period;
+			clock_type::time_point deadline;
+		};
+
+		// comparison for the task heap: the earliest deadline is at the front
+		static bool laterDeadline(const Task& a, const Task& b);
+
+		void pushTask(const Task& task);
+		void workerLoop();
+
+		std::vector<std::thread> mWorkers;
+
+		mutable std::mutex mMutex;
+		std::condition_variable mTaskChanged;
+		std::vector<Task> mTasks;	// heap ordered by deadline
+		unsigned mRunningTasks;
+		bool mRunning;
+		clock_type::duration mSpinBudget;
+		TimingStatistics mStatistics;
+		TickObserver mTickObserver;
+};
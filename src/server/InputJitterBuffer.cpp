@@ -0,0 +1,214 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "InputJitterBuffer.h"
+
+/* includes */
+#include <algorithm>
+
+/* implementation */
+
+InputJitterBuffer::InputJitterBuffer() : mActive(false), mSparse(false), mBuffering(true), mInSequence(false), mNextTick(0),
+				mNewestTick(0), mAssumedTick(0), mTick(0), mDelay(INITIAL_DELAY), mPeriodSteps(0), mPeriodLate(0), mMinReserve(0)
+{
+	for(auto& slot : mSlots)
+		slot.valid = false;
+}
+
+void InputJitterBuffer::push(unsigned int tick, const PlayerInputAbs& input)
+{
+	if(!mActive)
+	{
+		mActive = true;
+		restart(tick);
+	}
+
+	int ahead = tick - mNextTick;
+	Slot& slot = mSlots[tick % SIZE];
+	if(slot.valid && slot.tick == tick)
+	{
+		// in sparse mode, the step may have been simulated with a different input than
+		// the one that arrives now
+		if(ahead < 0 && !(slot.input == input))
+			late();
+		return;
+	}
+
+	if(ahead < 0)
+	{
+		late();
+		return;
+	}
+	// the client is so far ahead that the buffer can't hold its inputs (e.g. after a long
+	// period without network connection), so start again
+	if(ahead >= SIZE)
+		restart(tick);
+
+	slot.valid = true;
+	slot.tick = tick;
+	slot.input = input;
+	mStatistics.received++;
+
+	if((int)(tick - mNewestTick) > 0)
+	{
+		mNewestTick = tick;
+		mAssumedTick = tick;
+	}
+}
+
+bool InputJitterBuffer::pop(PlayerInputAbs& input)
+{
+	mInSequence = false;
+	if(!mActive)
+		return false;
+
+	// the client has produced another tick since
+	mAssumedTick++;
+	int reserve = getReserve();
+
+	if(mBuffering)
+	{
+		if(reserve < (int)mDelay)
+			return false;
+		mBuffering = false;
+		mPeriodSteps = 0;
+		mPeriodLate = mStatistics.late;
+		mMinReserve = reserve;
+	}
+
+	if(reserve < 0)
+	{
+		// the inputs of the client arrive later than expected, so keep more of them in reserve
+		mStatistics.underruns++;
+		if(mDelay < MAX_DELAY)
+			mDelay++;
+		mBuffering = true;
+		return false;
+	}
+
+	mMinReserve = std::min(mMinReserve, reserve);
+	if(++mPeriodSteps >= ADAPTION_PERIOD)
+	{
+		// we always had more inputs than necessary, so the delay can be reduced. in
+		// sparse mode, the reserve says nothing about the network, so we look at late inputs.
+		bool relaxed = mSparse ? mPeriodLate == mStatistics.late : mMinReserve > 1;
+		if(relaxed && mDelay > 0)
+			mDelay--;
+		// skip an input if there are clearly more of them than the delay requires, e.g.
+		// because the clock of the client is a little faster
+		if(mMinReserve > (int)mDelay + 2)
+		{
+			mStatistics.dropped++;
+			mNextTick++;
+		}
+		mPeriodSteps = 0;
+		mPeriodLate = mStatistics.late;
+		mMinReserve = getReserve();
+	}
+
+	// consumed inputs stay in the buffer, so duplicates of them can be recognized
+	Slot& slot = mSlots[mNextTick % SIZE];
+	bool found = slot.valid && slot.tick == mNextTick;
+	// in sparse mode, a tick that was not sent repeats the input, just like the client did.
+	// the steps before the first input did not use inputs of the client at all.
+	mInSequence = mTick != 0 && mNextTick == mTick + 1 && (found || mSparse);
+	mTick = mNextTick;
+	mNextTick++;
+
+	if(!found)
+	{
+		if(mSparse)
+		{
+			// the client did not send this tick because the input did not change
+			slot.valid = true;
+			slot.tick = mTick;
+			slot.input = mInput;
+		}
+		 else
+		{
+			mStatistics.dropped++;
+		}
+		return false;
+	}
+
+	mInput = slot.input;
+	input = slot.input;
+	return true;
+}
+
+void InputJitterBuffer::setSparse(bool sparse)
+{
+	mSparse = sparse;
+}
+
+bool InputJitterBuffer::isActive() const
+{
+	return mActive;
+}
+
+bool InputJitterBuffer::isInSequence() const
+{
+	return mInSequence;
+}
+
+unsigned int InputJitterBuffer::getTick() const
+{
+	return mTick;
+}
+
+unsigned int InputJitterBuffer::getDelay() const
+{
+	return mDelay;
+}
+
+const InputStatistics& InputJitterBuffer::getStatistics() const
+{
+	return mStatistics;
+}
+
+void InputJitterBuffer::restart(unsigned int tick)
+{
+	for(auto& slot : mSlots)
+		slot.valid = false;
+	mNextTick = tick;
+	mNewestTick = tick;
+	mAssumedTick = tick;
+	mBuffering = true;
+}
+
+void InputJitterBuffer::late()
+{
+	mStatistics.late++;
+	// in sparse mode, the buffer never runs empty, so the late inputs tell us that
+	// we need more inputs in reserve
+	if(mSparse && mDelay < MAX_DELAY)
+	{
+		mDelay++;
+		mBuffering = true;
+	}
+}
+
+int InputJitterBuffer::getReserve() const
+{
+	// number of inputs after the next one which have already arrived (or were lost).
+	// in sparse mode, the ticks the client did not send count as well
+	return (mSparse ? mAssumedTick : mNewestTick) - mNextTick;
+}
@@ -0,0 +1,119 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+
+#pragma once
+
+#include "PlayerInput.h"
+#include "BlobbyDebug.h"
+
+/// \brief statistics about the inputs of one player
+struct InputStatistics
+{
+	/// inputs that arrived in time
+	unsigned received = 0;
+	/// inputs that arrived after their step had been simulated
+	unsigned late = 0;
+	/// steps that were simulated without the input of the client, because it was lost
+	/// or skipped to reduce the delay
+	unsigned dropped = 0;
+	/// number of times the buffer ran empty and the game had to wait for inputs
+	unsigned underruns = 0;
+};
+
+/*! \class InputJitterBuffer
+	\brief buffers the tick stamped inputs of a network player
+	\details The client numbers its inputs with its own frame counter. Instead of using
+			whatever input arrived last when the game steps, the server puts the inputs
+			into this buffer and consumes exactly one input per step, in the order of
+			the ticks. So inputs that arrive together are not lost, and inputs that are a
+			little late are still used.
+			The buffer keeps a small number of inputs in reserve. If it runs empty, the
+			reserve is increased by one step, and the player's input is held until the
+			reserve has filled up again. If the buffer never got close to running empty
+			during the last ADAPTION_PERIOD steps, the reserve is decreased again, and
+			surplus inputs are skipped.
+			In sparse mode, the client only sends its input when it changes (and in
+			regular heartbeats), so ticks that were not received repeat the previous
+			input, and the client is assumed to produce one tick per step. Instead of
+			underruns, late inputs increase the reserve.
+*/
+class InputJitterBuffer : public ObjectCounter<InputJitterBuffer>
+{
+	public:
+		InputJitterBuffer();
+
+		/// adds the input of client tick \p tick. Duplicates are ignored.
+		void push(unsigned int tick, const PlayerInputAbs& input);
+
+		/// takes the input for the next step.
+		/// \return false, if the input of the next step is not available. In that case,
+		///			the previous input should be repeated.
+		bool pop(PlayerInputAbs& input);
+
+		/// sets whether ticks the client did not send repeat the previous input
+		void setSparse(bool sparse);
+
+		/// whether any input has been pushed, i.e. the client sends tick stamped inputs
+		bool isActive() const;
+		/// tick of the input of the last step, or 0 if no step has used an input yet
+		unsigned int getTick() const;
+		/// whether the last step used the input the client simulated for the tick after the
+		/// one of the step before. False if the step waited for inputs, or skipped or lost one.
+		bool isInSequence() const;
+		/// number of inputs that are kept in reserve
+		unsigned int getDelay() const;
+		const InputStatistics& getStatistics() const;
+
+		static const int SIZE = 64;
+		static const unsigned int INITIAL_DELAY = 2;
+		static const unsigned int MAX_DELAY = 10;
+		static const unsigned int ADAPTION_PERIOD = 150;
+
+	private:
+		struct Slot
+		{
+			bool valid;
+			unsigned int tick;
+			PlayerInputAbs input;
+		};
+
+		void restart(unsigned int tick);
+		int getReserve() const;
+		void late();
+
+		Slot mSlots[SIZE];
+		bool mActive;
+		bool mSparse;
+		bool mBuffering;			// waiting until the reserve has filled up
+		bool mInSequence;
+		unsigned int mNextTick;		// tick of the input for the next step
+		unsigned int mNewestTick;
+		unsigned int mAssumedTick;	// the tick the client is at, in sparse mode
+		unsigned int mTick;			// tick of the input of the last step
+		unsigned int mDelay;
+		PlayerInputAbs mInput;		// input of the last step
+
+		unsigned int mPeriodSteps;
+		unsigned int mPeriodLate;	// late inputs before the current adaption period
+		int mMinReserve;			// smallest reserve during the current adaption period
+
+		InputStatistics mStatistics;
+};
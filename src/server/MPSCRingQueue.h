@@ -0,0 +1,163 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/*! \class MPSCRingQueue
+	\brief bounded lock-free queue for multiple producers and a single consumer.
+	\details The queue is a ring buffer of fixed size, so pushing and popping never
+			allocates memory. Each cell carries a sequence number which tells whether
+			it is ready to be written by a producer or read by the consumer
+			(see D. Vyukov's bounded MPMC queue). Producers claim a cell with a single
+			compare-and-swap, the consumer needs no atomic read-modify-write at all.
+			push fails if the queue is full, it never blocks.
+			Only one thread at a time may call pop.
+*/
+template<class T>
+class MPSCRingQueue
+{
+	public:
+		/// creates a queue that can hold at least \p capacity elements.
+		/// the capacity is rounded up to the next power of two.
+		explicit MPSCRingQueue(std::size_t capacity);
+
+		MPSCRingQueue(const MPSCRingQueue&) = delete;
+		MPSCRingQueue& operator=(const MPSCRingQueue&) = delete;
+
+		/// adds \p value to the queue. can be called from any thread.
+		/// \return false, if the queue is full.
+		bool push(const T& value);
+
+		/// removes the oldest element from the queue and stores it in \p value.
+		/// must only be called from the consumer thread.
+		/// \return false, if the queue is empty.
+		bool pop(T& value);
+
+		/// whether the queue is empty. only exact when called from the consumer thread
+		/// while no producer is active.
+		bool empty() const;
+
+		/// whether every element a producer has started to push has been popped. Unlike
+		/// empty, this is false while a producer is still writing an element.
+		/// must only be called from the consumer thread.
+		bool drained() const;
+
+		std::size_t capacity() const { return mMask + 1; }
+
+	private:
+		struct Cell
+		{
+			std::atomic<std::size_t> sequence;
+			T data;
+		};
+
+		std::unique_ptr<Cell[]> mBuffer;
+		std::size_t mMask;
+
+		// producer and consumer positions are placed on different cache lines
+		alignas(64) std::atomic<std::size_t> mEnqueuePos;
+		alignas(64) std::size_t mDequeuePos;
+};
+
+// -------------------------------------------------------------------------------------------------
+//    							INLINE IMPLEMENTATION
+// -------------------------------------------------------------------------------------------------
+
+template<class T>
+MPSCRingQueue<T>::MPSCRingQueue(std::size_t capacity) : mEnqueuePos(0), mDequeuePos(0)
+{
+	std::size_t size = 2;
+	while(size < capacity)
+		size *= 2;
+
+	mBuffer.reset( new Cell[size] );
+	mMask = size - 1;
+
+	for(std::size_t i = 0; i < size; ++i)
+		mBuffer[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+template<class T>
+bool MPSCRingQueue<T>::push(const T& value)
+{
+	Cell* cell;
+	std::size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+	while(true)
+	{
+		cell = &mBuffer[pos & mMask];
+		std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+		std::intptr_t dif = (std::intptr_t)seq - (std::intptr_t)pos;
+
+		if(dif == 0)
+		{
+			// cell is free, try to claim it. on failure, pos is updated to the current value
+			if(mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if(dif < 0)
+		{
+			// the consumer has not yet read this cell: queue is full
+			return false;
+		}
+		else
+		{
+			// another producer was faster
+			pos = mEnqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	cell->data = value;
+	cell->sequence.store(pos + 1, std::memory_order_release);
+	return true;
+}
+
+template<class T>
+bool MPSCRingQueue<T>::pop(T& value)
+{
+	Cell& cell = mBuffer[mDequeuePos & mMask];
+	std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+	if(seq != mDequeuePos + 1)
+		return false;
+
+	value = std::move(cell.data);
+	// don't keep a reference to the element alive in the buffer
+	cell.data = T();
+	cell.sequence.store(mDequeuePos + mMask + 1, std::memory_order_release);
+	++mDequeuePos;
+	return true;
+}
+
+template<class T>
+bool MPSCRingQueue<T>::empty() const
+{
+	const Cell& cell = mBuffer[mDequeuePos & mMask];
+	return cell.sequence.load(std::memory_order_acquire) != mDequeuePos + 1;
+}
+
+template<class T>
+bool MPSCRingQueue<T>::drained() const
+{
+	return mEnqueuePos.load(std::memory_order_acquire) == mDequeuePos;
+}
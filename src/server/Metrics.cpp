@@ -0,0 +1,248 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "Metrics.h"
+
+/* includes */
+#include <cassert>
+#include <ostream>
+
+#include "raknet/SocketLayer.h"
+
+/* implementation */
+
+namespace
+{
+	void atomicAdd(std::atomic<double>& target, double value)
+	{
+		double old = target.load(std::memory_order_relaxed);
+		while(!target.compare_exchange_weak(old, old + value, std::memory_order_relaxed))
+		{
+		}
+	}
+}
+
+// -------------------------------------------------------------------------------------------------
+//    Metric
+// -------------------------------------------------------------------------------------------------
+
+Metric::Metric(const std::string& name, const std::string& help) : mName(name), mHelp(help)
+{
+}
+
+Metric::~Metric()
+{
+}
+
+const std::string& Metric::getName() const
+{
+	return mName;
+}
+
+void Metric::writeHeader(std::ostream& stream, const char* type) const
+{
+	stream << "# HELP " << mName << " " << mHelp << "\n";
+	stream << "# TYPE " << mName << " " << type << "\n";
+}
+
+int Metric::getShard()
+{
+	static std::atomic<int> nextShard(0);
+	thread_local int shard = nextShard++ % SHARDS;
+	return shard;
+}
+
+// -------------------------------------------------------------------------------------------------
+//    MetricCounter
+// -------------------------------------------------------------------------------------------------
+
+MetricCounter::MetricCounter(const std::string& name, const std::string& help) : Metric(name, help)
+{
+	for(auto& shard : mShards)
+		shard.value = 0;
+}
+
+std::uint64_t MetricCounter::getValue() const
+{
+	std::uint64_t sum = 0;
+	for(const auto& shard : mShards)
+		sum += shard.value.load(std::memory_order_relaxed);
+	return sum;
+}
+
+void MetricCounter::write(std::ostream& stream) const
+{
+	writeHeader(stream, "counter");
+	stream << getName() << " " << getValue() << "\n";
+}
+
+// -------------------------------------------------------------------------------------------------
+//    MetricGauge
+// -------------------------------------------------------------------------------------------------
+
+MetricGauge::MetricGauge(const std::string& name, const std::string& help) : Metric(name, help), mValue(0)
+{
+}
+
+double MetricGauge::getValue() const
+{
+	return mValue.load(std::memory_order_relaxed);
+}
+
+void MetricGauge::write(std::ostream& stream) const
+{
+	writeHeader(stream, "gauge");
+	stream << getName() << " " << getValue() << "\n";
+}
+
+// -------------------------------------------------------------------------------------------------
+//    MetricCallback
+// -------------------------------------------------------------------------------------------------
+
+MetricCallback::MetricCallback(const std::string& name, const std::string& help, Type type,
+								std::function<double()> callback) :
+	Metric(name, help), mType(type), mCallback(callback)
+{
+}
+
+void MetricCallback::write(std::ostream& stream) const
+{
+	writeHeader(stream, mType == COUNTER ? "counter" : "gauge");
+	stream << getName() << " " << mCallback() << "\n";
+}
+
+// -------------------------------------------------------------------------------------------------
+//    MetricHistogram
+// -------------------------------------------------------------------------------------------------
+
+MetricHistogram::MetricHistogram(const std::string& name, const std::string& help, const std::vector<double>& bounds) :
+	Metric(name, help), mBounds(bounds)
+{
+	assert(mBounds.size() <= MAX_BUCKETS);
+
+	for(auto& shard : mShards)
+	{
+		for(auto& bucket : shard.buckets)
+			bucket = 0;
+		shard.sum = 0;
+	}
+}
+
+void MetricHistogram::observe(double value)
+{
+	// there are only a few buckets, so a linear search is fast enough
+	unsigned int bucket = 0;
+	while(bucket < mBounds.size() && value > mBounds[bucket])
+		++bucket;
+
+	Shard& shard = mShards[getShard()];
+	shard.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+	atomicAdd(shard.sum, value);
+}
+
+std::uint64_t MetricHistogram::getCount() const
+{
+	std::uint64_t count = 0;
+	for(const auto& shard : mShards)
+	{
+		for(const auto& bucket : shard.buckets)
+			count += bucket.load(std::memory_order_relaxed);
+	}
+	return count;
+}
+
+double MetricHistogram::getSum() const
+{
+	double sum = 0;
+	for(const auto& shard : mShards)
+		sum += shard.sum.load(std::memory_order_relaxed);
+	return sum;
+}
+
+void MetricHistogram::write(std::ostream& stream) const
+{
+	writeHeader(stream, "histogram");
+
+	// the buckets of the exposition format are cumulative
+	std::uint64_t count = 0;
+	for(unsigned int i = 0; i <= mBounds.size(); ++i)
+	{
+		for(const auto& shard : mShards)
+			count += shard.buckets[i].load(std::memory_order_relaxed);
+
+		stream << getName() << "_bucket{le=\"";
+		if(i < mBounds.size())
+			stream << mBounds[i];
+		else
+			stream << "+Inf";
+		stream << "\"} " << count << "\n";
+	}
+	stream << getName() << "_sum " << getSum() << "\n";
+	stream << getName() << "_count " << count << "\n";
+}
+
+std::vector<double> MetricHistogram::durationBounds()
+{
+	return {0.00001, 0.000025, 0.00005, 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1};
+}
+
+// -------------------------------------------------------------------------------------------------
+//    ServerMetrics
+// -------------------------------------------------------------------------------------------------
+
+ServerMetrics::ServerMetrics() :
+	packetsReceived("blobby_packets_received_total", "Number of packets received from clients."),
+	connections("blobby_connections_total", "Number of accepted connections."),
+	gamesStarted("blobby_games_started_total", "Number of started games."),
+	gameSteps("blobby_game_steps_total", "Number of simulated game steps."),
+	bytesSent("blobby_bytes_sent_total", "Number of bytes sent over the network, including protocol overhead.",
+				MetricCallback::COUNTER, [](){ return (double)SocketLayer::Instance()->GetBytesSent(); }),
+	bytesReceived("blobby_bytes_received_total", "Number of bytes received over the network, including protocol overhead.",
+				MetricCallback::COUNTER, [](){ return (double)SocketLayer::Instance()->GetBytesReceived(); }),
+	connectedClients("blobby_connected_clients", "Number of connected clients."),
+	runningGames("blobby_running_games", "Number of running games."),
+	tickDuration("blobby_game_tick_duration_seconds", "Time needed to process the packets and step a game.",
+				MetricHistogram::durationBounds()),
+	tickLag("blobby_game_tick_lag_seconds", "Time between the deadline of a game tick and its start.",
+				MetricHistogram::durationBounds()),
+	scriptTime("blobby_game_script_seconds", "Time spent in lua rules per game step.",
+				MetricHistogram::durationBounds()),
+	serverQueueDepth("blobby_server_packet_queue_depth", "Number of packets in the server packet queue per server update.",
+				{0, 1, 2, 4, 8, 16, 32, 64, 128, 256}),
+	gameQueueDepth("blobby_game_packet_queue_depth", "Number of packets in the packet queue of a game per game tick.",
+				{0, 1, 2, 4, 8, 16, 32, 64, 128, 256})
+{
+	mMetrics = { &packetsReceived, &connections, &gamesStarted, &gameSteps, &bytesSent, &bytesReceived,
+				&connectedClients, &runningGames,
+				&tickDuration, &tickLag, &scriptTime, &serverQueueDepth, &gameQueueDepth };
+}
+
+void ServerMetrics::write(std::ostream& stream) const
+{
+	for(const Metric* metric : mMetrics)
+		metric->write(stream);
+}
+
+ServerMetrics& getServerMetrics()
+{
+	static ServerMetrics metrics;
+	return metrics;
+}
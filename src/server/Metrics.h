@@ -0,0 +1,215 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/** \file Metrics.h
+	Counters, gauges and histograms for monitoring the server. They can be updated from
+	any thread without locking. Counters and histograms are split into SHARDS cache line
+	sized shards, and each thread updates only one of them, so threads don't compete for
+	the same cache line. The shards are summed up when the metrics are read.
+	All metrics can write themselves in the text exposition format of Prometheus.
+*/
+
+/// base class of all metrics
+class Metric
+{
+	public:
+		Metric(const std::string& name, const std::string& help);
+		virtual ~Metric();
+
+		const std::string& getName() const;
+
+		/// writes the metric in text exposition format
+		virtual void write(std::ostream& stream) const = 0;
+
+		static const int SHARDS = 8;
+
+	protected:
+		/// writes the HELP and TYPE lines
+		void writeHeader(std::ostream& stream, const char* type) const;
+		/// index of the shard the current thread uses
+		static int getShard();
+
+	private:
+		std::string mName;
+		std::string mHelp;
+};
+
+/// a value that only increases
+class MetricCounter : public Metric
+{
+	public:
+		MetricCounter(const std::string& name, const std::string& help);
+
+		void add(std::uint64_t value = 1)
+		{
+			mShards[getShard()].value.fetch_add(value, std::memory_order_relaxed);
+		}
+
+		std::uint64_t getValue() const;
+
+		void write(std::ostream& stream) const override;
+
+	private:
+		struct alignas(64) Shard
+		{
+			std::atomic<std::uint64_t> value;
+		};
+
+		Shard mShards[SHARDS];
+};
+
+/// a value that can go up and down
+class MetricGauge : public Metric
+{
+	public:
+		MetricGauge(const std::string& name, const std::string& help);
+
+		void set(double value)
+		{
+			mValue.store(value, std::memory_order_relaxed);
+		}
+
+		double getValue() const;
+
+		void write(std::ostream& stream) const override;
+
+	private:
+		std::atomic<double> mValue;
+};
+
+/// a value that is calculated when the metrics are read, e.g. from a statistic of another component
+class MetricCallback : public Metric
+{
+	public:
+		enum Type
+		{
+			COUNTER,
+			GAUGE
+		};
+
+		MetricCallback(const std::string& name, const std::string& help, Type type,
+						std::function<double()> callback);
+
+		void write(std::ostream& stream) const override;
+
+	private:
+		Type mType;
+		std::function<double()> mCallback;
+};
+
+/// counts observed values in buckets. Each bucket counts the values up to its upper bound.
+class MetricHistogram : public Metric
+{
+	public:
+		/// \p bounds are the upper bounds of the buckets, in ascending order.
+		///	There can be at most MAX_BUCKETS of them.
+		MetricHistogram(const std::string& name, const std::string& help, const std::vector<double>& bounds);
+
+		void observe(double value);
+		/// observes a duration in seconds
+		void observe(std::chrono::steady_clock::duration duration)
+		{
+			observe(std::chrono::duration<double>(duration).count());
+		}
+
+		std::uint64_t getCount() const;
+		double getSum() const;
+
+		void write(std::ostream& stream) const override;
+
+		/// bucket bounds for durations from 10 microseconds to 100 milliseconds
+		static std::vector<double> durationBounds();
+
+		static const int MAX_BUCKETS = 16;
+
+	private:
+		struct alignas(64) Shard
+		{
+			// the last bucket counts the values larger than all bounds
+			std::atomic<std::uint64_t> buckets[MAX_BUCKETS + 1];
+			std::atomic<double> sum;
+		};
+
+		std::vector<double> mBounds;
+		Shard mShards[SHARDS];
+};
+
+/// measures the time between construction and destruction
+class ScopedTimer
+{
+	public:
+		explicit ScopedTimer(MetricHistogram& target) : mTarget(target), mStart(std::chrono::steady_clock::now())
+		{
+		}
+
+		~ScopedTimer()
+		{
+			mTarget.observe(std::chrono::steady_clock::now() - mStart);
+		}
+
+	private:
+		MetricHistogram& mTarget;
+		std::chrono::steady_clock::time_point mStart;
+};
+
+/*! \class ServerMetrics
+	\brief all metrics of the blobby server
+*/
+class ServerMetrics
+{
+	public:
+		ServerMetrics();
+
+		MetricCounter packetsReceived;
+		MetricCounter connections;
+		MetricCounter gamesStarted;
+		MetricCounter gameSteps;
+		MetricCallback bytesSent;
+		MetricCallback bytesReceived;
+
+		MetricGauge connectedClients;
+		MetricGauge runningGames;
+
+		MetricHistogram tickDuration;
+		MetricHistogram tickLag;
+		MetricHistogram scriptTime;
+		MetricHistogram serverQueueDepth;
+		MetricHistogram gameQueueDepth;
+
+		/// writes all metrics in text exposition format
+		void write(std::ostream& stream) const;
+
+	private:
+		std::vector<const Metric*> mMetrics;
+};
+
+/// the metrics of the server in this process
+ServerMetrics& getServerMetrics();
@@ -0,0 +1,167 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "MetricsServer.h"
+
+/* includes */
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#ifndef WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "Metrics.h"
+
+/* implementation */
+
+#ifndef WIN32
+
+namespace
+{
+	// how often the listening thread checks whether it should stop
+	const int POLL_TIMEOUT_MS = 200;
+	// how long we wait for a client to send its request
+	const int REQUEST_TIMEOUT_MS = 1000;
+}
+
+MetricsServer::MetricsServer(const std::string& path) : mPath(path), mSocket(-1), mRunning(true)
+{
+	sockaddr_un address;
+	std::memset(&address, 0, sizeof(address));
+	if(path.empty() || path.size() >= sizeof(address.sun_path))
+		throw std::runtime_error("invalid metrics socket path " + path);
+
+	address.sun_family = AF_UNIX;
+	std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+	mSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(mSocket < 0)
+		throw std::runtime_error("could not create metrics socket: " + std::string(std::strerror(errno)));
+
+	// remove the socket of an earlier run
+	unlink(path.c_str());
+	if(bind(mSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(mSocket, 4) < 0)
+	{
+		std::string error = std::strerror(errno);
+		close(mSocket);
+		throw std::runtime_error("could not listen on metrics socket " + path + ": " + error);
+	}
+
+	mThread = std::thread([this](){ run(); });
+}
+
+MetricsServer::~MetricsServer()
+{
+	mRunning = false;
+	mThread.join();
+	close(mSocket);
+	unlink(mPath.c_str());
+}
+
+void MetricsServer::run()
+{
+	while(mRunning)
+	{
+		pollfd listening = {mSocket, POLLIN, 0};
+		if(poll(&listening, 1, POLL_TIMEOUT_MS) <= 0)
+			continue;
+
+		int connection = accept(mSocket, nullptr, nullptr);
+		if(connection < 0)
+			continue;
+
+		answer(connection);
+		close(connection);
+	}
+}
+
+void MetricsServer::answer(int connection)
+{
+	// read the request until the empty line that ends the header. We answer every
+	// request the same way, so its content does not matter. Clients that do not send
+	// anything get their answer after the timeout.
+	std::string request;
+	char buffer[512];
+	while(request.find("\r\n\r\n") == std::string::npos && request.find("\n\n") == std::string::npos
+			&& request.size() < 4096)
+	{
+		pollfd client = {connection, POLLIN, 0};
+		if(poll(&client, 1, REQUEST_TIMEOUT_MS) <= 0)
+			break;
+		ssize_t received = recv(connection, buffer, sizeof(buffer), 0);
+		if(received <= 0)
+			break;
+		request.append(buffer, received);
+	}
+
+	std::ostringstream body;
+	getServerMetrics().write(body);
+	std::string content = body.str();
+
+	std::ostringstream response;
+	response << "HTTP/1.0 200 OK\r\n";
+	response << "Content-Type: text/plain; version=0.0.4\r\n";
+	response << "Content-Length: " << content.size() << "\r\n";
+	response << "Connection: close\r\n\r\n";
+	response << content;
+	std::string data = response.str();
+
+	std::size_t sent = 0;
+	while(sent < data.size())
+	{
+		ssize_t written = send(connection, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+		if(written <= 0)
+			break;
+		sent += written;
+	}
+}
+
+#else
+
+MetricsServer::MetricsServer(const std::string& path) : mPath(path), mSocket(-1), mRunning(false)
+{
+	throw std::runtime_error("the metrics socket is not supported on this platform");
+}
+
+MetricsServer::~MetricsServer()
+{
+}
+
+void MetricsServer::run()
+{
+}
+
+void MetricsServer::answer(int connection)
+{
+}
+
+#endif
+
+const std::string& MetricsServer::getPath() const
+{
+	return mPath;
+}
@@ -0,0 +1,55 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "BlobbyDebug.h"
+
+/*! \class MetricsServer
+	\brief makes the server metrics available to monitoring tools
+	\details Listens on a UNIX domain socket and answers every connection with a minimal
+			HTTP/1.0 response that contains the metrics in text exposition format, e.g.
+				curl --unix-socket /run/blobby/metrics.sock http://localhost/metrics
+			Requests are handled one after another on a thread of its own, so reading the
+			metrics never blocks the game threads. Only available on POSIX systems.
+*/
+class MetricsServer : public ObjectCounter<MetricsServer>
+{
+	public:
+		/// starts listening on \p path. A stale socket file at \p path is removed.
+		/// \throw std::runtime_error if the socket could not be opened
+		explicit MetricsServer(const std::string& path);
+		~MetricsServer();
+
+		const std::string& getPath() const;
+
+	private:
+		void run();
+		void answer(int connection);
+
+		std::string mPath;
+		int mSocket;
+		std::atomic<bool> mRunning;
+		std::thread mThread;
+};
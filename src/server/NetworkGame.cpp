@@ -26,6 +26,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <iostream>
 #include <stdexcept>
 #include <cassert>
+#include <algorithm>
 
 #include <boost/make_shared.hpp>
 
@@ -43,8 +44,18 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "PhysicWorld.h"
 #include "NetworkPlayer.h"
 #include "InputSource.h"
+#include "InputHistory.h"
+#include "Metrics.h"
+#include "ScriptTime.h"
+#include "Trace.h"
 
-extern int SWLS_GameSteps;
+#ifndef WIN32
+#ifndef __ANDROID__
+#include <sys/syslog.h>
+#endif
+#endif
+
+void syslog(int pri, const char* format, ...);
 
 /* implementation */
 
@@ -52,12 +63,16 @@ NetworkGame::NetworkGame(RakServer& server, boost::shared_ptr<NetworkPlayer> lef
 			boost::shared_ptr<NetworkPlayer> rightPlayer, PlayerSide switchedSide,
 			std::string rules, int scoreToWin, float speed) :
 	mServer(server),
+	mPacketQueue(PACKET_QUEUE_SIZE),
 	mMatch(new DuelMatch(false, rules, scoreToWin)),
+	mGameSpeed( speed ),
+	mSnapshotInterval(2),
+	mStepCounter(0),
 	mLeftInput (new InputSource()),
 	mRightInput(new InputSource()),
 	mRecorder(new ReplayRecorder()),
 	mGameValid(true),
-	mSpeedController( speed )
+	mRetired(false)
 {
 	// check that both players don't have an active game
 	if(leftPlayer->getGame())
@@ -79,52 +94,43 @@ NetworkGame::NetworkGame(RakServer& server, boost::shared_ptr<NetworkPlayer> lef
 
 	mRecorder->setPlayerNames(leftPlayer->getName(), rightPlayer->getName());
 	mRecorder->setPlayerColors(leftPlayer->getColor(), rightPlayer->getColor());
-	mRecorder->setGameSpeed(mSpeedController.getGameSpeed());
+	mRecorder->setGameSpeed(mGameSpeed);
 
-	// read rulesfile into a string
-	int checksum = 0;
-	mRulesLength = 0;
+	// the rules are shared with the lua state of the match, so the file is not read again
 	mRulesSent[0] = false;
 	mRulesSent[1] = false;
-
-	rules = FileRead::makeLuaFilename( rules );
-	FileRead file(std::string("rules/") + rules);
-	checksum = file.calcChecksum(0);
-	mRulesLength = file.length();
-	mRulesString = file.readRawBytes(mRulesLength);
+	mRules = ScriptCache::get("rules/" + rules);
 
 	// writing rules checksum
 	RakNet::BitStream stream;
 	stream.Write((unsigned char)ID_RULES_CHECKSUM);
-	stream.Write(checksum);
+	stream.Write((int)mRules->checksum);
 	stream.Write(mMatch->getScoreToWin());
 	/// \todo write file author and title, too; maybe add a version number in scripts, too.
 	broadcastBitstream(stream);
-
-	// game loop
-	mGameThread = std::thread(
-		[this]()
-		{
-			while(mGameValid)
-			{
-				processPackets();
-				step();
-				SWLS_GameSteps++;
-				mSpeedController.update();
-			}
-		}					);
 }
 
 NetworkGame::~NetworkGame()
 {
-	mGameValid = false;
-	mGameThread.join();
+	for (int i = 0; i < MAX_PLAYERS; ++i)
+	{
+		if (!mInputBuffers[i].isActive())
+			continue;
+
+		const InputStatistics& stats = mInputBuffers[i].getStatistics();
+		syslog(LOG_DEBUG, "inputs of %s: %u received, %u late, %u dropped, %u underruns, delay %u",
+				getPlayerID((PlayerSide)i).toString().c_str(), stats.received, stats.late,
+				stats.dropped, stats.underruns, mInputBuffers[i].getDelay());
+	}
 }
 
 void NetworkGame::injectPacket(const packet_ptr& packet)
 {
-	std::lock_guard<std::mutex> lock(mPacketQueueMutex);
-	mPacketQueue.push_back(packet);
+	if(!mPacketQueue.push(packet))
+	{
+		syslog(LOG_ERR, "packet queue of game %s vs %s is full, packet %d has to wait in the overflow list",
+				mLeftPlayer.toString().c_str(), mRightPlayer.toString().c_str(), int(packet->data[0]));
+	}
 }
 
 void NetworkGame::broadcastBitstream(const RakNet::BitStream& stream, const RakNet::BitStream& switchedstream)
@@ -161,17 +167,16 @@ void NetworkGame::broadcastBitstream(const RakNet::BitStream& stream)
 
 void NetworkGame::processPackets()
 {
-	while (!mPacketQueue.empty())
-	{
-		packet_ptr packet;
-		{
-			std::lock_guard<std::mutex> lock(mPacketQueueMutex);
-			packet = mPacketQueue.front();
-			mPacketQueue.pop_front();
-		}
+	TRACE_SCOPE("NetworkGame::processPackets");
 
+	packet_ptr packet;
+	int queued = 0;
+	while (mPacketQueue.pop(packet))
+	{
 		processPacket( packet );
+		++queued;
 	}
+	getServerMetrics().gameQueueDepth.observe(queued);
 }
 
 /// this function processes a single packet received for this network game
@@ -201,20 +206,91 @@ void NetworkGame::processPacket( const packet_ptr& packet )
 			stream.Read(time);
 			PlayerInputAbs newInput(stream);
 
-			if (packet->playerId == mLeftPlayer)
+			PlayerSide side = packet->playerId == mLeftPlayer ? LEFT_PLAYER : RIGHT_PLAYER;
+			if (side == LEFT_PLAYER)
 			{
 				if (mSwitchedSide == LEFT_PLAYER)
 					newInput.swapSides();
-				mLeftInput->setInput(newInput);
 				mLeftLastTime = time;
 			}
-			if (packet->playerId == mRightPlayer)
+			 else
 			{
 				if (mSwitchedSide == RIGHT_PLAYER)
 					newInput.swapSides();
-				mRightInput->setInput(newInput);
 				mRightLastTime = time;
 			}
+
+			bool buffered = false;
+			// newer clients acknowledge the last snapshot they received
+			if (stream.GetNumberOfUnreadBits() >= 33)
+			{
+				unsigned int snapshot;
+				bool requestKeyframe;
+				stream.Read(snapshot);
+				stream.Read(requestKeyframe);
+				unsigned char encoding = SnapshotCodec::EXACT_ENCODING;
+				if (stream.GetNumberOfUnreadBits() >= 8)
+					stream.Read(encoding);
+				if (encoding > SnapshotCodec::QUANTIZED_ENCODING)
+					encoding = SnapshotCodec::EXACT_ENCODING;
+				acknowledgeSnapshot(side, snapshot, requestKeyframe, (SnapshotCodec::Encoding)encoding);
+
+				// the client tells us which of its frames this input belongs to, so the input
+				// can be used in the right step
+				if (stream.GetNumberOfUnreadBits() >= 32)
+				{
+					unsigned int tick;
+					stream.Read(tick);
+					mInputBuffers[side].setSparse(false);
+					mInputBuffers[side].push(tick, newInput);
+					buffered = true;
+				}
+			}
+
+			// old clients: use the input as soon as it arrives
+			if (!buffered)
+				(side == LEFT_PLAYER ? mLeftInput : mRightInput)->setInput(newInput);
+			break;
+		}
+
+		case ID_INPUT_HISTORY:
+		{
+			unsigned time;
+			unsigned int snapshot;
+			bool requestKeyframe;
+			unsigned char encoding;
+			unsigned int newestTick;
+			PlayerInputAbs inputs[InputHistory::SIZE];
+			RakNet::BitStream stream((char*)packet->data, packet->length, false);
+
+			stream.IgnoreBytes(1);	// ID_INPUT_HISTORY
+			stream.Read(time);
+			stream.Read(snapshot);
+			stream.Read(requestKeyframe);
+			stream.Read(encoding);
+			int count = InputHistory::readFrom(stream, newestTick, inputs);
+			if (count == 0)
+				break;
+
+			PlayerSide side = packet->playerId == mLeftPlayer ? LEFT_PLAYER : RIGHT_PLAYER;
+			if (side == LEFT_PLAYER)
+				mLeftLastTime = time;
+			 else
+				mRightLastTime = time;
+
+			if (encoding > SnapshotCodec::QUANTIZED_ENCODING)
+				encoding = SnapshotCodec::EXACT_ENCODING;
+			acknowledgeSnapshot(side, snapshot, requestKeyframe, (SnapshotCodec::Encoding)encoding);
+
+			// the inputs are sent redundantly, the buffer ignores the ones it already has
+			InputJitterBuffer& buffer = mInputBuffers[side];
+			buffer.setSparse(true);
+			for (int i = 0; i < count; ++i)
+			{
+				if (mSwitchedSide == side)
+					inputs[i].swapSides();
+				buffer.push(newestTick - (count - 1 - i), inputs[i]);
+			}
 			break;
 		}
 
@@ -284,8 +360,8 @@ void NetworkGame::processPacket( const packet_ptr& packet )
 			{
 				stream = boost::make_shared<RakNet::BitStream>();
 				stream->Write((unsigned char)ID_RULES);
-				stream->Write( mRulesLength );
-				stream->Write( mRulesString.get(), mRulesLength);
+				stream->Write( (int)mRules->source.size() );
+				stream->Write( mRules->source.data(), mRules->source.size() );
 				assert( stream->GetData()[0] == ID_RULES );
 
 				mServer.Send(stream.get(), HIGH_PRIORITY, RELIABLE_ORDERED, 0, packet->playerId, false);
@@ -299,7 +375,7 @@ void NetworkGame::processPacket( const packet_ptr& packet )
 				// writing data into leftStream
 				RakNet::BitStream leftStream;
 				leftStream.Write((unsigned char)ID_GAME_READY);
-				leftStream.Write((int)mSpeedController.getGameSpeed());
+				leftStream.Write((int)mGameSpeed);
 				strncpy(name, mMatch->getPlayer(RIGHT_PLAYER).getName().c_str(), sizeof(name));
 				leftStream.Write(name, sizeof(name));
 				leftStream.Write(mMatch->getPlayer(RIGHT_PLAYER).getStaticColor().toInt());
@@ -307,7 +383,7 @@ void NetworkGame::processPacket( const packet_ptr& packet )
 				// writing data into rightStream
 				RakNet::BitStream rightStream;
 				rightStream.Write((unsigned char)ID_GAME_READY);
-				rightStream.Write((int)mSpeedController.getGameSpeed());
+				rightStream.Write((int)mGameSpeed);
 				strncpy(name, mMatch->getPlayer(LEFT_PLAYER).getName().c_str(), sizeof(name));
 				rightStream.Write(name, sizeof(name));
 				rightStream.Write(mMatch->getPlayer(LEFT_PLAYER).getStaticColor().toInt());
@@ -331,9 +407,21 @@ bool NetworkGame::isGameValid() const
 	return mGameValid;
 }
 
+void NetworkGame::retire()
+{
+	mRetired = true;
+}
+
+bool NetworkGame::isRetired() const
+{
+	return mRetired;
+}
+
 
 void NetworkGame::step()
 {
+	TRACE_SCOPE("NetworkGame::step");
+
 	if (!isGameStarted())
 		return;
 
@@ -342,7 +430,26 @@ void NetworkGame::step()
 	{
 		mRecorder->record(mMatch->getState());
 
+		// consume the buffered inputs, one per step
+		for (int i = 0; i < MAX_PLAYERS; ++i)
+		{
+			InputJitterBuffer& buffer = mInputBuffers[i];
+			if (!buffer.isActive())
+				continue;
+
+			PlayerInputAbs input;
+			if (buffer.pop(input))
+				(i == LEFT_PLAYER ? mLeftInput : mRightInput)->setInput(input);
+			mSnapshots[i].inputTick = buffer.getTick();
+			mSnapshots[i].inputsInSequence &= buffer.isInSequence();
+		}
+
+		// the rules script is called from within the step, it adds up its time in ScriptTime
+		ScriptTime::take();
 		mMatch->step();
+		getServerMetrics().scriptTime.observe(ScriptTime::take());
+		mStepCounter++;
+		hashState();
 
 		broadcastGameEvents();
 
@@ -365,41 +472,124 @@ void NetworkGame::step()
 			broadcastBitstream(stream, switchStream);
 		}
 
-		broadcastPhysicState(mMatch->getState());
+		// delta snapshots are only sent every mSnapshotInterval steps, the final state is always sent
+		broadcastPhysicState(mMatch->getState(), mStepCounter % mSnapshotInterval == 0 || winning != NO_PLAYER);
 	}
 }
 
-void NetworkGame::broadcastPhysicState(const DuelMatchState& state) const
+void NetworkGame::hashState()
 {
-	DuelMatchState ms = state;	// modifiable copy
+	// the clients simulate the same steps, so they can check their own state against ours
+	DuelMatchState state = mMatch->getState();
+	std::uint64_t hash = state.hash();
+	state.swapSides();
+	std::uint64_t swapped = state.hash();
+
+	mSnapshots[LEFT_PLAYER].stateHash = mSwitchedSide == LEFT_PLAYER ? swapped : hash;
+	mSnapshots[RIGHT_PLAYER].stateHash = mSwitchedSide == RIGHT_PLAYER ? swapped : hash;
+}
 
-	RakNet::BitStream stream;
-	stream.Write((unsigned char)ID_GAME_UPDATE);
-	stream.Write( mLeftLastTime );
+void NetworkGame::broadcastPhysicState(const DuelMatchState& state, bool snapshotDue)
+{
+	TRACE_SCOPE("NetworkGame::broadcastPhysicState");
 
-	/// \todo this required dynamic memory allocation! not good!
-	boost::shared_ptr<GenericOut> out = createGenericWriter( &stream );
+	if (!snapshotDue && mSnapshots[LEFT_PLAYER].deltaEnabled && mSnapshots[RIGHT_PLAYER].deltaEnabled)
+		return;
+
+	DuelMatchState ms = state;	// modifiable copy
 
 	if (mSwitchedSide == LEFT_PLAYER)
 		ms.swapSides();
 
-	out->generic<DuelMatchState> (ms);
-	mServer.Send(&stream, HIGH_PRIORITY, UNRELIABLE_SEQUENCED, 0, mLeftPlayer, false);
-
-	// reset state and stream
-	stream.Reset();
-	stream.Write((unsigned char)ID_GAME_UPDATE);
-	stream.Write( mRightLastTime );
-
-	out = createGenericWriter( &stream );
+	sendSnapshot(LEFT_PLAYER, ms, mLeftLastTime, snapshotDue);
 
 	// either switch back, or perform switching for right side
 	if (mSwitchedSide == LEFT_PLAYER || mSwitchedSide == RIGHT_PLAYER)
 		ms.swapSides();
 
-	out->generic<DuelMatchState> (ms);
+	sendSnapshot(RIGHT_PLAYER, ms, mRightLastTime, snapshotDue);
+}
+
+void NetworkGame::sendSnapshot(PlayerSide side, const DuelMatchState& state, unsigned time, bool snapshotDue)
+{
+	SnapshotChannel& channel = mSnapshots[side];
+	PlayerID target = side == LEFT_PLAYER ? mLeftPlayer : mRightPlayer;
+
+	RakNet::BitStream stream;
+
+	// old clients get the full state every step, because they don't interpolate
+	if (!channel.deltaEnabled)
+	{
+		stream.Write((unsigned char)ID_GAME_UPDATE);
+		stream.Write( time );
+
+		BitStreamOut out( stream );
+		out.generic<DuelMatchState> (state);
+		mServer.Send(&stream, HIGH_PRIORITY, UNRELIABLE_SEQUENCED, 0, target, false);
+		return;
+	}
+
+	// clients with delta snapshots interpolate between them, so they don't need every step
+	if (!snapshotDue)
+		return;
+
+	// encode against the last acknowledged snapshot if we still know it, otherwise send a keyframe
+	const DuelMatchState* base = 0;
+	unsigned int offset = channel.sequence - channel.acknowledged;
+	if (!channel.keyframeRequested && offset <= 255 && channel.sequence - channel.lastKeyframe < KEYFRAME_INTERVAL)
+		base = channel.history.find(channel.acknowledged);
+
+	stream.Write((unsigned char)ID_GAME_UPDATE_DELTA);
+	stream.Write( time );
+	stream.Write( channel.sequence );
+	stream.Write( base == 0 );
+	if (base)
+		stream.Write( (unsigned char)offset );
+	else
+		channel.lastKeyframe = channel.sequence;
+	stream.Write( channel.codec.getEncoding() == SnapshotCodec::QUANTIZED_ENCODING );
+	stream.Write( channel.inputTick );
+	stream.Write( mStepCounter );
+
+	channel.codec.encode(stream, state, base);
+
+	// now and then, let the client check its simulation against ours. The client compares the
+	// hash with the state it simulated for inputTick. If we waited for its inputs or skipped
+	// one since the last snapshot, our state belongs to a different step than that one.
+	if (channel.sequence % STATE_HASH_INTERVAL == 0)
+		channel.hashDue = true;
+	if (channel.hashDue && channel.inputsInSequence)
+	{
+		stream.Write( true );
+		stream.Write( (unsigned int)(channel.stateHash >> 32) );
+		stream.Write( (unsigned int)channel.stateHash );
+		channel.hashDue = false;
+	}
+	channel.inputsInSequence = true;
 
-	mServer.Send(&stream, HIGH_PRIORITY, UNRELIABLE_SEQUENCED, 0, mRightPlayer, false);
+	channel.history.store(channel.sequence, state);
+	channel.sequence++;
+
+	mServer.Send(&stream, HIGH_PRIORITY, UNRELIABLE_SEQUENCED, 0, target, false);
+}
+
+void NetworkGame::acknowledgeSnapshot(PlayerSide side, unsigned int snapshot, bool requestKeyframe, SnapshotCodec::Encoding encoding)
+{
+	SnapshotChannel& channel = mSnapshots[side];
+	channel.deltaEnabled = true;
+	channel.keyframeRequested = requestKeyframe;
+
+	// old snapshots can't be used as base for the new encoding
+	if (encoding != channel.codec.getEncoding())
+	{
+		channel.codec = SnapshotCodec(encoding);
+		channel.history.clear();
+		channel.keyframeRequested = true;
+	}
+
+	// never go back to an older snapshot, in case acknowledgements arrive out of order
+	if (!requestKeyframe && (int)(snapshot - channel.acknowledged) > 0)
+		channel.acknowledged = snapshot;
 }
 
 // helper function that writes a single event to bit stream in a space efficient way.
@@ -416,6 +606,8 @@ void NetworkGame::writeEventToStream(RakNet::BitStream& stream, MatchEvent e, bo
 
 void NetworkGame::broadcastGameEvents() const
 {
+	TRACE_SCOPE("NetworkGame::broadcastGameEvents");
+
 	RakNet::BitStream stream;
 
 	auto events = mMatch->getEvents();
@@ -451,3 +643,13 @@ PlayerID NetworkGame::getPlayerID( PlayerSide side ) const
 	assert(0);
 }
 
+float NetworkGame::getGameSpeed() const
+{
+	return mGameSpeed;
+}
+
+void NetworkGame::setSnapshotInterval(unsigned int interval)
+{
+	mSnapshotInterval = std::max(interval, 1u);
+}
+
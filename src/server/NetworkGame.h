@@ -20,9 +20,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #pragma once
 
-#include <list>
-#include <mutex>
-#include <thread>
+#include <atomic>
+#include <cstdint>
 
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_array.hpp>
@@ -30,15 +29,18 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "Global.h"
 #include "raknet/NetworkTypes.h"
 #include "raknet/BitStream.h"
-#include "SpeedController.h"
 #include "DuelMatch.h"
+#include "SnapshotCodec.h"
+#include "ScriptCache.h"
 #include "BlobbyDebug.h"
+#include "server/OverflowQueue.h"
+#include "server/InputJitterBuffer.h"
 
 class RakServer;
 class ReplayRecorder;
 class NetworkPlayer;
 
-typedef std::list<packet_ptr> PacketQueue;
+typedef OverflowQueue<packet_ptr> PacketQueue;
 
 class NetworkGame : public ObjectCounter<NetworkGame>
 {
@@ -57,27 +59,46 @@ class NetworkGame : public ObjectCounter<NetworkGame>
 
 		~NetworkGame();
 
+		/// queues a packet for processing by this game. can be called from any thread.
 		void injectPacket(const packet_ptr& packet);
 
 		/// It returns whether both clients are still connected.
 		bool isGameValid() const;
 
-		// This function processes the queued network packets,
-		// makes a physic step, checks the rules and broadcasts
+		/// marks a finished game as no longer needed. The scheduler task of the game
+		/// stops when it sees this flag, so the server can release the game afterwards.
+		void retire();
+		bool isRetired() const;
+
+		// This function makes a physic step, checks the rules and broadcasts
 		// the current state and outstanding messages to the clients.
+		// It is called periodically by the GameScheduler of the server.
 		void step();
 
 		/// This function processes all queued network packets.
+		/// It must not be called from more than one thread at once.
 		void processPackets();
 
 		// game info
 		/// gets network IDs of players
 		PlayerID getPlayerID( PlayerSide side ) const;
+		/// gets the number of steps per second
+		float getGameSpeed() const;
+		/// sets after how many steps a delta snapshot is sent to the clients. Old clients,
+		/// which don't understand delta snapshots, get the full state every step.
+		void setSnapshotInterval(unsigned int interval);
 
 	private:
 		void broadcastBitstream(const RakNet::BitStream& stream, const RakNet::BitStream& switchedstream);
 		void broadcastBitstream(const RakNet::BitStream& stream);
-		void broadcastPhysicState(const DuelMatchState& state) const;
+		/// hashes the simulated state, in the orientation of each client, for the next snapshots
+		void hashState();
+		/// sends the state to both players. Players that receive delta snapshots only get
+		/// it if \p snapshotDue is set.
+		void broadcastPhysicState(const DuelMatchState& state, bool snapshotDue);
+		// sends the state (already in the view of the client) to one player
+		void sendSnapshot(PlayerSide side, const DuelMatchState& state, unsigned time, bool snapshotDue);
+		void acknowledgeSnapshot(PlayerSide side, unsigned int snapshot, bool requestKeyframe, SnapshotCodec::Encoding encoding);
 		void broadcastGameEvents() const;
 		void writeEventToStream(RakNet::BitStream& stream, MatchEvent e, bool switchSides ) const;
 		bool isGameStarted() { return mRulesSent[LEFT_PLAYER] && mRulesSent[RIGHT_PLAYER]; }
@@ -91,22 +112,49 @@ class NetworkGame : public ObjectCounter<NetworkGame>
 		PlayerSide mSwitchedSide;
 
 		PacketQueue mPacketQueue;
-		std::mutex mPacketQueueMutex;
 
 		boost::scoped_ptr<DuelMatch> mMatch;
-		SpeedController mSpeedController;
+		float mGameSpeed;
+		unsigned int mSnapshotInterval;
+		unsigned int mStepCounter;		// number of simulated steps
 		boost::shared_ptr<InputSource> mLeftInput;
 		boost::shared_ptr<InputSource> mRightInput;
 		unsigned mLeftLastTime = -1;
 		unsigned mRightLastTime = -1;
-		std::thread mGameThread;
+		// inputs of clients that send tick stamped inputs
+		InputJitterBuffer mInputBuffers[MAX_PLAYERS];
 
 		boost::scoped_ptr<ReplayRecorder> mRecorder;
 
 		bool mGameValid;
+		std::atomic<bool> mRetired;
+
+		// information about the delta compressed snapshots sent to each client
+		struct SnapshotChannel
+		{
+			bool deltaEnabled = false;		// set as soon as the client acknowledges snapshots
+			bool keyframeRequested = false;
+			unsigned int sequence = 0;		// number of the next snapshot
+			unsigned int acknowledged = 0;	// newest snapshot the client has received
+			unsigned int lastKeyframe = 0;
+			unsigned int inputTick = 0;		// tick of the last input of the client that was simulated
+			bool inputsInSequence = false;	// every step since the last snapshot used the next input of the client
+			std::uint64_t stateHash = 0;	// hash of the simulated state after the last step, as the client sees it
+			bool hashDue = false;			// the hash is sent with the next snapshot the client can check it with
+			SnapshotCodec codec;			// the encoding is chosen by the client
+			SnapshotHistory history;
+		};
+		SnapshotChannel mSnapshots[MAX_PLAYERS];
 
 		bool mRulesSent[MAX_PLAYERS];
-		int mRulesLength;
-		boost::shared_array<char> mRulesString;
+		boost::shared_ptr<const CachedScript> mRules;
+
+		/// number of packets that can be queued before the queue falls back to its overflow list
+		static const int PACKET_QUEUE_SIZE = 256;
+		/// a keyframe is sent at least every KEYFRAME_INTERVAL snapshots
+		static const unsigned int KEYFRAME_INTERVAL = 150;
+		/// the hash of the state is sent with every STATE_HASH_INTERVAL-th snapshot, or the first
+		/// one after it that the client simulated the same steps for
+		static const unsigned int STATE_HASH_INTERVAL = 75;
 };
 
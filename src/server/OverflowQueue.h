@@ -0,0 +1,118 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+#include "server/MPSCRingQueue.h"
+
+/*! \class OverflowQueue
+	\brief MPSCRingQueue that keeps the elements which don't fit instead of dropping them.
+	\details Network packets must not be dropped when a queue is full: RakNet has already
+			acknowledged the reliable ones, so they would never be sent again. Elements
+			that don't fit into the ring are appended to an overflow list, which is
+			protected by a mutex. As long as the overflow list is not empty, new elements
+			are appended to it too, so the elements of a producer keep their order. The
+			consumer takes elements from the overflow list once the ring is empty.
+			The lock-free ring is used as long as the consumer keeps up; the overflow
+			list is only the slow path when it falls behind.
+			Only one thread at a time may call pop.
+*/
+template<class T>
+class OverflowQueue
+{
+	public:
+		/// creates a queue whose ring holds at least \p capacity elements.
+		explicit OverflowQueue(std::size_t capacity);
+
+		/// adds \p value to the queue. can be called from any thread.
+		/// \return false, if the ring is full and \p value was put into the overflow list.
+		bool push(const T& value);
+
+		/// removes the oldest element from the queue and stores it in \p value.
+		/// must only be called from the consumer thread.
+		/// \return false, if the queue is empty, or if the next element is still being written.
+		bool pop(T& value);
+
+		/// whether the queue is empty. only exact when called from the consumer thread
+		/// while no producer is active.
+		bool empty() const;
+
+		std::size_t capacity() const { return mRing.capacity(); }
+
+	private:
+		MPSCRingQueue<T> mRing;
+
+		std::mutex mOverflowMutex;
+		std::deque<T> mOverflow;
+		// number of elements in mOverflow, so the fast paths don't need the mutex
+		std::atomic<std::size_t> mOverflowSize;
+};
+
+// -------------------------------------------------------------------------------------------------
+//    							INLINE IMPLEMENTATION
+// -------------------------------------------------------------------------------------------------
+
+template<class T>
+OverflowQueue<T>::OverflowQueue(std::size_t capacity) : mRing(capacity), mOverflowSize(0)
+{
+}
+
+template<class T>
+bool OverflowQueue<T>::push(const T& value)
+{
+	if(mOverflowSize.load(std::memory_order_acquire) == 0 && mRing.push(value))
+		return true;
+
+	std::lock_guard<std::mutex> lock(mOverflowMutex);
+	mOverflow.push_back(value);
+	mOverflowSize.store(mOverflow.size(), std::memory_order_release);
+	return false;
+}
+
+template<class T>
+bool OverflowQueue<T>::pop(T& value)
+{
+	// the ring only contains elements that are older than those in the overflow list.
+	// A producer may still be writing one of them, so the ring has to be drained completely.
+	if(mRing.pop(value))
+		return true;
+
+	if(mOverflowSize.load(std::memory_order_acquire) == 0 || !mRing.drained())
+		return false;
+
+	std::lock_guard<std::mutex> lock(mOverflowMutex);
+	if(mOverflow.empty())
+		return false;
+	value = std::move(mOverflow.front());
+	mOverflow.pop_front();
+	mOverflowSize.store(mOverflow.size(), std::memory_order_release);
+	return true;
+}
+
+template<class T>
+bool OverflowQueue<T>::empty() const
+{
+	return mRing.empty() && mOverflowSize.load(std::memory_order_acquire) == 0;
+}
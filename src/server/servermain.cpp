@@ -22,11 +22,15 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "DedicatedServer.h"
 
 /* includes */
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <cstdio>
 #include <ctime>
+#include <fstream>
 #include <future>
+#include <thread>
+#include <memory>
 
 #include <errno.h>
 #include <unistd.h>
@@ -38,7 +42,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <SDL2/SDL_timer.h>
 
 #include "DedicatedServer.h"
+#include "Metrics.h"
+#include "MetricsServer.h"
 #include "SpeedController.h"
+#include "Trace.h"
 #include "FileSystem.h"
 #include "UserConfig.h"
 #include "Global.h"
@@ -79,13 +86,11 @@ void printHelp();
 void process_arguments(int argc, char** argv);
 void fork_to_background();
 void setup_physfs(char* argv0);
+void printStatusReport(std::ostream& stream);
+void recordTrace(const std::vector<std::string>& arguments);
 
-// server workload statistics
-int SWLS_PacketCount = 0;
-int SWLS_Connections = 0;
-int SWLS_Games		 = 0;
-int SWLS_GameSteps	 = 0;
-int SWLS_RunningTime = 0;
+// number of main loop iterations, for the status report
+std::atomic<int> SWLS_RunningTime(0);
 
 const int UPDATE_FREQUENCY = 10;
 
@@ -113,6 +118,9 @@ int main(int argc, char** argv)
 	int maxClients = 100;
 	std::string rulesFile = DEFAULT_RULES_FILE;
 	std::string gameSpeeds = "75";
+	int spinBudget = 0;
+	int snapshotInterval = 2;
+	std::string metricsSocket;
 
 	UserConfig config;
 	try
@@ -121,6 +129,9 @@ int main(int argc, char** argv)
 		maxClients = config.getInteger("maximum_clients");
 		rulesFile  = config.getString("rules", DEFAULT_RULES_FILE);
 		gameSpeeds = config.getString("speed", gameSpeeds);
+		spinBudget = config.getInteger("tick_spin_budget", spinBudget);
+		snapshotInterval = config.getInteger("snapshot_interval", snapshotInterval);
+		metricsSocket = config.getString("metrics_socket", metricsSocket);
 
 		// bring that value into a sane range
 		if(maxClients <= 0 || maxClients > 150)
@@ -142,6 +153,22 @@ int main(int argc, char** argv)
 	std::transform(speed_vec_str.begin(), speed_vec_str.end(), std::back_inserter(speed_vec), [](const std::string& v ){ return boost::lexical_cast<float>(v);});
 
 	DedicatedServer server(myinfo, rule_vec, speed_vec, maxClients);
+	server.setGameSpinBudget( std::chrono::microseconds(spinBudget) );
+	server.setSnapshotInterval( std::max(snapshotInterval, 1) );
+
+	std::unique_ptr<MetricsServer> metricsServer;
+	if( !metricsSocket.empty() )
+	{
+		try
+		{
+			metricsServer.reset( new MetricsServer(metricsSocket) );
+			syslog(LOG_NOTICE, "Serving metrics on %s", metricsSocket.c_str());
+		}
+		catch (std::exception& e)
+		{
+			syslog(LOG_ERR, "%s", e.what());
+		}
+	}
 
 	syslog(LOG_NOTICE, "Blobby Volley 2 dedicated server version %i.%i started", BLOBBY_VERSION_MAJOR, BLOBBY_VERSION_MINOR);
 
@@ -151,7 +178,7 @@ int main(int argc, char** argv)
 	while(true)
 	{
 		std::string command;
-		std::cin >> command;
+		std::getline(std::cin, command);
 
 		std::vector<std::string> cmd_vec;
 		boost::algorithm::split(cmd_vec, command, boost::algorithm::is_space(), boost::algorithm::token_compress_on);
@@ -170,14 +197,17 @@ int main(int argc, char** argv)
 		 else if ( cmd_vec[0] == "games" )
 		{
 			server.printAllGames(std::cout);
+		}
+		 else if ( cmd_vec[0] == "trace" )
+		{
+			recordTrace(cmd_vec);
 		}
 		 else if ( cmd_vec[0] == "status" )
 		{
-			std::cout << "Blobby Server Status Report " << (SWLS_RunningTime / UPDATE_FREQUENCY / 60 / 60) << "h running \n";
-			std::cout << " packet count: " << SWLS_PacketCount << "\n";
-			std::cout << " accepted connections: " << SWLS_Connections << "\n";
-			std::cout << " started games: " << SWLS_Games << "\n";
-			std::cout << " game steps: " << SWLS_GameSteps << "\n";
+			printStatusReport(std::cout);
+			TimingStatistics timing = server.getGameTimingStatistics();
+			std::cout << " step overshoot: mean " << timing.meanOvershoot << "us, max " << timing.maxOvershoot
+					  << "us, " << timing.lateFrames << " steps late by more than 1ms\n";
 		}
 
 	}
@@ -193,7 +223,11 @@ int main(int argc, char** argv)
 // ------------------------------
 void main_loop( DedicatedServer& server)
 {
+	TRACE_THREAD_NAME("server main loop");
+
 	SpeedController scontroller( UPDATE_FREQUENCY );
+	scontroller.setTimingMode( SpeedController::DEADLINE_TIMING );
+	scontroller.setSpinBudget( std::chrono::microseconds(0) );
 
 	while ( g_run_server )
 	{
@@ -201,15 +235,9 @@ void main_loop( DedicatedServer& server)
 		//  step through all network games and process input - if a game ended, delete it
 		// -------------------------------------------------------------------------------
 
-		SWLS_RunningTime++;
-
-		if(SWLS_RunningTime % (UPDATE_FREQUENCY * 60 * 60 /*1h*/) == 0 )
+		if(++SWLS_RunningTime % (UPDATE_FREQUENCY * 60 * 60 /*1h*/) == 0 )
 		{
-			std::cout << "Blobby Server Status Report " << (SWLS_RunningTime / UPDATE_FREQUENCY / 60 / 60) << "h running \n";
-			std::cout << " packet count: " << SWLS_PacketCount << "\n";
-			std::cout << " accepted connections: " << SWLS_Connections << "\n";
-			std::cout << " started games: " << SWLS_Games << "\n";
-			std::cout << " game steps: " << SWLS_GameSteps << "\n";
+			printStatusReport(std::cout);
 		}
 
 		server.processPackets();
@@ -221,6 +249,67 @@ void main_loop( DedicatedServer& server)
 
 // -----------------------------------------------------------------------------------------
 
+void printStatusReport(std::ostream& stream)
+{
+	const ServerMetrics& metrics = getServerMetrics();
+	stream << "Blobby Server Status Report " << (SWLS_RunningTime / UPDATE_FREQUENCY / 60 / 60) << "h running \n";
+	stream << " packet count: " << metrics.packetsReceived.getValue() << "\n";
+	stream << " accepted connections: " << metrics.connections.getValue() << "\n";
+	stream << " started games: " << metrics.gamesStarted.getValue() << "\n";
+	stream << " game steps: " << metrics.gameSteps.getValue() << "\n";
+	stream << " running games: " << metrics.runningGames.getValue() << "\n";
+	stream << " mean game step time: " << (metrics.tickDuration.getSum() / std::max<std::uint64_t>(metrics.tickDuration.getCount(), 1)) * 1e6 << "us\n";
+
+	std::map<std::string, CountingReport> objects = getCounterSnapshot();
+	if(!objects.empty())
+	{
+		stream << " living objects:\n";
+		for(const auto& counter : objects)
+			stream << "  " << counter.first << ": " << counter.second.alive << " (" << counter.second.created << " created)\n";
+	}
+}
+
+// -----------------------------------------------------------------------------------------
+
+// trace <duration>[s] [file]: records the server for the given number of seconds
+void recordTrace(const std::vector<std::string>& arguments)
+{
+#ifdef BLOBBY_TRACE
+	float seconds = 10;
+	std::string file = "blobby-trace.json";
+	try
+	{
+		if(arguments.size() > 1)
+			seconds = boost::lexical_cast<float>( arguments[1].substr(0, arguments[1].find_last_not_of("s") + 1) );
+		if(arguments.size() > 2)
+			file = arguments[2];
+	}
+	catch (boost::bad_lexical_cast& e)
+	{
+		std::cout << "usage: trace <seconds>[s] [file]\n";
+		return;
+	}
+
+	std::ofstream stream(file);
+	if(!stream)
+	{
+		std::cout << "could not open " << file << "\n";
+		return;
+	}
+
+	std::cout << "recording trace for " << seconds << "s\n";
+	TraceRecorder::start();
+	std::this_thread::sleep_for( std::chrono::duration<float>(seconds) );
+	TraceRecorder::stop();
+	TraceRecorder::writeChromeTrace(stream);
+	std::cout << "trace written to " << file << "\n";
+#else
+	std::cout << "tracing is not available, rebuild with -DBLOBBY_TRACE=ON\n";
+#endif
+}
+
+// -----------------------------------------------------------------------------------------
+
 void printHelp()
 {
 	std::cout << "Usage: blobby-server [OPTION...]" << std::endl;
@@ -41,6 +41,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "TextManager.h"
 #include "replays/ReplayRecorder.h"
 #include "DuelMatch.h"
+#include "PhysicWorld.h"
 #include "IMGUI.h"
 #include "SoundManager.h"
 #include "LocalInputSource.h"
@@ -51,6 +52,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "FileWrite.h"
 #include "MatchEvents.h"
 #include "SpeedController.h"
+#include "ScriptCache.h"
 #include "server/DedicatedServer.h"
 #include "LobbyStates.h"
 #include "InputManager.h"
@@ -58,6 +60,20 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 // global variable to save the lag
 int CURRENT_NETWORK_LAG = -1;
 
+// fraction of a prediction correction that is still drawn in the next frame
+const float PREDICTION_SMOOTHING = 0.75;
+// corrections larger than this are not smoothed
+const float PREDICTION_SNAP_DISTANCE = 100;
+
+// number of frames after which the input is sent, even if it did not change
+const int INPUT_HEARTBEAT_INTERVAL = 6;
+
+// client time, measured in game steps
+static double getClientTime()
+{
+	return SDL_GetTicks() * SpeedController::getMainInstance()->getGameSpeed() / 1000.0;
+}
+
 
 /* implementation */
 NetworkGameState::NetworkGameState( boost::shared_ptr<RakClient> client, int rule_checksum, int score_to_win):
@@ -66,6 +82,17 @@ NetworkGameState::NetworkGameState( boost::shared_ptr<RakClient> client, int rul
 	 mNetworkState(WAITING_FOR_OPPONENT),
 	 mWinningPlayer(NO_PLAYER),
 	 mWaitingForReplay(false),
+	 mLastSnapshot(0),
+	 mNeedKeyframe(true),
+	 mInputTick(0),
+	 mSnapshotPending(false),
+	 mPendingInputTick(0),
+	 mPendingExact(false),
+	 mPendingHasHash(false),
+	 mPendingHash(0),
+	 mStateMismatches(0),
+	 mSendInputHistory(false),
+	 mFramesSinceInput(0),
 	 mSelectedChatmessage(0),
 	 mChatCursorPosition(0),
 	 mChattext("")
@@ -73,6 +100,10 @@ NetworkGameState::NetworkGameState( boost::shared_ptr<RakClient> client, int rul
 	boost::shared_ptr<IUserConfigReader> config = IUserConfigReader::createUserConfigReader("config.xml");
 	mOwnSide = (PlayerSide)config->getInteger("network_side");
 	mUseRemoteColor = config->getBool("use_remote_color");
+	mSnapshotEncoding = config->getBool("network_quantize_snapshots", true) ?
+							SnapshotCodec::QUANTIZED_ENCODING : SnapshotCodec::EXACT_ENCODING;
+	mPredict = config->getBool("network_prediction", true);
+	mInterpolate = config->getBool("network_interpolation", true);
 	mLocalInput.reset(new LocalInputSource(mOwnSide));
 	mLocalInput->setMatch(mMatch.get());
 
@@ -149,15 +180,87 @@ void NetworkGameState::step_impl()
 				stream.Read(timeBack);
 				CURRENT_NETWORK_LAG = SDL_GetTicks() - timeBack;
 				DuelMatchState ms;
-				/// \todo this is a performance nightmare: we create a new reader for every packet!
-				///			there should be a better way to do that
-				boost::shared_ptr<GenericIn> in = createGenericReader(&stream);
-				in->generic<DuelMatchState> (ms);
+				BitStreamIn in( stream );
+				in.generic<DuelMatchState> (ms);
 				// inject network data into game
 				mMatch->setState( ms );
 				break;
 			}
 
+			case ID_GAME_UPDATE_DELTA:
+			{
+				RakNet::BitStream stream((char*)packet->data, packet->length, false);
+				stream.IgnoreBytes(1);	//ID_GAME_UPDATE_DELTA
+				unsigned timeBack;
+				unsigned int snapshot;
+				bool keyframe;
+				stream.Read(timeBack);
+				stream.Read(snapshot);
+				stream.Read(keyframe);
+				CURRENT_NETWORK_LAG = SDL_GetTicks() - timeBack;
+
+				const DuelMatchState* base = 0;
+				if(!keyframe)
+				{
+					unsigned char offset;
+					stream.Read(offset);
+					base = mSnapshots.find(snapshot - offset);
+					// we no longer know the state this delta refers to, so we have to wait for a keyframe
+					if(!base)
+					{
+						mNeedKeyframe = true;
+						break;
+					}
+				}
+				bool quantized;
+				unsigned int inputTick;
+				unsigned int serverStep;
+				stream.Read(quantized);
+				stream.Read(inputTick);
+				stream.Read(serverStep);
+
+				DuelMatchState ms;
+				SnapshotCodec codec(quantized ? SnapshotCodec::QUANTIZED_ENCODING : SnapshotCodec::EXACT_ENCODING);
+				if(!codec.decode(stream, ms, base))
+					break;
+
+				mSnapshots.store(snapshot, ms);
+				if(keyframe)
+					mNeedKeyframe = false;
+
+				// now and then, the server sends the hash of the state it has simulated
+				bool hasHash = false;
+				unsigned int hashHigh = 0, hashLow = 0;
+				if(!(stream.Read(hasHash) && hasHash && stream.Read(hashHigh) && stream.Read(hashLow)))
+					hasHash = false;
+				// packets are sent unreliable sequenced, so this is always the newest snapshot
+				mLastSnapshot = snapshot;
+				mSendInputHistory = true;
+
+				if(mInterpolate)
+					mInterpolation.add(serverStep, getClientTime(), ms);
+
+				// with prediction, the snapshot is applied before the next step. the server
+				// sends tick 0 as long as it has not received any tick from us
+				if(mPredict && inputTick != 0 && mNetworkState == PLAYING)
+				{
+					mPendingSnapshot = ms;
+					mPendingInputTick = inputTick;
+					mSnapshotPending = true;
+					// quantized snapshots round our state whenever the prediction is corrected,
+					// so only exact snapshots keep our simulation bitwise comparable
+					mPendingExact = !quantized;
+					mPendingHasHash = hasHash && !quantized;
+					mPendingHash = (std::uint64_t)hashHigh << 32 | hashLow;
+				}
+				 else
+				{
+					// inject network data into game
+					mMatch->setState( ms );
+				}
+				break;
+			}
+
 			case ID_GAME_EVENTS:
 			{
 				RakNet::BitStream stream((char*)packet->data, packet->length, false);
@@ -282,6 +385,7 @@ void NetworkGameState::step_impl()
 					FileWrite rulesFile("rules/"+TEMP_RULES_NAME);
 					rulesFile.write(rulesString.get(), rulesLength);
 					rulesFile.close();
+					ScriptCache::invalidate("rules/" + TEMP_RULES_NAME);
 					mMatch->setRules(TEMP_RULES_NAME);
 				}
 				else
@@ -376,6 +480,8 @@ void NetworkGameState::step_impl()
 	// does this generate any problems if we pause at the exact moment an event is set ( i.e. the ball hit sound
 	// could be played in a loop)?
 	presentGame();
+	if(mPredict || mInterpolate)
+		presentNetworkObjects();
 	presentGameUI();
 
 	if (InputManager::getSingleton()->exit() && mNetworkState != PLAYING)
@@ -497,10 +603,21 @@ void NetworkGameState::step_impl()
 		}
 		case PLAYING:
 		{
-			mMatch->step();
-
 			mLocalInput->updateInput();
 			PlayerInputAbs input = mLocalInput->getRealInput();
+			++mInputTick;
+
+			if(mPredict)
+			{
+				correctPrediction();
+				// simulate our own input right now instead of waiting for the server
+				mMatch->getInputSource(mOwnSide)->setInput(input);
+			}
+
+			mMatch->step();
+
+			if(mPredict)
+				mPrediction.store(mInputTick, input, mMatch->getState());
 
 			if (InputManager::getSingleton()->exit())
 			{
@@ -508,11 +625,42 @@ void NetworkGameState::step_impl()
 				stream.Write((unsigned char)ID_PAUSE);
 				mClient->Send(&stream, HIGH_PRIORITY, RELIABLE_ORDERED, 0);
 			}
+			mInputHistory.add(mInputTick, input);
+			mFramesSinceInput++;
+
+			// servers that send deltas understand the input history. it contains every change of
+			// the input several times, so it is enough to send it while the input changes, and
+			// a heartbeat now and then to acknowledge the snapshots.
+			if(mSendInputHistory && mInputHistory.isWritable())
+			{
+				if(mInputHistory.hasRecentChange() || mNeedKeyframe || mFramesSinceInput >= INPUT_HEARTBEAT_INTERVAL)
+				{
+					RakNet::BitStream stream;
+					stream.Write((unsigned char)ID_INPUT_HISTORY);
+					stream.Write( SDL_GetTicks() );
+					stream.Write( mLastSnapshot );
+					stream.Write( mNeedKeyframe );
+					stream.Write( (unsigned char)mSnapshotEncoding );
+					mInputHistory.writeTo(stream);
+					mClient->Send(&stream, HIGH_PRIORITY, UNRELIABLE_SEQUENCED, 0);
+					mFramesSinceInput = 0;
+				}
+				break;
+			}
+
 			RakNet::BitStream stream;
 			stream.Write((unsigned char)ID_INPUT_UPDATE);
 			stream.Write( SDL_GetTicks() );
 			input.writeTo(stream);
+			// tell the server which snapshot it can use as base for the next delta
+			stream.Write( mLastSnapshot );
+			stream.Write( mNeedKeyframe );
+			stream.Write( (unsigned char)mSnapshotEncoding );
+			// only servers that send deltas know what to do with the input tick
+			if(mSendInputHistory)
+				stream.Write( mInputTick );
 			mClient->Send(&stream, HIGH_PRIORITY, UNRELIABLE_SEQUENCED, 0);
+			mFramesSinceInput = 0;
 			break;
 		}
 		case PLAYER_WON:
@@ -577,6 +725,75 @@ void NetworkGameState::step_impl()
 	}
 }
 
+void NetworkGameState::correctPrediction()
+{
+	if(!mSnapshotPending)
+		return;
+	mSnapshotPending = false;
+
+	if(mPendingHasHash)
+		checkStateHash(mPendingInputTick, mPendingSnapshot, mPendingHash);
+
+	DuelMatchState before = mMatch->getState();
+	if(!mPrediction.reconcile(*mMatch, mOwnSide, mPendingInputTick, mPendingSnapshot, mInputTick, mPendingExact))
+		return;
+
+	// don't let the objects jump to their corrected positions, unless the jump is so far it
+	// is not a correction but e.g. a reset of the ball
+	DuelMatchState after = mMatch->getState();
+	for(int i = 0; i < MAX_PLAYERS; ++i)
+	{
+		PlayerSide side = (PlayerSide)i;
+		mBlobCorrection[i] += before.getBlobPosition(side) - after.getBlobPosition(side);
+		if(mBlobCorrection[i].length() > PREDICTION_SNAP_DISTANCE)
+			mBlobCorrection[i] = Vector2();
+	}
+	mBallCorrection += before.getBallPosition() - after.getBallPosition();
+	if(mBallCorrection.length() > PREDICTION_SNAP_DISTANCE)
+		mBallCorrection = Vector2();
+}
+
+void NetworkGameState::checkStateHash(unsigned int inputTick, const DuelMatchState& serverState, std::uint64_t serverHash)
+{
+	if(mPrediction.checkHash(inputTick, serverState, serverHash))
+		return;
+
+	const DuelMatchState* simulated = mPrediction.findState(inputTick);
+	std::uint64_t hash = simulated->hash();
+	++mStateMismatches;
+	std::cerr << "state hash mismatch #" << mStateMismatches << " at input tick " << inputTick << ": "
+			<< std::hex << hash << " instead of " << serverHash << std::dec << "\n" << *simulated << "\n";
+}
+
+void NetworkGameState::presentNetworkObjects()
+{
+	RenderManager& rmanager = RenderManager::getSingleton();
+
+	// our own blob is predicted, everything else is drawn as the server saw it a moment ago
+	DuelMatchState remote;
+	bool interpolated = mInterpolate && mInterpolation.interpolate(getClientTime(), remote);
+
+	for(int i = 0; i < MAX_PLAYERS; ++i)
+	{
+		PlayerSide side = (PlayerSide)i;
+		if(interpolated && !(mPredict && side == mOwnSide))
+			rmanager.setBlob(side, remote.worldState.blobPosition[i], remote.worldState.blobState[i]);
+		 else
+			rmanager.setBlob(side, mMatch->getBlobPosition(side) + mBlobCorrection[i],
+								mMatch->getWorld().getBlobState(side));
+	}
+
+	if(interpolated)
+		rmanager.setBall(remote.worldState.ballPosition, remote.worldState.ballRotation);
+	 else
+		rmanager.setBall(mMatch->getBallPosition() + mBallCorrection, mMatch->getWorld().getBallRotation());
+
+	// let the corrections fade out
+	mBlobCorrection[LEFT_PLAYER] = mBlobCorrection[LEFT_PLAYER] * PREDICTION_SMOOTHING;
+	mBlobCorrection[RIGHT_PLAYER] = mBlobCorrection[RIGHT_PLAYER] * PREDICTION_SMOOTHING;
+	mBallCorrection = mBallCorrection * PREDICTION_SMOOTHING;
+}
+
 const char* NetworkGameState::getStateName() const
 {
 	return "NetworkGameState";
@@ -586,10 +803,3 @@ void syslog(int pri, const char* format, ...)
 {
 	// do nothing?
 }
-
-// debug counters
-int SWLS_PacketCount;
-int SWLS_Connections;
-int SWLS_Games;
-int SWLS_GameSteps;
-int SWLS_ServerEntered;
@@ -23,6 +23,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "GameState.h"
 #include "NetworkMessage.h"
 #include "PlayerIdentity.h"
+#include "SnapshotCodec.h"
+#include "PredictionBuffer.h"
+#include "InterpolationBuffer.h"
+#include "InputHistory.h"
 
 #include <vector>
 #include <boost/scoped_ptr.hpp>
@@ -53,6 +57,15 @@ public:
 	virtual const char* getStateName() const;
 
 private:
+	/// compares the last snapshot with the prediction, and rewinds and re-simulates if they differ
+	void correctPrediction();
+	/// draws blobs and ball at their corrected or interpolated positions
+	void presentNetworkObjects();
+	/// compares the hash of the state we have simulated for \p inputTick with the hash of the state
+	/// the server has simulated, and logs our state if they differ. Ticks for which we have
+	/// predicted other inputs than those in \p serverState are skipped.
+	void checkStateHash(unsigned int inputTick, const DuelMatchState& serverState, std::uint64_t serverHash);
+
 	enum
 	{
 		WAITING_FOR_OPPONENT,
@@ -74,6 +87,36 @@ private:
 
 	bool mWaitingForReplay;
 
+	// delta compressed snapshots
+	SnapshotCodec::Encoding mSnapshotEncoding;
+	SnapshotHistory mSnapshots;
+	unsigned int mLastSnapshot;
+	bool mNeedKeyframe;
+
+	// client side prediction
+	bool mPredict;
+	unsigned int mInputTick;			// tick of the last input that was sent to the server
+	PredictionBuffer mPrediction;
+	bool mSnapshotPending;				// a snapshot arrived which has not been compared with the prediction yet
+	DuelMatchState mPendingSnapshot;
+	unsigned int mPendingInputTick;		// tick of the last of our inputs included in mPendingSnapshot
+	bool mPendingExact;					// mPendingSnapshot was not quantized
+	bool mPendingHasHash;				// mPendingHash is the hash of the server's state after mPendingInputTick
+	std::uint64_t mPendingHash;
+	unsigned int mStateMismatches;		// simulated states whose hash differed from the server's
+	// offsets between the drawn and the simulated positions, which let corrections fade in
+	Vector2 mBlobCorrection[MAX_PLAYERS];
+	Vector2 mBallCorrection;
+
+	// redundant input transport
+	bool mSendInputHistory;				// the server sends deltas, so it understands ID_INPUT_HISTORY and input ticks
+	InputHistory mInputHistory;
+	int mFramesSinceInput;				// frames since the input was last sent
+
+	// interpolation of the remote state
+	bool mInterpolate;
+	InterpolationBuffer mInterpolation;
+
 	boost::shared_ptr<RakClient> mClient;
 	PlayerSide mOwnSide;
 	PlayerSide mWinningPlayer;
@@ -34,6 +34,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "ReplaySelectionState.h"
 #include "InputManager.h"
 #include "FileWrite.h"
+#include "ScriptCache.h"
 
 /* implementation */
 
@@ -65,6 +66,7 @@ void ReplayState::loadReplay(const std::string& file)
 		FileWrite rulesFile("rules/"+TEMP_RULES_NAME);
 		rulesFile.write(mReplayPlayer->getRules());
 		rulesFile.close();
+		ScriptCache::invalidate("rules/" + TEMP_RULES_NAME);
 		mMatch.reset(new DuelMatch(false, TEMP_RULES_NAME));
 
 		SoundManager::getSingleton().playSound(	"sounds/pfiff.wav", ROUND_START_SOUND_VOLUME);
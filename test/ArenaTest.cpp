@@ -0,0 +1,146 @@
+#define BOOST_TEST_MODULE Arena
+#include <boost/test/unit_test.hpp>
+
+#include "arena/Arena.h"
+#include "arena/WorkStealingPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <stdexcept>
+#include <thread>
+
+BOOST_AUTO_TEST_SUITE( work_stealing_pool )
+
+BOOST_AUTO_TEST_CASE( runs_all_tasks )
+{
+	WorkStealingPool pool(4);
+	std::atomic<int> sum(0);
+	for(int i = 1; i <= 1000; ++i)
+		pool.submit([&sum, i]() { sum += i; });
+	pool.wait();
+	BOOST_CHECK_EQUAL( sum, 500500 );
+
+	// the pool can be reused after waiting
+	pool.submit([&sum]() { sum = 0; });
+	pool.wait();
+	BOOST_CHECK_EQUAL( sum, 0 );
+}
+
+// tasks submitted by a task go to the queue of the worker, and idle workers steal them
+BOOST_AUTO_TEST_CASE( idle_workers_steal )
+{
+	WorkStealingPool pool(4);
+	std::atomic<int> count(0);
+	pool.submit([&pool, &count]()
+	{
+		for(int i = 0; i < 40; ++i)
+		{
+			pool.submit([&count]()
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				++count;
+			});
+		}
+	});
+	pool.wait();
+	BOOST_CHECK_EQUAL( count, 40 );
+	BOOST_CHECK_GT( pool.getStolenCount(), 0u );
+}
+
+BOOST_AUTO_TEST_CASE( exceptions_reach_wait )
+{
+	WorkStealingPool pool(2);
+	std::atomic<int> count(0);
+	for(int i = 0; i < 10; ++i)
+	{
+		pool.submit([&count, i]()
+		{
+			++count;
+			if(i == 3)
+				throw std::runtime_error("bot crashed");
+		});
+	}
+	BOOST_CHECK_THROW( pool.wait(), std::runtime_error );
+	BOOST_CHECK_EQUAL( count, 10 );
+
+	// the error is only reported once
+	pool.wait();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE( schedules )
+
+BOOST_AUTO_TEST_CASE( round_robin )
+{
+	std::vector<Arena::Pairing> pairings = Arena::roundRobin(4, 2);
+	BOOST_CHECK_EQUAL( pairings.size(), 4 * 3 * 2u );
+
+	// every ordered pair exactly twice
+	std::map<std::pair<int, int>, int> count;
+	for(const auto& pairing : pairings)
+	{
+		BOOST_CHECK_NE( pairing.left, pairing.right );
+		++count[std::make_pair(pairing.left, pairing.right)];
+	}
+	BOOST_CHECK_EQUAL( count.size(), 12u );
+	for(const auto& entry : count)
+		BOOST_CHECK_EQUAL( entry.second, 2 );
+}
+
+BOOST_AUTO_TEST_CASE( swiss_pairs_neighbours )
+{
+	std::vector<double> points = {1, 4, 2, 3};
+	std::vector<std::vector<int>> played(4, std::vector<int>(4, 0));
+	std::vector<int> byes(4, 0);
+	int bye;
+
+	std::vector<Arena::Pairing> pairings = Arena::swissRound(points, played, byes, bye);
+	BOOST_CHECK_EQUAL( bye, -1 );
+	BOOST_REQUIRE_EQUAL( pairings.size(), 2u );
+	BOOST_CHECK_EQUAL( pairings[0].left, 1 );
+	BOOST_CHECK_EQUAL( pairings[0].right, 3 );
+	BOOST_CHECK_EQUAL( pairings[1].left, 2 );
+	BOOST_CHECK_EQUAL( pairings[1].right, 0 );
+
+	// avoid a rematch
+	played[1][3] = played[3][1] = 1;
+	pairings = Arena::swissRound(points, played, byes, bye);
+	BOOST_REQUIRE_EQUAL( pairings.size(), 2u );
+	BOOST_CHECK_EQUAL( pairings[0].left, 1 );
+	BOOST_CHECK_EQUAL( pairings[0].right, 2 );
+}
+
+BOOST_AUTO_TEST_CASE( swiss_bye )
+{
+	std::vector<double> points = {3, 2, 1};
+	std::vector<std::vector<int>> played(3, std::vector<int>(3, 0));
+	std::vector<int> byes(3, 0);
+	int bye;
+
+	std::vector<Arena::Pairing> pairings = Arena::swissRound(points, played, byes, bye);
+	BOOST_CHECK_EQUAL( bye, 2 );
+	BOOST_CHECK_EQUAL( pairings.size(), 1u );
+
+	// nobody gets a second bye before everybody had one
+	byes[2] = 1;
+	Arena::swissRound(points, played, byes, bye);
+	BOOST_CHECK_EQUAL( bye, 1 );
+}
+
+BOOST_AUTO_TEST_CASE( elo )
+{
+	double a = 1500, b = 1500;
+	Arena::updateElo(a, b, 1);
+	BOOST_CHECK_CLOSE( a, 1508, 1e-9 );
+	BOOST_CHECK_CLOSE( a + b, 3000, 1e-9 );
+
+	// a draw against a weaker player costs rating
+	double strong = 1700, weak = 1300;
+	Arena::updateElo(strong, weak, 0.5);
+	BOOST_CHECK_LT( strong, 1700 );
+	BOOST_CHECK_GT( weak, 1300 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
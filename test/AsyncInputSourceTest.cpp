@@ -0,0 +1,85 @@
+#define BOOST_TEST_MODULE AsyncInputSource
+#include <boost/test/unit_test.hpp>
+
+#include "AsyncInputSource.h"
+#include "DuelMatch.h"
+
+#include <boost/make_shared.hpp>
+
+#include <chrono>
+#include <future>
+
+namespace
+{
+	// jumps when the ball is right of x, but only decides once the test opens the gate
+	class GatedInputSource : public InputSource
+	{
+		public:
+			GatedInputSource(float x) : mX(x), mOpen(mGate.get_future().share())
+			{
+			}
+
+			void open() { mGate.set_value(); }
+			const DuelMatch* seenMatch() const { return mMatch; }
+
+		private:
+			virtual PlayerInputAbs getNextInput()
+			{
+				mMatch = getMatch();
+				mOpen.wait();
+				return PlayerInputAbs(false, false, getMatch()->getBallPosition().x > mX);
+			}
+
+			float mX;
+			std::promise<void> mGate;
+			std::shared_future<void> mOpen;
+			const DuelMatch* mMatch = nullptr;
+	};
+
+	struct Fixture
+	{
+		Fixture() : match(false, FALLBACK_RULES_NAME, 15)
+		{
+		}
+
+		DuelMatch match;
+	};
+}
+
+BOOST_FIXTURE_TEST_SUITE( async_input_source, Fixture )
+
+// a source that is ready decides within the budget, on a snapshot of the match
+BOOST_AUTO_TEST_CASE( in_time )
+{
+	auto bot = boost::make_shared<GatedInputSource>(100);
+	bot->open();
+	auto async = boost::make_shared<AsyncInputSource>(bot, RIGHT_PLAYER, std::chrono::seconds(10));
+	match.setInputSources(boost::make_shared<InputSource>(), async);
+
+	match.step();
+	BOOST_CHECK( match.getInputSource(RIGHT_PLAYER)->getInput().up );
+	BOOST_CHECK( bot->seenMatch() != &match );
+	BOOST_CHECK_EQUAL( async->getStepCount(), 1u );
+	BOOST_CHECK_EQUAL( async->getMissedDeadlines(), 0u );
+}
+
+// a source that has not decided misses the deadline, and the previous decision is used instead
+BOOST_AUTO_TEST_CASE( too_late )
+{
+	auto bot = boost::make_shared<GatedInputSource>(100);
+	auto async = boost::make_shared<AsyncInputSource>(bot, RIGHT_PLAYER, std::chrono::milliseconds(100));
+	match.setInputSources(boost::make_shared<InputSource>(), async);
+
+	match.step();
+	BOOST_CHECK_EQUAL( async->getMissedDeadlines(), 1u );
+	BOOST_CHECK( !(match.getInputSource(RIGHT_PLAYER)->getInput().up) );
+
+	// the late decision is used in the next step
+	bot->open();
+	match.step();
+	BOOST_CHECK_EQUAL( async->getStepCount(), 2u );
+	BOOST_CHECK_EQUAL( async->getMissedDeadlines(), 1u );
+	BOOST_CHECK( match.getInputSource(RIGHT_PLAYER)->getInput().up );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
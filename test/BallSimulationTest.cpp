@@ -0,0 +1,161 @@
+#define BOOST_TEST_MODULE BallSimulation
+#include <boost/test/unit_test.hpp>
+
+#include "PhysicWorld.h"
+#include "GameConstants.h"
+
+#include <cstring>
+#include <random>
+
+namespace
+{
+	bool sameBits(const Vector2& a, const Vector2& b)
+	{
+		return std::memcmp(&a.x, &b.x, sizeof(float)) == 0 && std::memcmp(&a.y, &b.y, sizeof(float)) == 0;
+	}
+
+	struct Throw
+	{
+		Vector2 position;
+		Vector2 velocity;
+	};
+
+	// random balls all over the field, including ones that touch the net and the walls
+	std::vector<Throw> createThrows(int count)
+	{
+		std::mt19937 random(42);
+		std::uniform_real_distribution<float> x(LEFT_PLANE + BALL_RADIUS, RIGHT_PLANE - BALL_RADIUS);
+		std::uniform_real_distribution<float> y(0, GROUND_PLANE_HEIGHT_MAX - BALL_RADIUS);
+		std::uniform_real_distribution<float> v(-BALL_COLLISION_VELOCITY, BALL_COLLISION_VELOCITY);
+
+		std::vector<Throw> throws;
+		for(int i = 0; i < count; ++i)
+			throws.push_back( Throw{Vector2(x(random), y(random)), Vector2(v(random), v(random))} );
+
+		// straight onto the net sphere and along the net
+		throws.push_back( Throw{Vector2(NET_POSITION_X, 100), Vector2(0, 0)} );
+		throws.push_back( Throw{Vector2(NET_POSITION_X - 20, 100), Vector2(0.5, 0)} );
+		throws.push_back( Throw{Vector2(NET_POSITION_X - 60, 400), Vector2(3, -2)} );
+		return throws;
+	}
+}
+
+BOOST_AUTO_TEST_SUITE( ball_simulation )
+
+// the ball prediction gives exactly the same results as stepping a PhysicWorld
+BOOST_AUTO_TEST_CASE( conformance )
+{
+	const int STEPS = 500;
+	PhysicWorld world;
+	for(const auto& t : createThrows(2000))
+	{
+		world.setBallPosition(t.position);
+		world.setBallVelocity(t.velocity);
+		std::vector<Vector2> positions;
+		std::vector<Vector2> velocities;
+		for(int i = 0; i < STEPS; ++i)
+		{
+			world.step(PlayerInput(), PlayerInput(), false, true);
+			positions.push_back(world.getBallPosition());
+			velocities.push_back(world.getBallVelocity());
+		}
+
+		// single steps, and longer runs which skip the collision tests in free flight
+		for(int steps : {1, 7, 60, 375, STEPS})
+		{
+			Vector2 position = t.position;
+			Vector2 velocity = t.velocity;
+			for(int done = steps; done <= STEPS; done += steps)
+			{
+				PhysicWorld::simulateBall(position, velocity, steps);
+				BOOST_REQUIRE( sameBits(positions[done - 1], position) );
+				BOOST_REQUIRE( sameBits(velocities[done - 1], velocity) );
+			}
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE( until )
+{
+	PhysicWorld world;
+	for(const auto& t : createThrows(200))
+	{
+		auto stop = [](const Vector2& pos) { return 600 - pos.y < 200; };
+
+		world.setBallPosition(t.position);
+		world.setBallVelocity(t.velocity);
+		int expected = -1;
+		for(int i = 1; i <= 375; ++i)
+		{
+			world.step(PlayerInput(), PlayerInput(), false, true);
+			if( stop(world.getBallPosition()) )
+			{
+				expected = i;
+				break;
+			}
+		}
+
+		Vector2 position = t.position;
+		Vector2 velocity = t.velocity;
+		BOOST_CHECK_EQUAL( PhysicWorld::simulateBallUntil(position, velocity, stop, 375), expected );
+		BOOST_CHECK( sameBits(world.getBallPosition(), position) );
+		BOOST_CHECK( sameBits(world.getBallVelocity(), velocity) );
+	}
+}
+
+// longer predictions over many throws end where stepping the world ends
+BOOST_AUTO_TEST_CASE( many_throws )
+{
+	auto throws = createThrows(1000);
+	const int STEPS = 375;
+
+	PhysicWorld world;
+	float stepChecksum = 0;
+	for(const auto& t : throws)
+	{
+		world.setBallPosition(t.position);
+		world.setBallVelocity(t.velocity);
+		for(int i = 0; i < STEPS; ++i)
+			world.step(PlayerInput(), PlayerInput(), false, true);
+		stepChecksum += world.getBallPosition().x;
+	}
+
+	float simulateChecksum = 0;
+	for(const auto& t : throws)
+	{
+		Vector2 position = t.position;
+		Vector2 velocity = t.velocity;
+		PhysicWorld::simulateBall(position, velocity, STEPS);
+		simulateChecksum += position.x;
+	}
+
+	BOOST_CHECK_EQUAL( stepChecksum, simulateChecksum );
+
+	// the typical bot question: when does the ball come down to the height of the blob's head?
+	auto stop = [](const Vector2& pos) { return 600 - pos.y < 220; };
+	int stepCount = 0;
+	for(const auto& t : throws)
+	{
+		world.setBallPosition(t.position);
+		world.setBallVelocity(t.velocity);
+		for(int i = 0; i < STEPS; ++i, ++stepCount)
+		{
+			world.step(PlayerInput(), PlayerInput(), false, true);
+			if( stop(world.getBallPosition()) )
+				break;
+		}
+	}
+
+	int simulateCount = 0;
+	for(const auto& t : throws)
+	{
+		Vector2 position = t.position;
+		Vector2 velocity = t.velocity;
+		int steps = PhysicWorld::simulateBallUntil(position, velocity, stop, STEPS);
+		simulateCount += steps < 0 ? STEPS : steps - 1;
+	}
+
+	BOOST_CHECK_EQUAL( stepCount, simulateCount );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,79 @@
+#define BOOST_TEST_MODULE Crc32
+#include <boost/test/unit_test.hpp>
+
+#include "Crc32.h"
+
+#include <boost/crc.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+	std::vector<char> randomData(std::size_t length)
+	{
+		std::vector<char> data(length);
+		for(auto& c : data)
+			c = std::rand();
+		return data;
+	}
+
+	// the checksum as FileRead::calcChecksum calculated it in older versions
+	uint32_t oldChecksum(const std::vector<char>& data)
+	{
+		boost::crc_32_type crc;
+		std::size_t position = 0;
+		while(true)
+		{
+			int maxread = std::min<std::size_t>(128, data.size() - position);
+			for(int i = 0; i < maxread; ++i)
+			{
+				crc.process_bytes(data.data() + position, maxread);
+			}
+			position += maxread;
+
+			if(maxread < 32)
+				break;
+		}
+		return crc();
+	}
+}
+
+BOOST_AUTO_TEST_SUITE( crc )
+
+BOOST_AUTO_TEST_CASE( check_value )
+{
+	BOOST_CHECK_EQUAL( crc32("123456789", 9), 0xCBF43926u );
+	BOOST_CHECK_EQUAL( crc32("", 0), 0u );
+}
+
+BOOST_AUTO_TEST_CASE( same_as_boost )
+{
+	for(std::size_t length : {1, 7, 8, 9, 63, 64, 1000, 4097})
+	{
+		std::vector<char> data = randomData(length);
+		boost::crc_32_type reference;
+		reference.process_bytes(data.data(), data.size());
+		BOOST_CHECK_EQUAL( crc32(data.data(), data.size()), reference() );
+	}
+}
+
+// the checksum of the whole data equals the chained checksum of its parts
+BOOST_AUTO_TEST_CASE( chaining )
+{
+	std::vector<char> data = randomData(1000);
+	uint32_t crc = crc32(data.data(), 333);
+	crc = crc32(data.data() + 333, 667, crc);
+	BOOST_CHECK_EQUAL( crc, crc32(data.data(), data.size()) );
+}
+
+BOOST_AUTO_TEST_CASE( legacy )
+{
+	for(std::size_t length : {0, 1, 31, 32, 100, 127, 128, 129, 159, 160, 256, 5000, 5023})
+	{
+		std::vector<char> data = randomData(length);
+		BOOST_CHECK_EQUAL( legacyChecksum(data.data(), data.size()), oldChecksum(data) );
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
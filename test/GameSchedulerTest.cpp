@@ -0,0 +1,190 @@
+#define BOOST_TEST_MODULE GameScheduler
+#include <boost/test/unit_test.hpp>
+
+#include "server/GameScheduler.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <boost/accumulators/accumulators.hpp>
+#include <boost/accumulators/statistics/stats.hpp>
+#include <boost/accumulators/statistics/max.hpp>
+#include <boost/accumulators/statistics/mean.hpp>
+using namespace boost::accumulators;
+
+typedef std::chrono::steady_clock test_clock;
+typedef accumulator_set<double, stats<tag::mean, tag::max> > jitter_stats;
+
+const float GAME_SPEED = 75;
+const int STEP_WORK_US = 50;	// simulated cost of a single game step
+const int LOAD_TEST_SECONDS = 3;
+
+// simulates a network game: does some work each step and records the tick timing
+struct DummyGame
+{
+	test_clock::time_point lastTick;
+	bool started = false;
+	int steps = 0;
+	jitter_stats jitter;
+
+	void step()
+	{
+		test_clock::time_point now = test_clock::now();
+		if(started)
+		{
+			double interval = std::chrono::duration<double, std::micro>(now - lastTick).count();
+			jitter( std::abs(interval - 1e6 / GAME_SPEED) );
+		}
+		started = true;
+		lastTick = now;
+		++steps;
+
+		// busy wait, so we actually use cpu time
+		while( test_clock::now() - now < std::chrono::microseconds(STEP_WORK_US) );
+	}
+};
+
+struct LoadResult
+{
+	double meanJitter = 0;	// mean absolute deviation from the tick period, in µs
+	double maxJitter = 0;
+	double cpuPerGame = 0;	// cpu time per game per second, in ms
+	int minSteps = 1 << 30;
+};
+
+LoadResult evaluate(const std::vector<DummyGame>& games, std::clock_t cpu)
+{
+	LoadResult result;
+	for(auto& g : games)
+	{
+		result.meanJitter += mean(g.jitter) / games.size();
+		result.maxJitter = std::max(result.maxJitter, max(g.jitter));
+		result.minSteps = std::min(result.minSteps, g.steps);
+	}
+	result.cpuPerGame = 1000.0 * cpu / CLOCKS_PER_SEC / games.size() / LOAD_TEST_SECONDS;
+	return result;
+}
+
+// the old model: one thread per game that sleeps until its next step
+LoadResult runThreadPerGame(int count)
+{
+	std::vector<DummyGame> games(count);
+	std::atomic<bool> running(true);
+	std::vector<std::thread> threads;
+
+	std::clock_t start = std::clock();
+	for(auto& game : games)
+	{
+		threads.push_back(std::thread([&game, &running]()
+		{
+			auto next = test_clock::now();
+			while(running)
+			{
+				game.step();
+				next += std::chrono::duration_cast<test_clock::duration>(std::chrono::duration<double>(1.0 / GAME_SPEED));
+				std::this_thread::sleep_until(next);
+			}
+		}));
+	}
+
+	std::this_thread::sleep_for(std::chrono::seconds(LOAD_TEST_SECONDS));
+	running = false;
+	for(auto& t : threads)
+		t.join();
+
+	return evaluate(games, std::clock() - start);
+}
+
+LoadResult runScheduled(int count, unsigned workers)
+{
+	std::vector<DummyGame> games(count);
+	std::clock_t start = std::clock();
+	{
+		std::atomic<bool> running(true);
+		GameScheduler scheduler(workers);
+		for(auto& game : games)
+		{
+			scheduler.addTask([&game, &running]() { game.step(); return bool(running); }, GAME_SPEED);
+		}
+
+		std::this_thread::sleep_for(std::chrono::seconds(LOAD_TEST_SECONDS));
+		running = false;
+	}
+
+	return evaluate(games, std::clock() - start);
+}
+
+void printResult(const char* name, int games, const LoadResult& r)
+{
+	BOOST_TEST_MESSAGE( name << " " << games << " games: mean jitter " << r.meanJitter << "µs, max jitter "
+				<< r.maxJitter << "µs, cpu per game " << r.cpuPerGame << "ms/s" );
+}
+
+BOOST_AUTO_TEST_SUITE( game_scheduler )
+
+BOOST_AUTO_TEST_CASE( tick_rate )
+{
+	std::atomic<int> fast(0);
+	std::atomic<int> slow(0);
+	{
+		GameScheduler scheduler(2);
+		scheduler.addTask([&fast]() { ++fast; return true; }, 100);
+		scheduler.addTask([&slow]() { ++slow; return true; }, 20);
+		std::this_thread::sleep_for(std::chrono::seconds(1));
+	}
+
+	BOOST_CHECK( std::abs(fast - 100) <= 2 );
+	BOOST_CHECK( std::abs(slow - 20) <= 1 );
+}
+
+BOOST_AUTO_TEST_CASE( remove_task )
+{
+	std::atomic<int> ticks(0);
+	GameScheduler scheduler(1);
+	scheduler.addTask([&ticks]() { return ++ticks < 10; }, 1000);
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	BOOST_CHECK_EQUAL( ticks, 10 );
+	BOOST_CHECK_EQUAL( scheduler.getTaskCount(), 0 );
+}
+
+BOOST_AUTO_TEST_CASE( no_concurrent_ticks )
+{
+	std::atomic<int> active(0);
+	std::atomic<bool> overlap(false);
+	{
+		GameScheduler scheduler(4);
+		scheduler.addTask([&]()
+			{
+				if(++active > 1)
+					overlap = true;
+				std::this_thread::sleep_for(std::chrono::milliseconds(5));
+				--active;
+				return true;
+			}, 1000);
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+	}
+	BOOST_CHECK( !overlap );
+}
+
+// load test comparing the scheduler to one thread per game. prints jitter and cpu usage
+BOOST_AUTO_TEST_CASE( load_test )
+{
+	const int expected_steps = LOAD_TEST_SECONDS * GAME_SPEED;
+	for(int games : {10, 50, 150})
+	{
+		LoadResult threaded = runThreadPerGame(games);
+		printResult("thread per game", games, threaded);
+
+		LoadResult scheduled = runScheduled(games, 0);
+		printResult("scheduler      ", games, scheduled);
+
+		BOOST_CHECK( scheduled.minSteps > expected_steps * 0.95 );
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
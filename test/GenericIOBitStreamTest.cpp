@@ -0,0 +1,166 @@
+#define BOOST_TEST_MODULE GenericIOBitStream
+#include <boost/test/unit_test.hpp>
+
+#include "GenericIO.h"
+#include "GenericIOBitStream.h"
+#include "DuelMatchState.h"
+#include "raknet/BitStream.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// counts every allocation of the test program
+std::atomic<long> allocations(0);
+
+void* operator new(std::size_t size)
+{
+	++allocations;
+	if(void* p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+DuelMatchState createState()
+{
+	DuelMatchState state;
+	state.worldState.blobPosition[LEFT_PLAYER] = Vector2(200, 400);
+	state.worldState.blobPosition[RIGHT_PLAYER] = Vector2(600, 350.5);
+	state.worldState.blobVelocity[LEFT_PLAYER] = Vector2(4.5, 0);
+	state.worldState.blobVelocity[RIGHT_PLAYER] = Vector2(0, -12.25);
+	state.worldState.blobState[LEFT_PLAYER] = 2;
+	state.worldState.blobState[RIGHT_PLAYER] = 0.5;
+	state.worldState.ballPosition = Vector2(321.75, 250);
+	state.worldState.ballVelocity = Vector2(3.25, 1);
+	state.worldState.ballRotation = 1.5;
+	state.worldState.ballAngularVelocity = 0.1;
+
+	state.logicState.leftScore = 7;
+	state.logicState.rightScore = 12;
+	state.logicState.hitCount[LEFT_PLAYER] = 2;
+	state.logicState.hitCount[RIGHT_PLAYER] = 0;
+	state.logicState.servingPlayer = RIGHT_PLAYER;
+	state.logicState.winningPlayer = NO_PLAYER;
+	state.logicState.squish[LEFT_PLAYER] = 0;
+	state.logicState.squish[RIGHT_PLAYER] = 3;
+	state.logicState.squishWall = 0;
+	state.logicState.squishGround = 0;
+	state.logicState.isGameRunning = true;
+	state.logicState.isBallValid = false;
+
+	state.playerInput[LEFT_PLAYER] = PlayerInput(true, false, true);
+	state.playerInput[RIGHT_PLAYER] = PlayerInput(false, true, false);
+	return state;
+}
+
+bool sameData(const RakNet::BitStream& a, const RakNet::BitStream& b)
+{
+	return a.GetNumberOfBitsUsed() == b.GetNumberOfBitsUsed() &&
+			std::memcmp(a.GetData(), b.GetData(), a.GetNumberOfBytesUsed()) == 0;
+}
+
+BOOST_AUTO_TEST_SUITE( generic_io_bitstream )
+
+// BitStreamOut writes exactly what the dynamic GenericOut writes
+BOOST_AUTO_TEST_CASE( wire_compatible )
+{
+	DuelMatchState state = createState();
+
+	RakNet::BitStream dynamicStream;
+	boost::shared_ptr<GenericOut> dynamicOut = createGenericWriter(&dynamicStream);
+	dynamicOut->generic<DuelMatchState>(state);
+	dynamicOut->generic<std::string>("blobby");
+	dynamicOut->generic<Color>(Color(10, 20, 30));
+	dynamicOut->generic<PlayerSide>(NO_PLAYER);
+
+	RakNet::BitStream staticStream;
+	BitStreamOut staticOut(staticStream);
+	staticOut.generic<DuelMatchState>(state);
+	staticOut.generic<std::string>("blobby");
+	staticOut.generic<Color>(Color(10, 20, 30));
+	staticOut.generic<PlayerSide>(NO_PLAYER);
+
+	BOOST_CHECK( sameData(dynamicStream, staticStream) );
+
+	// read the dynamically written data with the static reader
+	BitStreamIn staticIn(dynamicStream);
+	DuelMatchState read;
+	std::string name;
+	Color color;
+	PlayerSide side;
+	staticIn.generic<DuelMatchState>(read);
+	staticIn.generic<std::string>(name);
+	staticIn.generic<Color>(color);
+	staticIn.generic<PlayerSide>(side);
+
+	RakNet::BitStream again;
+	BitStreamOut againOut(again);
+	againOut.generic<DuelMatchState>(read);
+	RakNet::BitStream expected;
+	BitStreamOut expectedOut(expected);
+	expectedOut.generic<DuelMatchState>(state);
+	BOOST_CHECK( sameData(again, expected) );
+	BOOST_CHECK_EQUAL( name, "blobby" );
+	BOOST_CHECK( color == Color(10, 20, 30) );
+	BOOST_CHECK_EQUAL( side, NO_PLAYER );
+}
+
+// sending and receiving a game state in steady state does not touch the heap
+BOOST_AUTO_TEST_CASE( no_allocations )
+{
+	DuelMatchState state = createState();
+	DuelMatchState received;
+	RakNet::BitStream stream;
+
+	// warm up, so one-time initialisations are not counted
+	for(int i = 0; i < 10; ++i)
+	{
+		stream.Reset();
+		BitStreamOut out(stream);
+		out.generic<DuelMatchState>(state);
+		BitStreamIn in(stream);
+		in.generic<DuelMatchState>(received);
+	}
+
+	long before = allocations;
+	for(int i = 0; i < 10000; ++i)
+	{
+		stream.Reset();
+		stream.Write((unsigned char)1);
+		stream.Write((unsigned int)i);
+		BitStreamOut out(stream);
+		out.generic<DuelMatchState>(state);
+
+		stream.ResetReadPointer();
+		stream.IgnoreBits(8 + 32);
+		BitStreamIn in(stream);
+		in.generic<DuelMatchState>(received);
+	}
+	long staticAllocations = allocations - before;
+
+	before = allocations;
+	for(int i = 0; i < 10000; ++i)
+	{
+		stream.Reset();
+		stream.Write((unsigned char)1);
+		stream.Write((unsigned int)i);
+		createGenericWriter(&stream)->generic<DuelMatchState>(state);
+
+		stream.ResetReadPointer();
+		stream.IgnoreBits(8 + 32);
+		createGenericReader(&stream)->generic<DuelMatchState>(received);
+	}
+	long dynamicAllocations = allocations - before;
+
+	BOOST_TEST_MESSAGE( "allocations for 10000 packets: static " << staticAllocations << ", dynamic " << dynamicAllocations );
+	BOOST_CHECK_EQUAL( staticAllocations, 0 );
+	BOOST_CHECK_GT( dynamicAllocations, 0 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,146 @@
+#define BOOST_TEST_MODULE HeadlessMatch
+#include <boost/test/unit_test.hpp>
+#include <boost/make_shared.hpp>
+
+#include "HeadlessMatch.h"
+#include "TimeSource.h"
+#include "Clock.h"
+#include "DuelMatch.h"
+#include "FileSystem.h"
+#include "ScriptedInputSource.h"
+#include "SpeedController.h"
+
+#include <chrono>
+#include <thread>
+
+#define TEST_DATA_PATH "../data"
+
+void initFileSystem()
+{
+	static FileSystem fs( TEST_DATA_PATH );
+	static bool initialised = false;
+	if(!initialised)
+	{
+		fs.addToSearchPath(TEST_DATA_PATH);
+		initialised = true;
+	}
+}
+
+boost::shared_ptr<InputSource> createBot(PlayerSide side)
+{
+	// the bots are seeded, so each match is played the same way
+	auto bot = boost::make_shared<ScriptedInputSource>("scripts/com_11.lua", side, 0);
+	bot->seedRandom(side);
+	return bot;
+}
+
+BOOST_AUTO_TEST_SUITE( time_source )
+
+BOOST_AUTO_TEST_CASE( scoped_virtual_time )
+{
+	BOOST_CHECK( TimeSource::current().isRealTime() );
+
+	VirtualTimeSource time(1000);
+	{
+		ScopedTimeSource scope(time);
+		BOOST_CHECK_EQUAL( TimeSource::ticks(), 1000u );
+		BOOST_CHECK( !TimeSource::current().isRealTime() );
+
+		// another thread still sees the real time
+		bool real = false;
+		std::thread other([&real]() { real = TimeSource::current().isRealTime(); });
+		other.join();
+		BOOST_CHECK( real );
+
+		// three steps of 1000/75 ms do not lose a millisecond
+		for(int i = 0; i < 3; ++i)
+			time.advance(1000.0 / 75);
+		BOOST_CHECK_EQUAL( TimeSource::ticks(), 1040u );
+
+		// delay does not wait, it advances the time
+		TimeSource::current().delay(60);
+		BOOST_CHECK_EQUAL( TimeSource::ticks(), 1100u );
+	}
+	BOOST_CHECK( TimeSource::current().isRealTime() );
+}
+
+BOOST_AUTO_TEST_CASE( clock_uses_virtual_time )
+{
+	VirtualTimeSource time;
+	ScopedTimeSource scope(time);
+
+	Clock clock;
+	clock.reset();
+	clock.start();
+	time.advance(61500);
+	clock.step();
+	BOOST_CHECK_EQUAL( clock.getTime(), 61 );
+	BOOST_CHECK_EQUAL( clock.getTimeString(), "01:01" );
+}
+
+BOOST_AUTO_TEST_CASE( speed_controller_does_not_sleep )
+{
+	VirtualTimeSource time;
+	ScopedTimeSource scope(time);
+
+	SpeedController controller(75);
+	controller.setTimingMode(SpeedController::DEADLINE_TIMING);
+	auto start = std::chrono::steady_clock::now();
+	for(int i = 0; i < 750; ++i)
+		controller.update();
+
+	// ten seconds of game, without waiting for them
+	BOOST_CHECK_GE( TimeSource::ticks(), 9900u );
+	BOOST_CHECK( std::chrono::steady_clock::now() - start < std::chrono::seconds(1) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE( headless_match )
+
+// the bots wait WAITING_TIME before serving, measured in game time
+BOOST_AUTO_TEST_CASE( serve_delay )
+{
+	initFileSystem();
+	HeadlessMatch match(FALLBACK_RULES_NAME, 5, createBot);
+
+	Vector2 start = match.getMatch().getBlobPosition(LEFT_PLAYER);
+	// 1.4 seconds
+	for(int i = 0; i < 105; ++i)
+		match.step();
+	BOOST_CHECK( match.getMatch().getBlobPosition(LEFT_PLAYER) == start );
+
+	// 2 seconds
+	for(int i = 0; i < 45; ++i)
+		match.step();
+	BOOST_CHECK( match.getMatch().getBlobPosition(LEFT_PLAYER) != start );
+}
+
+BOOST_AUTO_TEST_CASE( bot_match )
+{
+	initFileSystem();
+
+	auto start = std::chrono::steady_clock::now();
+	HeadlessMatch first(FALLBACK_RULES_NAME, 5, createBot);
+	HeadlessMatch::Result result = first.run();
+	auto duration = std::chrono::steady_clock::now() - start;
+
+	BOOST_REQUIRE( result.winner != NO_PLAYER );
+	BOOST_CHECK_EQUAL( std::max(result.score[LEFT_PLAYER], result.score[RIGHT_PLAYER]), 5 );
+	BOOST_CHECK_EQUAL( result.gameTime, (int)(result.steps / 75) );
+
+	BOOST_TEST_MESSAGE( "bot match " << result.score[LEFT_PLAYER] << ":" << result.score[RIGHT_PLAYER]
+			<< ", " << result.gameTime << "s game time in "
+			<< std::chrono::duration_cast<std::chrono::milliseconds>(duration).count() << "ms" );
+	BOOST_CHECK( duration * 20 < std::chrono::seconds(result.gameTime) );
+
+	// the simulation does not depend on how fast it runs
+	HeadlessMatch second(FALLBACK_RULES_NAME, 5, createBot);
+	HeadlessMatch::Result again = second.run();
+	BOOST_CHECK_EQUAL( again.winner, result.winner );
+	BOOST_CHECK_EQUAL( again.score[LEFT_PLAYER], result.score[LEFT_PLAYER] );
+	BOOST_CHECK_EQUAL( again.score[RIGHT_PLAYER], result.score[RIGHT_PLAYER] );
+	BOOST_CHECK_EQUAL( again.steps, result.steps );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
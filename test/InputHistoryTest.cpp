@@ -0,0 +1,144 @@
+#define BOOST_TEST_MODULE InputHistory
+#include <boost/test/unit_test.hpp>
+
+#include "InputHistory.h"
+#include "server/InputJitterBuffer.h"
+#include "raknet/BitStream.h"
+
+#include <cstdlib>
+
+// the input of the simulated player changes every 25 ticks
+PlayerInputAbs inputAt(unsigned int tick)
+{
+	unsigned int phase = tick / 25;
+	return PlayerInputAbs(phase % 3 == 1, phase % 3 == 2, phase % 4 == 3);
+}
+
+bool same(const PlayerInputAbs& a, const PlayerInputAbs& b)
+{
+	return a.toPlayerInput(0) == b.toPlayerInput(0);
+}
+
+BOOST_AUTO_TEST_SUITE( input_history )
+
+BOOST_AUTO_TEST_CASE( round_trip )
+{
+	InputHistory history;
+	for(unsigned int tick = 1; tick <= 20; ++tick)
+		history.add(tick, PlayerInputAbs(tick & 1, tick & 2, tick & 4));
+
+	RakNet::BitStream stream;
+	history.writeTo(stream);
+	BOOST_CHECK_EQUAL( stream.GetNumberOfBitsUsed(), 32 + 8 + 3 * (int)InputHistory::SIZE );
+
+	unsigned int newest;
+	PlayerInputAbs inputs[InputHistory::SIZE];
+	BOOST_REQUIRE_EQUAL( InputHistory::readFrom(stream, newest, inputs), (int)InputHistory::SIZE );
+	BOOST_CHECK_EQUAL( newest, 20 );
+	for(int i = 0; i < InputHistory::SIZE; ++i)
+	{
+		unsigned int tick = newest - InputHistory::SIZE + 1 + i;
+		BOOST_CHECK( same(inputs[i], PlayerInputAbs(tick & 1, tick & 2, tick & 4)) );
+	}
+}
+
+BOOST_AUTO_TEST_CASE( recent_change )
+{
+	InputHistory history;
+	unsigned int tick = 1;
+	for(int i = 0; i < InputHistory::SIZE; ++i)
+	{
+		BOOST_CHECK( history.hasRecentChange() );
+		history.add(tick++, PlayerInputAbs());
+	}
+	// the history is full, and the input did not change since the first tick
+	history.add(tick++, PlayerInputAbs());
+	BOOST_CHECK( !history.hasRecentChange() );
+
+	// a change is sent in the next SIZE packets
+	for(int i = 0; i < InputHistory::SIZE; ++i)
+	{
+		history.add(tick++, PlayerInputAbs(false, false, true));
+		BOOST_CHECK( history.hasRecentChange() );
+	}
+	history.add(tick++, PlayerInputAbs(false, false, true));
+	BOOST_CHECK( !history.hasRecentChange() );
+
+	// absolute input can't be written with three bits
+	PlayerInputAbs mouse;
+	mouse.setTarget(200, LEFT_PLAYER);
+	history.add(tick++, mouse);
+	BOOST_CHECK( !history.isWritable() );
+}
+
+// the history is only writable while none of the inputs it contains is absolute
+BOOST_AUTO_TEST_CASE( absolute_input )
+{
+	InputHistory history;
+	PlayerInputAbs mouse;
+	mouse.setTarget(200, LEFT_PLAYER);
+
+	// the ticks don't start at a multiple of the history size
+	unsigned int tick = 101;
+	history.add(tick++, mouse);
+	BOOST_CHECK( !history.isWritable() );
+
+	for(int i = 1; i < InputHistory::SIZE; ++i)
+	{
+		history.add(tick++, PlayerInputAbs());
+		BOOST_CHECK( !history.isWritable() );
+	}
+	// the absolute input has dropped out of the history
+	history.add(tick++, PlayerInputAbs());
+	BOOST_CHECK( history.isWritable() );
+}
+
+// with 20% packet loss, the server still simulates nearly every input of the client at the right step
+BOOST_AUTO_TEST_CASE( lossy_transport )
+{
+	std::srand(3);
+	InputHistory history;
+	InputJitterBuffer buffer;
+	buffer.setSparse(true);
+
+	const int HEARTBEAT = 6;
+	int sent = 0;
+	int framesSinceSend = 0;
+	int wrong = 0;
+	PlayerInputAbs applied;
+	for(unsigned int tick = 1; tick < 5000; ++tick)
+	{
+		history.add(tick, inputAt(tick));
+		if(history.hasRecentChange() || ++framesSinceSend >= HEARTBEAT)
+		{
+			framesSinceSend = 0;
+			++sent;
+
+			RakNet::BitStream stream;
+			history.writeTo(stream);
+			if(std::rand() % 5 != 0)
+			{
+				unsigned int newest;
+				PlayerInputAbs inputs[InputHistory::SIZE];
+				int count = InputHistory::readFrom(stream, newest, inputs);
+				for(int i = 0; i < count; ++i)
+					buffer.push(newest - (count - 1 - i), inputs[i]);
+			}
+		}
+
+		// the server steps once per client tick
+		PlayerInputAbs input;
+		if(buffer.pop(input))
+			applied = input;
+		if(buffer.getTick() != 0 && !same(applied, inputAt(buffer.getTick())))
+			++wrong;
+	}
+
+	BOOST_TEST_MESSAGE( "sent " << sent << " packets for 5000 ticks, " << wrong << " steps with wrong input, "
+			  << buffer.getStatistics().late << " late inputs" );
+	BOOST_CHECK_LT( sent, 5000 / 2 );
+	// a change is only late if several packets in a row are lost
+	BOOST_CHECK_LT( wrong, 5000 / 100 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
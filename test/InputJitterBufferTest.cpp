@@ -0,0 +1,152 @@
+#define BOOST_TEST_MODULE InputJitterBuffer
+#include <boost/test/unit_test.hpp>
+
+#include "server/InputJitterBuffer.h"
+
+PlayerInputAbs inputFor(unsigned int tick)
+{
+	return PlayerInputAbs(tick & 1, tick & 2, tick & 4);
+}
+
+BOOST_AUTO_TEST_SUITE( input_jitter_buffer )
+
+BOOST_AUTO_TEST_CASE( inactive )
+{
+	InputJitterBuffer buffer;
+	PlayerInputAbs input;
+	BOOST_CHECK( !buffer.isActive() );
+	BOOST_CHECK( !buffer.pop(input) );
+	BOOST_CHECK_EQUAL( buffer.getTick(), 0 );
+}
+
+// two inputs arriving in the same step are both used, one per step
+BOOST_AUTO_TEST_CASE( no_input_lost )
+{
+	InputJitterBuffer buffer;
+	unsigned int tick = 1;
+	unsigned int expected = 1;
+	for(int step = 0; step < 1000; ++step)
+	{
+		// every other step, two inputs arrive at once
+		int count = step % 2 == 0 ? 2 : 0;
+		for(int i = 0; i < count; ++i, ++tick)
+			buffer.push(tick, inputFor(tick));
+
+		PlayerInputAbs input;
+		if(buffer.pop(input))
+		{
+			BOOST_REQUIRE_EQUAL( buffer.getTick(), expected );
+			BOOST_CHECK( input.toPlayerInput(0) == inputFor(expected).toPlayerInput(0) );
+			++expected;
+		}
+	}
+
+	BOOST_CHECK_GT( expected, 990 );
+	BOOST_CHECK_EQUAL( buffer.getStatistics().late, 0 );
+	BOOST_CHECK_EQUAL( buffer.getStatistics().dropped, 0 );
+}
+
+BOOST_AUTO_TEST_CASE( duplicates_and_late )
+{
+	InputJitterBuffer buffer;
+	PlayerInputAbs input;
+	for(unsigned int tick = 1; tick <= 3; ++tick)
+		buffer.push(tick, inputFor(tick));
+	BOOST_CHECK( buffer.pop(input) );
+	BOOST_CHECK_EQUAL( buffer.getTick(), 1 );
+
+	// an input that was already used is no late input
+	buffer.push(1, inputFor(1));
+	buffer.push(2, inputFor(2));
+	BOOST_CHECK_EQUAL( buffer.getStatistics().received, 3 );
+	BOOST_CHECK_EQUAL( buffer.getStatistics().late, 0 );
+
+	// tick 4 is lost, 5 arrives
+	buffer.push(5, inputFor(5));
+	BOOST_CHECK( buffer.pop(input) );
+	BOOST_CHECK( buffer.pop(input) );
+	BOOST_CHECK( !buffer.pop(input) );
+	BOOST_CHECK_EQUAL( buffer.getTick(), 4 );
+	BOOST_CHECK_EQUAL( buffer.getStatistics().dropped, 1 );
+
+	buffer.push(4, inputFor(4));
+	BOOST_CHECK_EQUAL( buffer.getStatistics().late, 1 );
+}
+
+// the reserve grows when the buffer runs empty, and shrinks again when the inputs arrive regularly
+BOOST_AUTO_TEST_CASE( adaptive_delay )
+{
+	InputJitterBuffer buffer;
+	PlayerInputAbs input;
+	unsigned int tick = 1;
+	for(int step = 0; step < 20; ++step)
+	{
+		buffer.push(tick++, input);
+		buffer.pop(input);
+	}
+	// a gap of 5 steps
+	for(int step = 0; step < 5; ++step)
+		buffer.pop(input);
+	for(int i = 0; i < 5; ++i)
+		buffer.push(tick++, input);
+	unsigned int raised = buffer.getDelay();
+	BOOST_CHECK_GT( raised, (unsigned int)InputJitterBuffer::INITIAL_DELAY );
+	BOOST_CHECK_GT( buffer.getStatistics().underruns, 0 );
+
+	for(int step = 0; step < 20 * (int)InputJitterBuffer::ADAPTION_PERIOD; ++step)
+	{
+		buffer.push(tick++, input);
+		buffer.pop(input);
+	}
+	BOOST_CHECK_LT( buffer.getDelay(), raised );
+	BOOST_CHECK_LE( tick - 1 - buffer.getTick(), buffer.getDelay() + 2 );
+}
+
+// a step is in sequence if it used the input of the tick after the one of the step before
+BOOST_AUTO_TEST_CASE( in_sequence )
+{
+	InputJitterBuffer buffer;
+	PlayerInputAbs input;
+	for(unsigned int tick = 1; tick <= 4; ++tick)
+		buffer.push(tick, inputFor(tick));
+
+	// the steps before the first input did not use the inputs of the client
+	BOOST_CHECK( buffer.pop(input) );
+	BOOST_CHECK( !buffer.isInSequence() );
+	BOOST_CHECK( buffer.pop(input) );
+	BOOST_CHECK( buffer.isInSequence() );
+
+	// tick 5 is lost
+	buffer.push(6, inputFor(6));
+	buffer.push(7, inputFor(7));
+	BOOST_CHECK( buffer.pop(input) );
+	BOOST_CHECK( buffer.pop(input) );
+	BOOST_CHECK( !buffer.pop(input) );
+	BOOST_CHECK_EQUAL( buffer.getTick(), 5 );
+	BOOST_CHECK( !buffer.isInSequence() );
+	BOOST_CHECK( buffer.pop(input) );
+	BOOST_CHECK( buffer.isInSequence() );
+	BOOST_CHECK( buffer.pop(input) );
+
+	// the buffer runs empty, so the step does not use an input at all
+	BOOST_CHECK( !buffer.pop(input) );
+	BOOST_CHECK_EQUAL( buffer.getStatistics().underruns, 1 );
+	BOOST_CHECK_EQUAL( buffer.getTick(), 7 );
+	BOOST_CHECK( !buffer.isInSequence() );
+
+	// in sparse mode, a tick that was not sent repeats the previous input, as on the client
+	buffer.setSparse(true);
+	for(unsigned int tick = 8; tick <= 11; ++tick)
+		buffer.push(tick, inputFor(tick));
+	buffer.push(13, inputFor(13));
+	for(unsigned int tick = 8; tick <= 11; ++tick)
+	{
+		BOOST_CHECK( buffer.pop(input) );
+		BOOST_CHECK( buffer.isInSequence() );
+	}
+	BOOST_CHECK( !buffer.pop(input) );
+	BOOST_CHECK_EQUAL( buffer.getTick(), 12 );
+	BOOST_CHECK( buffer.isInSequence() );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,87 @@
+#define BOOST_TEST_MODULE InterpolationBuffer
+#include <boost/test/unit_test.hpp>
+
+#include "InterpolationBuffer.h"
+
+#include <cstdlib>
+
+DuelMatchState stateAt(float x)
+{
+	DuelMatchState state;
+	state.worldState.blobPosition[LEFT_PLAYER] = Vector2(x, 400);
+	state.worldState.blobPosition[RIGHT_PLAYER] = Vector2(800 - x, 400);
+	state.worldState.ballPosition = Vector2(x, 200);
+	state.worldState.ballRotation = 0;
+	return state;
+}
+
+// feeds a snapshot every second step, which arrives up to jitter steps late
+double feed(InterpolationBuffer& buffer, int count, int jitter)
+{
+	std::srand(5);
+	double time = 0;
+	for(int step = 0; step < 2 * count; step += 2)
+	{
+		time = 100 + step + (jitter ? std::rand() % (jitter + 1) : 0);
+		buffer.add(step, time, stateAt(step));
+	}
+	return time;
+}
+
+BOOST_AUTO_TEST_SUITE( interpolation_buffer )
+
+BOOST_AUTO_TEST_CASE( empty )
+{
+	InterpolationBuffer buffer;
+	DuelMatchState state;
+	BOOST_CHECK( !buffer.interpolate(0, state) );
+}
+
+// objects move continuously between the snapshots
+BOOST_AUTO_TEST_CASE( interpolates )
+{
+	InterpolationBuffer buffer;
+	feed(buffer, 200, 0);
+	BOOST_CHECK_CLOSE( buffer.getDelay(), 2, 5 );
+
+	DuelMatchState state;
+	for(double time = 480; time < 500; time += 0.25)
+	{
+		BOOST_REQUIRE( buffer.interpolate(time, state) );
+		double expected = time - 100 - buffer.getDelay();
+		BOOST_CHECK_CLOSE( state.worldState.ballPosition.x, expected, 0.01 );
+		BOOST_CHECK_CLOSE( state.worldState.blobPosition[RIGHT_PLAYER].x, 800 - expected, 0.01 );
+	}
+
+	// no extrapolation beyond the newest snapshot
+	buffer.interpolate(1000, state);
+	BOOST_CHECK_EQUAL( state.worldState.ballPosition.x, 398 );
+}
+
+// late snapshots increase the delay
+BOOST_AUTO_TEST_CASE( adapts_to_jitter )
+{
+	InterpolationBuffer steady;
+	feed(steady, 500, 0);
+	InterpolationBuffer jittery;
+	feed(jittery, 500, 6);
+
+	BOOST_CHECK_GT( jittery.getJitter(), 1 );
+	BOOST_CHECK_GT( jittery.getDelay(), steady.getDelay() + 2 * jittery.getJitter() - 0.5 );
+}
+
+// objects that were reset are not moved across the field
+BOOST_AUTO_TEST_CASE( teleport )
+{
+	InterpolationBuffer buffer;
+	buffer.add(0, 0, stateAt(100));
+	buffer.add(2, 2, stateAt(600));
+
+	DuelMatchState state;
+	buffer.interpolate(0.8 + buffer.getDelay(), state);
+	BOOST_CHECK_EQUAL( state.worldState.ballPosition.x, 100 );
+	buffer.interpolate(1.2 + buffer.getDelay(), state);
+	BOOST_CHECK_EQUAL( state.worldState.ballPosition.x, 600 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
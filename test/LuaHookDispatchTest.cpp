@@ -0,0 +1,203 @@
+#define BOOST_TEST_MODULE LuaHookDispatch
+#include <boost/test/unit_test.hpp>
+#include <boost/make_shared.hpp>
+
+#include "DuelMatch.h"
+#include "DuelMatchState.h"
+#include "FileSystem.h"
+#include "FileWrite.h"
+#include "GameLogic.h"
+#include "InputSource.h"
+#include "ScriptCache.h"
+#include "ScriptedInputSource.h"
+
+#define TEST_DATA_PATH "../data"
+
+// a bot that walks to its left while the opponent serves, and jumps during the game
+const char* BOT_SCRIPT =
+	"function OnServe(ballready) right() end\n"
+	"function OnOpponentServe() left() end\n"
+	"function OnGame() jump() end\n";
+
+const char* BOT_FILE = "lua_hook_dispatch_bot.lua";
+
+void initFileSystem()
+{
+	static FileSystem fs( TEST_DATA_PATH );
+	static bool initialised = false;
+	if(!initialised)
+	{
+		fs.addToSearchPath(TEST_DATA_PATH);
+		fs.setWriteDir(".");
+		fs.addToSearchPath(".");
+		initialised = true;
+	}
+}
+
+struct FileSystemFixture
+{
+	FileSystemFixture()
+	{
+		initFileSystem();
+	}
+};
+
+struct LogicFixture : FileSystemFixture
+{
+	LogicFixture() : match( false, FALLBACK_RULES_NAME, 15 )
+	{
+	}
+
+	GameLogic create(const std::string& rules)
+	{
+		return createGameLogic(rules, &match, 15);
+	}
+
+	// lets enough time pass that the next collision counts
+	void wait(GameLogic& logic)
+	{
+		for(int i = 0; i < 50; ++i)
+			logic->step( match.getState() );
+	}
+
+	DuelMatch match;
+};
+
+// lets enough time pass that the next collision counts
+void waitSteps(DuelMatch& match)
+{
+	for(int i = 0; i < 12; ++i)
+		match.step();
+}
+
+void checkSameState(IGameLogic& a, IGameLogic& b)
+{
+	for(PlayerSide side : {LEFT_PLAYER, RIGHT_PLAYER})
+	{
+		BOOST_CHECK_EQUAL( a.getScore(side), b.getScore(side) );
+		BOOST_CHECK_EQUAL( a.getTouches(side), b.getTouches(side) );
+	}
+	BOOST_CHECK_EQUAL( a.getServingPlayer(), b.getServingPlayer() );
+	BOOST_CHECK_EQUAL( a.isBallValid(), b.isBallValid() );
+	BOOST_CHECK_EQUAL( a.isGameRunning(), b.isGameRunning() );
+	BOOST_CHECK_EQUAL( a.getWinningPlayer(), b.getWinningPlayer() );
+}
+
+BOOST_AUTO_TEST_SUITE( lua_hook_dispatch )
+
+// a hook the rules script defines is called instead of the default behaviour. The
+// hooks query the match, so the rules have to run inside a DuelMatch.
+BOOST_AUTO_TEST_CASE( rules_hook )
+{
+	initFileSystem();
+	DuelMatch rules(false, "one_hit_wonder.lua", 15);
+	DuelMatch fallback(false, FALLBACK_RULES_NAME, 15);
+	BOOST_REQUIRE_EQUAL( createGameLogic("one_hit_wonder.lua", &rules, 15)->getTitle(), "Crazy Volley - One Hit Wonder" );
+
+	for(DuelMatch* match : {&rules, &fallback})
+	{
+		match->setInputSources(boost::make_shared<InputSource>(), boost::make_shared<InputSource>());
+		match->trigger(MatchEvent(MatchEvent::BALL_HIT_BLOB, LEFT_PLAYER));
+		match->step();
+		waitSteps(*match);
+		match->trigger(MatchEvent(MatchEvent::BALL_HIT_BLOB, LEFT_PLAYER));
+		match->step();
+	}
+
+	// one hit wonder only allows a single touch
+	BOOST_CHECK_EQUAL( rules.getScore(RIGHT_PLAYER), 1 );
+	BOOST_CHECK_EQUAL( rules.getServingPlayer(), RIGHT_PLAYER );
+	BOOST_CHECK_EQUAL( fallback.getScore(RIGHT_PLAYER), 0 );
+	BOOST_CHECK_EQUAL( fallback.getTouches(LEFT_PLAYER), 2 );
+}
+
+// jumping jack only defines HandleInput. All other events have to behave exactly
+// like the fallback rules.
+BOOST_AUTO_TEST_CASE( missing_hooks_fall_back )
+{
+	LogicFixture fixture;
+	GameLogic rules = fixture.create("jumping_jack.lua");
+	GameLogic fallback = fixture.create(FALLBACK_RULES_NAME);
+	BOOST_REQUIRE_EQUAL( rules->getTitle(), "Crazy Volley - Jumping Jack" );
+
+	PlayerInput input = rules->transformInput(PlayerInput(true, false, false), LEFT_PLAYER);
+	BOOST_CHECK( input == PlayerInput(true, false, true) );
+	input = fallback->transformInput(PlayerInput(true, false, false), LEFT_PLAYER);
+	BOOST_CHECK( input == PlayerInput(true, false, false) );
+
+	for(GameLogic* logic : {&rules, &fallback})
+	{
+		IGameLogic& l = **logic;
+		// too many touches on the left side
+		for(int i = 0; i < 4; ++i)
+		{
+			fixture.wait(*logic);
+			l.onBallHitsPlayer(LEFT_PLAYER);
+		}
+		fixture.wait(*logic);
+		l.onServe();
+
+		// a regular exchange, ending on the ground of the right side
+		fixture.wait(*logic);
+		l.onBallHitsPlayer(RIGHT_PLAYER);
+		fixture.wait(*logic);
+		l.onBallHitsWall(RIGHT_PLAYER);
+		fixture.wait(*logic);
+		l.onBallHitsNet(RIGHT_PLAYER);
+		fixture.wait(*logic);
+		l.onBallHitsPlayer(LEFT_PLAYER);
+		fixture.wait(*logic);
+		l.onBallHitsGround(RIGHT_PLAYER);
+		fixture.wait(*logic);
+	}
+	checkSameState(*rules, *fallback);
+	BOOST_CHECK_EQUAL( fallback->getScore(RIGHT_PLAYER), 1 );
+
+	// IsWinning is missing as well
+	for(GameLogic* logic : {&rules, &fallback})
+	{
+		(*logic)->setScore(LEFT_PLAYER, 14);
+		fixture.wait(*logic);
+		(*logic)->onBallHitsPlayer(LEFT_PLAYER);
+		fixture.wait(*logic);
+		(*logic)->onBallHitsGround(RIGHT_PLAYER);
+		fixture.wait(*logic);
+	}
+	checkSameState(*rules, *fallback);
+}
+
+// the bot returns its input from __OnStep. The pooled lua states are reused by the
+// next bots, which must not see the functions of the previous ones.
+BOOST_AUTO_TEST_CASE( bot_step )
+{
+	initFileSystem();
+	FileWrite file(BOT_FILE);
+	file.write(BOT_SCRIPT);
+	file.close();
+
+	for(int round = 0; round < 3; ++round)
+	{
+		DuelMatch match(false, FALLBACK_RULES_NAME, 15);
+		auto bot = boost::make_shared<ScriptedInputSource>(BOT_FILE, RIGHT_PLAYER, 0);
+		match.setInputSources(boost::make_shared<InputSource>(), bot);
+
+		// the left player serves. Bots see the field mirrored, so left() moves the
+		// right blob away from the net.
+		for(int i = 0; i < 10; ++i)
+		{
+			match.step();
+			BOOST_CHECK( match.getState().playerInput[RIGHT_PLAYER] == PlayerInput(false, true, false) );
+		}
+	}
+
+	// a bot without __OnStep is rejected
+	FileWrite broken(BOT_FILE);
+	broken.write("__OnStep = nil\n");
+	broken.close();
+	ScriptCache::invalidate(BOT_FILE);
+	BOOST_CHECK_THROW( ScriptedInputSource(BOT_FILE, RIGHT_PLAYER, 0), ScriptException );
+
+	FileSystem::getSingleton().deleteFile(BOT_FILE);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
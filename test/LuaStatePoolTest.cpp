@@ -0,0 +1,111 @@
+#define BOOST_TEST_MODULE LuaStatePool
+#include <boost/test/unit_test.hpp>
+
+#include "LuaStatePool.h"
+
+extern "C"
+{
+#include "lua/lua.h"
+#include "lua/lauxlib.h"
+#include "lua/lualib.h"
+}
+
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+	int initialisations = 0;
+
+	void initialize(lua_State* state)
+	{
+		++initialisations;
+		luaL_dostring(state, "CONSTANT = 5\nfunction api() return CONSTANT end");
+	}
+
+	double getNumber(lua_State* state, const char* name)
+	{
+		lua_getglobal(state, name);
+		double value = lua_tonumber(state, -1);
+		lua_pop(state, 1);
+		return value;
+	}
+
+	bool hasGlobal(lua_State* state, const char* name)
+	{
+		lua_getglobal(state, name);
+		bool result = !lua_isnil(state, -1);
+		lua_pop(state, 1);
+		return result;
+	}
+}
+
+BOOST_AUTO_TEST_SUITE( lua_state_pool )
+
+// a released state is reused, with the globals it had after initialisation
+BOOST_AUTO_TEST_CASE( reuse )
+{
+	initialisations = 0;
+	LuaStatePool pool(initialize);
+
+	lua_State* state = pool.acquire();
+	BOOST_CHECK_EQUAL( initialisations, 1 );
+	luaL_dostring(state, "CONSTANT = 7\nfunction api() return 0 end\nMATCH_VALUE = 3");
+	BOOST_CHECK_EQUAL( getNumber(state, "CONSTANT"), 7 );
+	pool.release(state);
+	BOOST_CHECK_EQUAL( pool.getAvailable(), 1u );
+
+	lua_State* second = pool.acquire();
+	BOOST_CHECK_EQUAL( second, state );
+	BOOST_CHECK_EQUAL( initialisations, 1 );
+	BOOST_CHECK_EQUAL( getNumber(second, "CONSTANT"), 5 );
+	BOOST_CHECK( !hasGlobal(second, "MATCH_VALUE") );
+
+	lua_getglobal(second, "api");
+	BOOST_REQUIRE_EQUAL( lua_pcall(second, 0, 1, 0), LUA_OK );
+	BOOST_CHECK_EQUAL( lua_tonumber(second, -1), 5 );
+	pool.release(second);
+}
+
+// a game that changes a standard library does not change it for the next game
+BOOST_AUTO_TEST_CASE( library_tables )
+{
+	LuaStatePool pool([](lua_State* state){ luaL_openlibs(state); });
+
+	lua_State* state = pool.acquire();
+	BOOST_REQUIRE_EQUAL( luaL_dostring(state, "math.floor = function() return 42 end\n"
+											"math.answer = 42\nstring.upper = nil"), LUA_OK );
+	pool.release(state);
+
+	lua_State* second = pool.acquire();
+	BOOST_CHECK_EQUAL( second, state );
+	BOOST_REQUIRE_EQUAL( luaL_dostring(second, "FLOOR = math.floor(2.5)\n"
+											"HAS_ANSWER = math.answer ~= nil\nUPPER = ('a'):upper()"), LUA_OK );
+	BOOST_CHECK_EQUAL( getNumber(second, "FLOOR"), 2 );
+	lua_getglobal(second, "HAS_ANSWER");
+	BOOST_CHECK( !lua_toboolean(second, -1) );
+	lua_getglobal(second, "UPPER");
+	BOOST_CHECK_EQUAL( std::string(lua_tostring(second, -1)), "A" );
+	pool.release(second);
+}
+
+BOOST_AUTO_TEST_CASE( capacity )
+{
+	LuaStatePool pool(initialize, 1);
+	lua_State* first = pool.acquire();
+	lua_State* second = pool.acquire();
+	BOOST_CHECK( first != second );
+
+	pool.release(first);
+	pool.release(second);
+	BOOST_CHECK_EQUAL( pool.getAvailable(), 1u );
+}
+
+BOOST_AUTO_TEST_CASE( failing_initializer )
+{
+	LuaStatePool pool([](lua_State*){ throw std::runtime_error("error"); });
+	BOOST_CHECK_THROW( pool.acquire(), std::runtime_error );
+	BOOST_CHECK_EQUAL( pool.getAvailable(), 0u );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,76 @@
+#define BOOST_TEST_MODULE Metrics
+#include <boost/test/unit_test.hpp>
+
+#include "server/Metrics.h"
+#include "ScriptTime.h"
+
+#include <sstream>
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE( metrics )
+
+// counting from several threads loses nothing
+BOOST_AUTO_TEST_CASE( counter_threads )
+{
+	MetricCounter counter("test_total", "test counter");
+	std::vector<std::thread> threads;
+	for(int t = 0; t < 12; ++t)
+	{
+		threads.push_back(std::thread([&counter]()
+			{
+				for(int i = 0; i < 100000; ++i)
+					counter.add();
+			}));
+	}
+	for(auto& thread : threads)
+		thread.join();
+
+	BOOST_CHECK_EQUAL( counter.getValue(), 1200000u );
+}
+
+BOOST_AUTO_TEST_CASE( counter_format )
+{
+	MetricCounter counter("test_total", "test counter");
+	counter.add(5);
+
+	std::ostringstream stream;
+	counter.write(stream);
+	BOOST_CHECK_EQUAL( stream.str(), "# HELP test_total test counter\n# TYPE test_total counter\ntest_total 5\n" );
+}
+
+// histogram buckets are written cumulative, with a final +Inf bucket
+BOOST_AUTO_TEST_CASE( histogram_format )
+{
+	MetricHistogram histogram("test_seconds", "test histogram", {1, 2, 4});
+	histogram.observe(0.5);
+	histogram.observe(1);
+	histogram.observe(3);
+	histogram.observe(10);
+
+	BOOST_CHECK_EQUAL( histogram.getCount(), 4u );
+	BOOST_CHECK_CLOSE( histogram.getSum(), 14.5, 1e-9 );
+
+	std::ostringstream stream;
+	histogram.write(stream);
+	BOOST_CHECK_EQUAL( stream.str(),
+		"# HELP test_seconds test histogram\n"
+		"# TYPE test_seconds histogram\n"
+		"test_seconds_bucket{le=\"1\"} 2\n"
+		"test_seconds_bucket{le=\"2\"} 2\n"
+		"test_seconds_bucket{le=\"4\"} 3\n"
+		"test_seconds_bucket{le=\"+Inf\"} 4\n"
+		"test_seconds_sum 14.5\n"
+		"test_seconds_count 4\n" );
+}
+
+BOOST_AUTO_TEST_CASE( script_time )
+{
+	ScriptTime::take();
+	ScriptTime::add(std::chrono::milliseconds(2));
+	ScriptTime::add(std::chrono::milliseconds(3));
+	BOOST_CHECK( ScriptTime::take() == std::chrono::milliseconds(5) );
+	BOOST_CHECK( ScriptTime::take() == std::chrono::steady_clock::duration::zero() );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
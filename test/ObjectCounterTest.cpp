@@ -0,0 +1,57 @@
+#define BOOST_TEST_MODULE ObjectCounter
+#include <boost/test/unit_test.hpp>
+
+#include "BlobbyDebug.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+struct Counted : public ObjectCounter<Counted>
+{
+};
+
+BOOST_AUTO_TEST_SUITE( object_counter )
+
+BOOST_AUTO_TEST_CASE( alive_and_created )
+{
+	{
+		Counted a;
+		Counted b(a);
+		BOOST_CHECK_EQUAL( getObjectCount(typeid(Counted)), 2 );
+	}
+	BOOST_CHECK_EQUAL( getObjectCount(typeid(Counted)), 0 );
+
+	std::map<std::string, CountingReport> snapshot = getCounterSnapshot();
+	BOOST_REQUIRE( snapshot.count("Counted") );
+	BOOST_CHECK_EQUAL( snapshot["Counted"].created, 2 );
+}
+
+// objects can be created and destroyed from several threads at once
+BOOST_AUTO_TEST_CASE( threads )
+{
+	int before = getCounterSnapshot()["Counted"].created;
+
+	std::vector<std::thread> threads;
+	for(int t = 0; t < 8; ++t)
+	{
+		threads.push_back(std::thread([]()
+			{
+				std::vector<std::unique_ptr<Counted>> objects;
+				for(int i = 0; i < 100000; ++i)
+				{
+					objects.emplace_back(new Counted);
+					if(objects.size() > 10)
+						objects.clear();
+				}
+			}));
+	}
+	for(auto& thread : threads)
+		thread.join();
+
+	CountingReport counts = getCounterSnapshot()["Counted"];
+	BOOST_CHECK_EQUAL( counts.alive, 0 );
+	BOOST_CHECK_EQUAL( counts.created - before, 800000 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
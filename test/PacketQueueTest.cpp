@@ -0,0 +1,275 @@
+#define BOOST_TEST_MODULE PacketQueue
+#include <boost/test/unit_test.hpp>
+
+#include "server/MPSCRingQueue.h"
+#include "server/OverflowQueue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+// stand-in for packet_ptr. the packets are allocated up front, so only the queue
+// operations are measured.
+typedef boost::shared_ptr<int> test_packet;
+typedef std::chrono::steady_clock bench_clock;
+
+const int PACKETS_PER_PRODUCER = 200000;
+
+// the queue design that was used before: a std::list protected by a mutex
+class MutexListQueue
+{
+	public:
+		explicit MutexListQueue(std::size_t) { }
+
+		bool push(const test_packet& p)
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mList.push_back(p);
+			return true;
+		}
+
+		bool pop(test_packet& p)
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if(mList.empty())
+				return false;
+			p = mList.front();
+			mList.pop_front();
+			return true;
+		}
+
+	private:
+		std::list<test_packet> mList;
+		std::mutex mMutex;
+};
+
+struct BenchResult
+{
+	double throughput;	// packets per second
+	double p99;			// enqueue latency in ns
+};
+
+template<class Queue>
+BenchResult runBenchmark(int producers)
+{
+	Queue queue(1024);
+	std::vector<test_packet> packets;
+	for(int i = 0; i < PACKETS_PER_PRODUCER; ++i)
+		packets.push_back( boost::make_shared<int>(i) );
+
+	std::vector< std::vector<float> > latencies(producers, std::vector<float>(PACKETS_PER_PRODUCER));
+	std::atomic<int> received(0);
+	const int total = producers * PACKETS_PER_PRODUCER;
+
+	auto start = bench_clock::now();
+	std::thread consumer([&]()
+		{
+			test_packet p;
+			while(received < total)
+			{
+				if(queue.pop(p))
+					++received;
+				else
+					std::this_thread::yield();
+			}
+		});
+
+	std::vector<std::thread> threads;
+	for(int t = 0; t < producers; ++t)
+	{
+		threads.push_back(std::thread([&, t]()
+			{
+				for(int i = 0; i < PACKETS_PER_PRODUCER; ++i)
+				{
+					auto before = bench_clock::now();
+					while(!queue.push(packets[i]))
+						std::this_thread::yield();
+					latencies[t][i] = std::chrono::duration<float, std::nano>(bench_clock::now() - before).count();
+				}
+			}));
+	}
+
+	for(auto& t : threads)
+		t.join();
+	consumer.join();
+	double seconds = std::chrono::duration<double>(bench_clock::now() - start).count();
+
+	std::vector<float> all;
+	for(auto& l : latencies)
+		all.insert(all.end(), l.begin(), l.end());
+	auto p99 = all.begin() + all.size() * 99 / 100;
+	std::nth_element(all.begin(), p99, all.end());
+
+	return BenchResult{ total / seconds, *p99 };
+}
+
+BOOST_AUTO_TEST_SUITE( mpsc_ring_queue )
+
+BOOST_AUTO_TEST_CASE( capacity )
+{
+	MPSCRingQueue<int> queue(5);
+	BOOST_CHECK_EQUAL( queue.capacity(), 8 );
+	BOOST_CHECK( queue.empty() );
+
+	for(int i = 0; i < 8; ++i)
+		BOOST_CHECK( queue.push(i) );
+	BOOST_CHECK( !queue.push(8) );
+
+	int v;
+	for(int i = 0; i < 8; ++i)
+	{
+		BOOST_REQUIRE( queue.pop(v) );
+		BOOST_CHECK_EQUAL( v, i );
+	}
+	BOOST_CHECK( !queue.pop(v) );
+	BOOST_CHECK( queue.empty() );
+}
+
+BOOST_AUTO_TEST_CASE( releases_elements )
+{
+	MPSCRingQueue<test_packet> queue(4);
+	auto packet = boost::make_shared<int>(5);
+	queue.push(packet);
+	BOOST_CHECK_EQUAL( packet.use_count(), 2 );
+
+	test_packet out;
+	queue.pop(out);
+	out.reset();
+	BOOST_CHECK_EQUAL( packet.use_count(), 1 );
+}
+
+// every packet arrives exactly once, and packets of one producer keep their order
+BOOST_AUTO_TEST_CASE( multiple_producers )
+{
+	const int producers = 4;
+	const int count = 100000;
+	MPSCRingQueue<int> queue(64);
+
+	std::vector<std::thread> threads;
+	for(int t = 0; t < producers; ++t)
+	{
+		threads.push_back(std::thread([&queue, t, count]()
+			{
+				for(int i = 0; i < count; ++i)
+					while(!queue.push(t * count + i))
+						std::this_thread::yield();
+			}));
+	}
+
+	std::vector<int> last(producers, -1);
+	int received = 0;
+	bool ordered = true;
+	while(received < producers * count)
+	{
+		int v;
+		if(!queue.pop(v))
+			continue;
+		int producer = v / count;
+		ordered = ordered && (v % count == last[producer] + 1);
+		last[producer] = v % count;
+		++received;
+	}
+
+	for(auto& t : threads)
+		t.join();
+
+	BOOST_CHECK( ordered );
+	BOOST_CHECK( queue.empty() );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE( overflow_queue )
+
+// a full queue keeps the packets, in order, instead of dropping them
+BOOST_AUTO_TEST_CASE( full_queue )
+{
+	OverflowQueue<int> queue(4);
+	for(int i = 0; i < 4; ++i)
+		BOOST_CHECK( queue.push(i) );
+	BOOST_CHECK( !queue.push(4) );
+	BOOST_CHECK( !queue.push(5) );
+
+	// while there are packets in the overflow list, new ones go there too
+	int v;
+	BOOST_REQUIRE( queue.pop(v) );
+	BOOST_CHECK_EQUAL( v, 0 );
+	BOOST_CHECK( !queue.push(6) );
+
+	for(int i = 1; i < 7; ++i)
+	{
+		BOOST_REQUIRE( queue.pop(v) );
+		BOOST_CHECK_EQUAL( v, i );
+	}
+	BOOST_CHECK( !queue.pop(v) );
+	BOOST_CHECK( queue.empty() );
+
+	// afterwards, the ring is used again
+	BOOST_CHECK( queue.push(7) );
+	BOOST_REQUIRE( queue.pop(v) );
+	BOOST_CHECK_EQUAL( v, 7 );
+}
+
+// no packet is lost, even if the producers are much faster than the consumer
+BOOST_AUTO_TEST_CASE( multiple_producers )
+{
+	const int producers = 4;
+	const int count = 100000;
+	OverflowQueue<int> queue(16);
+
+	std::vector<std::thread> threads;
+	for(int t = 0; t < producers; ++t)
+	{
+		threads.push_back(std::thread([&queue, t, count]()
+			{
+				for(int i = 0; i < count; ++i)
+					queue.push(t * count + i);
+			}));
+	}
+
+	std::vector<int> last(producers, -1);
+	int received = 0;
+	bool ordered = true;
+	while(received < producers * count)
+	{
+		int v;
+		if(!queue.pop(v))
+			continue;
+		int producer = v / count;
+		ordered = ordered && (v % count == last[producer] + 1);
+		last[producer] = v % count;
+		++received;
+	}
+
+	for(auto& t : threads)
+		t.join();
+
+	BOOST_CHECK( ordered );
+	BOOST_CHECK( queue.empty() );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE( packet_queue_benchmark )
+
+// compares throughput and p99 enqueue latency with the old mutex + list design
+BOOST_AUTO_TEST_CASE( benchmark )
+{
+	for(int producers : {1, 2, 4})
+	{
+		BenchResult ring = runBenchmark<MPSCRingQueue<test_packet>>(producers);
+		BenchResult list = runBenchmark<MutexListQueue>(producers);
+
+		BOOST_TEST_MESSAGE( producers << " producers: ring queue " << ring.throughput / 1e6 << " M packets/s, p99 " << ring.p99 << "ns; "
+				  << "mutex + list " << list.throughput / 1e6 << " M packets/s, p99 " << list.p99 << "ns" );
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,161 @@
+#define BOOST_TEST_MODULE PhysicDeterminism
+#include <boost/test/unit_test.hpp>
+#include <boost/make_shared.hpp>
+
+#include "DuelMatch.h"
+#include "DuelMatchState.h"
+#include "FileSystem.h"
+#include "InputSource.h"
+
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#define TEST_DATA_PATH "../data"
+
+// These tests replay synthetic input sequences and hash the complete DuelMatchState after every tick.
+// The reference hashes below were computed by an x86_64 SSE build. Every other build
+// (other compilers, optimisation levels, instruction sets, 32 bit x86 with -mfpmath=sse)
+// has to reproduce them bit for bit, otherwise network games and replays between
+// these builds go out of sync. See FloatDeterminism.h.
+
+void initFileSystem()
+{
+	static FileSystem fs( TEST_DATA_PATH );
+	static bool initialised = false;
+	if(!initialised)
+	{
+		fs.addToSearchPath(TEST_DATA_PATH);
+		initialised = true;
+	}
+}
+
+struct RecordedTick
+{
+	PlayerInput input[MAX_PLAYERS];
+};
+
+typedef std::vector<RecordedTick> Recording;
+
+// generates the inputs of two players who hold random keys for random times. Only integer
+// arithmetic is used, so the recording itself is the same for every build.
+Recording generateMatch(std::uint32_t seed, int ticks)
+{
+	std::uint32_t state = seed;
+	auto next = [&state]()
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	};
+
+	Recording recording(ticks);
+	int hold[MAX_PLAYERS] = {0, 0};
+	PlayerInput current[MAX_PLAYERS];
+	for(RecordedTick& tick : recording)
+	{
+		for(int side = LEFT_PLAYER; side < MAX_PLAYERS; ++side)
+		{
+			if(hold[side]-- <= 0)
+			{
+				std::uint32_t keys = next();
+				current[side] = PlayerInput((keys & 3) == 1, (keys & 3) == 2, (keys & 12) == 0);
+				hold[side] = next() % 40;
+			}
+			tick.input[side] = current[side];
+		}
+	}
+	return recording;
+}
+
+// replays a recording and returns the state hash after every tick
+std::vector<std::uint64_t> replay(const Recording& recording)
+{
+	initFileSystem();
+	DuelMatch match(false, FALLBACK_RULES_NAME, 15);
+	match.setInputSources(boost::make_shared<InputSource>(), boost::make_shared<InputSource>());
+
+	std::vector<std::uint64_t> hashes;
+	for(const RecordedTick& tick : recording)
+	{
+		match.getInputSource(LEFT_PLAYER)->setInput(tick.input[LEFT_PLAYER]);
+		match.getInputSource(RIGHT_PLAYER)->setInput(tick.input[RIGHT_PLAYER]);
+		match.step();
+		hashes.push_back(match.getState().hash());
+	}
+	return hashes;
+}
+
+// combines the tick hashes of every CHECKPOINT_INTERVAL ticks
+const int CHECKPOINT_INTERVAL = 1000;
+
+std::vector<std::uint64_t> checkpoints(const std::vector<std::uint64_t>& hashes)
+{
+	std::vector<std::uint64_t> result;
+	std::uint64_t combined = 0;
+	for(unsigned int i = 0; i < hashes.size(); ++i)
+	{
+		combined = (combined ^ hashes[i]) * 1099511628211ull;
+		if((i + 1) % CHECKPOINT_INTERVAL == 0)
+			result.push_back(combined);
+	}
+	return result;
+}
+
+struct ReferenceMatch
+{
+	std::uint32_t seed;
+	int ticks;
+	std::vector<std::uint64_t> checkpoints;
+};
+
+const std::vector<ReferenceMatch> REFERENCE_MATCHES = {
+	{1, 6000, {0x69339f7508b5a4f4ull, 0x2f43d56e1a24577dull, 0x37fae365722e9456ull,
+				0xecc43a70ff6c6d37ull, 0x40c48c9c9773b39full, 0x559cee5f4ddd71ddull}},
+	{2, 6000, {0x696363d7ffd0753dull, 0xea616952273a29b5ull, 0x134bc05315ba70dfull,
+				0xf49ea8642764de46ull, 0xd49a65e53e20a6e1ull, 0xfef83a885d4bd22aull}},
+	{3, 6000, {0x5aaf2d14a42291ddull, 0xc2af29fc2ec9a268ull, 0x6968a35d7d104953ull,
+				0xa4509ec4e7f5dfeaull, 0x683305d6557c4535ull, 0x43b61b7a8c8e9ebaull}},
+};
+
+BOOST_AUTO_TEST_SUITE( physic_determinism )
+
+BOOST_AUTO_TEST_CASE( replay_is_repeatable )
+{
+	Recording recording = generateMatch(1, 6000);
+	std::vector<std::uint64_t> first = replay(recording);
+	std::vector<std::uint64_t> second = replay(recording);
+	BOOST_REQUIRE_EQUAL( first.size(), second.size() );
+	for(unsigned int i = 0; i < first.size(); ++i)
+		BOOST_REQUIRE_MESSAGE( first[i] == second[i], "replays differ at tick " << i );
+}
+
+BOOST_AUTO_TEST_CASE( matches_reference_hashes )
+{
+	for(const ReferenceMatch& reference : REFERENCE_MATCHES)
+	{
+		Recording recording = generateMatch(reference.seed, reference.ticks);
+		std::vector<std::uint64_t> hashes = replay(recording);
+		std::vector<std::uint64_t> result = checkpoints(hashes);
+
+		// list the checkpoints, so the reference can be updated if the physics is changed on purpose
+		std::ostringstream list;
+		list << "match " << reference.seed << ":" << std::hex << std::setfill('0');
+		for(std::uint64_t checkpoint : result)
+			list << " 0x" << std::setw(16) << checkpoint << "ull,";
+		BOOST_TEST_MESSAGE( list.str() );
+
+		BOOST_CHECK_EQUAL( result.size(), reference.checkpoints.size() );
+		if(result.size() != reference.checkpoints.size())
+			continue;
+		for(unsigned int i = 0; i < result.size(); ++i)
+		{
+			BOOST_CHECK_MESSAGE( result[i] == reference.checkpoints[i], "match " << reference.seed
+					<< " diverges between tick " << i * CHECKPOINT_INTERVAL << " and " << (i + 1) * CHECKPOINT_INTERVAL );
+		}
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,165 @@
+#define BOOST_TEST_MODULE PhysicWorldBatch
+#include <boost/test/unit_test.hpp>
+
+#include "PhysicWorld.h"
+#include "PhysicWorldBatch.h"
+#include "GameConstants.h"
+
+#include <cstring>
+#include <memory>
+#include <random>
+
+namespace
+{
+	bool sameBits(float a, float b)
+	{
+		return std::memcmp(&a, &b, sizeof(float)) == 0;
+	}
+
+	bool sameBits(const Vector2& a, const Vector2& b)
+	{
+		return sameBits(a.x, b.x) && sameBits(a.y, b.y);
+	}
+
+	bool sameState(const PhysicState& a, const PhysicState& b)
+	{
+		for(int player = LEFT_PLAYER; player < MAX_PLAYERS; ++player)
+		{
+			if(!sameBits(a.blobPosition[player], b.blobPosition[player]) ||
+					!sameBits(a.blobVelocity[player], b.blobVelocity[player]) ||
+					!sameBits(a.blobState[player], b.blobState[player]))
+				return false;
+		}
+		return sameBits(a.ballPosition, b.ballPosition) && sameBits(a.ballVelocity, b.ballVelocity) &&
+				sameBits(a.ballRotation, b.ballRotation) && sameBits(a.ballAngularVelocity, b.ballAngularVelocity);
+	}
+
+	bool sameEvent(const MatchEvent& a, const MatchEvent& b)
+	{
+		return a.event == b.event && a.side == b.side && sameBits(a.intensity, b.intensity);
+	}
+
+	// blobs which jump around randomly, and a ball that is thrown anywhere from time to time
+	struct RandomGame
+	{
+		explicit RandomGame(unsigned int seed) : random(seed)
+		{
+		}
+
+		PlayerInput input()
+		{
+			std::uniform_int_distribution<int> key(0, 3);
+			return PlayerInput(key(random) == 0, key(random) == 0, key(random) != 0);
+		}
+
+		bool throwBall()
+		{
+			return std::uniform_int_distribution<int>(0, 150)(random) == 0;
+		}
+
+		Vector2 position()
+		{
+			return Vector2(std::uniform_real_distribution<float>(LEFT_PLANE, RIGHT_PLANE)(random),
+							std::uniform_real_distribution<float>(0, GROUND_PLANE_HEIGHT_MAX)(random));
+		}
+
+		Vector2 velocity()
+		{
+			std::uniform_real_distribution<float> v(-BALL_COLLISION_VELOCITY, BALL_COLLISION_VELOCITY);
+			return Vector2(v(random), v(random));
+		}
+
+		std::mt19937 random;
+	};
+}
+
+BOOST_AUTO_TEST_SUITE( physic_world_batch )
+
+// every world of the batch computes exactly what a PhysicWorld computes
+BOOST_AUTO_TEST_CASE( bit_identical )
+{
+	const int WORLDS = 67;
+	const int STEPS = 3000;
+
+	PhysicWorldBatch batch;
+	std::vector<std::unique_ptr<PhysicWorld>> worlds;
+	std::vector<std::vector<MatchEvent>> events(WORLDS);
+	std::vector<RandomGame> games;
+	for(int i = 0; i < WORLDS; ++i)
+	{
+		BOOST_CHECK_EQUAL( batch.addWorld(), (unsigned int)i );
+		worlds.emplace_back(new PhysicWorld);
+		worlds.back()->setEventCallback([&events, i](const MatchEvent& event) { events[i].push_back(event); });
+		games.emplace_back(i);
+	}
+
+	int mismatches = 0;
+	int eventCount = 0;
+	for(int step = 0; step < STEPS; ++step)
+	{
+		for(int i = 0; i < WORLDS; ++i)
+		{
+			RandomGame& game = games[i];
+			if(game.throwBall())
+			{
+				PhysicState state = worlds[i]->getState();
+				state.ballPosition = game.position();
+				state.ballVelocity = game.velocity();
+				worlds[i]->setState(state);
+				batch.setState(i, state);
+			}
+
+			PlayerInput left = game.input();
+			PlayerInput right = game.input();
+			bool valid = game.random() % 8 != 0;
+			bool running = game.random() % 16 != 0;
+			worlds[i]->step(left, right, valid, running);
+			batch.setInput(i, left, right, valid, running);
+		}
+		batch.step();
+
+		std::vector<std::vector<MatchEvent>> batchEvents(WORLDS);
+		unsigned int last = 0;
+		for(const auto& event : batch.getEvents())
+		{
+			BOOST_CHECK_GE( event.world, last );
+			last = event.world;
+			batchEvents[event.world].push_back(event.event);
+		}
+
+		for(int i = 0; i < WORLDS; ++i)
+		{
+			if(!sameState(worlds[i]->getState(), batch.getState(i)))
+				++mismatches;
+
+			BOOST_REQUIRE_EQUAL( batchEvents[i].size(), events[i].size() );
+			for(std::size_t e = 0; e < events[i].size(); ++e)
+				BOOST_CHECK( sameEvent(batchEvents[i][e], events[i][e]) );
+			eventCount += events[i].size();
+			events[i].clear();
+		}
+	}
+
+	BOOST_CHECK_EQUAL( mismatches, 0 );
+	// make sure all kinds of collisions happened
+	BOOST_CHECK_GT( eventCount, STEPS );
+}
+
+BOOST_AUTO_TEST_CASE( reuse_slots )
+{
+	PhysicWorldBatch batch;
+	unsigned int a = batch.addWorld();
+	unsigned int b = batch.addWorld();
+	batch.setInput(a, PlayerInput(false, true, true), PlayerInput(), true, true);
+	batch.step();
+	batch.removeWorld(a);
+	BOOST_CHECK_EQUAL( batch.getWorldCount(), 1u );
+
+	// a reused slot starts like a new world
+	BOOST_CHECK_EQUAL( batch.addWorld(), a );
+	BOOST_CHECK( sameState(batch.getState(a), PhysicWorld().getState()) );
+	BOOST_CHECK_EQUAL( batch.size(), 2u );
+	(void)b;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,293 @@
+#define BOOST_TEST_MODULE PredictionBuffer
+#include <boost/test/unit_test.hpp>
+#include <boost/make_shared.hpp>
+
+#include <deque>
+#include <utility>
+
+#include "PredictionBuffer.h"
+#include "DuelMatch.h"
+#include "FileSystem.h"
+#include "InputSource.h"
+#include "server/InputJitterBuffer.h"
+
+#define TEST_DATA_PATH "../data"
+
+void initFileSystem()
+{
+	static FileSystem fs( TEST_DATA_PATH );
+	static bool initialised = false;
+	if(!initialised)
+	{
+		fs.addToSearchPath(TEST_DATA_PATH);
+		initialised = true;
+	}
+}
+
+// walks right for a while, then left, and jumps now and then
+PlayerInputAbs inputFor(unsigned int tick)
+{
+	return PlayerInputAbs(tick % 60 >= 30, tick % 60 < 30, tick % 45 < 10);
+}
+
+struct FileSystemFixture
+{
+	FileSystemFixture()
+	{
+		initFileSystem();
+	}
+};
+
+struct MatchFixture : FileSystemFixture
+{
+	MatchFixture() : match( false, FALLBACK_RULES_NAME, 15 )
+	{
+		match.setInputSources(boost::make_shared<InputSource>(), boost::make_shared<InputSource>());
+	}
+
+	void step(PlayerSide side, const PlayerInputAbs& input)
+	{
+		match.getInputSource(side)->setInput(input);
+		match.step();
+	}
+
+	DuelMatch match;
+};
+
+BOOST_AUTO_TEST_SUITE( prediction_buffer )
+
+BOOST_AUTO_TEST_CASE( store_and_find )
+{
+	PredictionBuffer buffer;
+	DuelMatchState state;
+	BOOST_CHECK( !buffer.findInput(1) );
+	BOOST_CHECK( !buffer.findState(1) );
+
+	for(unsigned int tick = 1; tick <= 200; ++tick)
+	{
+		state.worldState.ballPosition.x = tick;
+		buffer.store(tick, inputFor(tick), state);
+	}
+
+	// older ticks have been overwritten
+	BOOST_CHECK( !buffer.findInput(200 - PredictionBuffer::SIZE) );
+	BOOST_CHECK( !buffer.findState(200 - PredictionBuffer::SIZE) );
+	for(unsigned int tick = 201 - PredictionBuffer::SIZE; tick <= 200; ++tick)
+	{
+		BOOST_REQUIRE( buffer.findInput(tick) );
+		BOOST_REQUIRE( buffer.findState(tick) );
+		BOOST_CHECK( buffer.findInput(tick)->toPlayerInput(0) == inputFor(tick).toPlayerInput(0) );
+		BOOST_CHECK_EQUAL( buffer.findState(tick)->worldState.ballPosition.x, tick );
+	}
+	BOOST_CHECK( !buffer.findState(201) );
+
+	buffer.clear();
+	BOOST_CHECK( !buffer.findInput(200) );
+	BOOST_CHECK( !buffer.findState(200) );
+}
+
+BOOST_AUTO_TEST_CASE( matches_within_quantization )
+{
+	MatchFixture fixture;
+	DuelMatchState state = fixture.match.getState();
+	DuelMatchState other = state;
+	BOOST_CHECK( predictionMatches(state, other) );
+
+	other.worldState.ballPosition.x += 1.f / 64;
+	BOOST_CHECK( predictionMatches(state, other) );
+
+	other.worldState.ballPosition.x += 1.f;
+	BOOST_CHECK( !predictionMatches(state, other) );
+
+	other = state;
+	other.playerInput[LEFT_PLAYER] = PlayerInput(true, false, false);
+	BOOST_CHECK( !predictionMatches(state, other) );
+
+	other = state;
+	other.logicState.leftScore += 1;
+	BOOST_CHECK( !predictionMatches(state, other) );
+}
+
+BOOST_AUTO_TEST_CASE( correct_prediction_is_kept )
+{
+	MatchFixture client;
+	PredictionBuffer buffer;
+	for(unsigned int tick = 1; tick < 10; ++tick)
+	{
+		client.step(LEFT_PLAYER, inputFor(tick));
+		buffer.store(tick, inputFor(tick), client.match.getState());
+	}
+
+	DuelMatchState serverState = *buffer.findState(5);
+	DuelMatchState before = client.match.getState();
+	BOOST_CHECK( !buffer.reconcile(client.match, LEFT_PLAYER, 5, serverState, 10) );
+	BOOST_CHECK( predictionMatches(client.match.getState(), before) );
+}
+
+// a wrong prediction is replaced by the server state, and the inputs the server has
+// not seen yet are simulated again on top of it
+BOOST_AUTO_TEST_CASE( wrong_prediction_is_replayed )
+{
+	MatchFixture client;
+	PredictionBuffer buffer;
+	for(unsigned int tick = 1; tick < 20; ++tick)
+	{
+		client.step(LEFT_PLAYER, inputFor(tick));
+		buffer.store(tick, inputFor(tick), client.match.getState());
+	}
+
+	// the server says the blob was somewhere else after tick 10
+	DuelMatchState serverState = *buffer.findState(10);
+	serverState.worldState.blobPosition[LEFT_PLAYER].x += 50;
+	BOOST_CHECK( buffer.reconcile(client.match, LEFT_PLAYER, 10, serverState, 20) );
+
+	MatchFixture reference;
+	reference.match.setState(serverState);
+	for(unsigned int tick = 11; tick < 20; ++tick)
+	{
+		reference.step(LEFT_PLAYER, inputFor(tick));
+		BOOST_REQUIRE( buffer.findState(tick) );
+		BOOST_CHECK( predictionMatches(*buffer.findState(tick), reference.match.getState()) );
+	}
+	BOOST_CHECK( predictionMatches(client.match.getState(), reference.match.getState()) );
+
+	// nothing to replay: the match is just rewound
+	serverState.worldState.blobPosition[LEFT_PLAYER].x -= 20;
+	BOOST_CHECK( buffer.reconcile(client.match, LEFT_PLAYER, 19, serverState, 20) );
+	BOOST_CHECK( predictionMatches(client.match.getState(), serverState) );
+}
+
+// the input tick the server echoes in its snapshots is the tick of the input it simulated
+// last, so it has to be compared with the state the client predicted after that same tick.
+// If server and client use the same inputs, the prediction is never corrected, except
+// once at the start, when the server simulates steps before the first input arrives.
+BOOST_AUTO_TEST_CASE( echoed_tick_alignment )
+{
+	const int LATENCY = 3;	// frames in each direction
+
+	MatchFixture server;
+	InputJitterBuffer jitter;
+	MatchFixture client;
+	PredictionBuffer buffer;
+
+	std::deque<std::pair<unsigned int, PlayerInputAbs>> inputs;
+	std::deque<std::pair<unsigned int, DuelMatchState>> snapshots;
+	int corrections = 0;
+	int lastCorrection = 0;
+
+	for(unsigned int tick = 1; tick <= 500; ++tick)
+	{
+		// client: apply the snapshot that arrived, then predict the next tick
+		if(snapshots.size() > LATENCY)
+		{
+			auto snapshot = snapshots.front();
+			snapshots.pop_front();
+			if(snapshot.first != 0 && buffer.reconcile(client.match, LEFT_PLAYER, snapshot.first, snapshot.second, tick))
+			{
+				++corrections;
+				lastCorrection = tick;
+			}
+		}
+		client.step(LEFT_PLAYER, inputFor(tick));
+		buffer.store(tick, inputFor(tick), client.match.getState());
+		inputs.push_back(std::make_pair(tick, inputFor(tick)));
+
+		// server: consume one input per step and echo its tick with the state after the step
+		if(inputs.size() > LATENCY)
+		{
+			jitter.push(inputs.front().first, inputs.front().second);
+			inputs.pop_front();
+		}
+		PlayerInputAbs input;
+		if(jitter.pop(input))
+			server.match.getInputSource(LEFT_PLAYER)->setInput(input);
+		server.match.step();
+		snapshots.push_back(std::make_pair(jitter.getTick(), server.match.getState()));
+	}
+
+	BOOST_CHECK_LE( corrections, 1 );
+	BOOST_CHECK_LT( lastCorrection, 50 );
+	BOOST_CHECK_GT( jitter.getTick(), 450 );
+}
+
+// the server only sends its state hash if every step since the previous snapshot used the
+// next input of the client. Otherwise, e.g. while the server waits for inputs that are
+// stuck in the network, the echoed tick belongs to an older step than the hash.
+BOOST_AUTO_TEST_CASE( stalled_input_hash )
+{
+	const int LATENCY = 3;	// frames in each direction
+
+	MatchFixture server;
+	InputJitterBuffer jitter;
+	MatchFixture client;
+	PredictionBuffer buffer;
+
+	struct Snapshot
+	{
+		unsigned int tick;
+		DuelMatchState state;
+		bool hasHash;
+		std::uint64_t hash;
+	};
+
+	std::deque<std::pair<unsigned int, PlayerInputAbs>> inputs;
+	std::deque<Snapshot> snapshots;
+	int checked = 0;
+	int mismatches = 0;
+	int stalledMismatches = 0;
+
+	for(unsigned int tick = 1; tick <= 500; ++tick)
+	{
+		if(snapshots.size() > LATENCY)
+		{
+			Snapshot snapshot = snapshots.front();
+			snapshots.pop_front();
+			if(snapshot.tick != 0)
+			{
+				bool matches = buffer.checkHash(snapshot.tick, snapshot.state, snapshot.hash);
+				if(snapshot.hasHash)
+				{
+					++checked;
+					if(!matches)
+						++mismatches;
+				}
+				else if(!matches)
+				{
+					++stalledMismatches;
+				}
+				buffer.reconcile(client.match, LEFT_PLAYER, snapshot.tick, snapshot.state, tick, true);
+			}
+		}
+		client.step(LEFT_PLAYER, inputFor(tick));
+		buffer.store(tick, inputFor(tick), client.match.getState());
+		inputs.push_back(std::make_pair(tick, inputFor(tick)));
+
+		// the inputs of ticks 200 to 220 are stuck and arrive all at once
+		while(inputs.size() > LATENCY && !(tick >= 200 && tick < 220 && inputs.front().first >= 200))
+		{
+			jitter.push(inputs.front().first, inputs.front().second);
+			inputs.pop_front();
+		}
+
+		PlayerInputAbs input;
+		if(jitter.pop(input))
+			server.match.getInputSource(LEFT_PLAYER)->setInput(input);
+		server.match.step();
+
+		// a snapshot is sent every step, so only the last step has to be in sequence
+		Snapshot snapshot;
+		snapshot.tick = jitter.getTick();
+		snapshot.state = server.match.getState();
+		snapshot.hasHash = jitter.isInSequence();
+		snapshot.hash = snapshot.state.hash();
+		snapshots.push_back(snapshot);
+	}
+
+	BOOST_CHECK_EQUAL( mismatches, 0 );
+	BOOST_CHECK_GT( checked, 400 );
+	// the hash of the snapshots sent while waiting would not have matched
+	BOOST_CHECK_GT( stalledMismatches, 0 );
+	BOOST_CHECK_GT( jitter.getStatistics().underruns, 0 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
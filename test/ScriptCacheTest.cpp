@@ -0,0 +1,75 @@
+#define BOOST_TEST_MODULE ScriptCache
+#include <boost/test/unit_test.hpp>
+
+#include "ScriptCache.h"
+#include "FileSystem.h"
+#include "FileWrite.h"
+
+extern "C"
+{
+#include "lua/lua.h"
+#include "lua/lauxlib.h"
+}
+
+BOOST_AUTO_TEST_SUITE( script_cache )
+
+// a compiled script can be run in several independent lua states
+BOOST_AUTO_TEST_CASE( run_precompiled )
+{
+	auto script = ScriptCache::compile("test.lua", "VALUE = 21\nfunction double(x) return 2 * x end");
+	BOOST_REQUIRE( !script->bytecode.empty() );
+	BOOST_CHECK( script->error.empty() );
+
+	for(int i = 0; i < 2; ++i)
+	{
+		lua_State* state = luaL_newstate();
+		BOOST_REQUIRE_EQUAL( ScriptCache::load(state, *script), LUA_OK );
+		BOOST_REQUIRE_EQUAL( lua_pcall(state, 0, 0, 0), LUA_OK );
+
+		lua_getglobal(state, "double");
+		lua_getglobal(state, "VALUE");
+		BOOST_REQUIRE_EQUAL( lua_pcall(state, 1, 1, 0), LUA_OK );
+		BOOST_CHECK_EQUAL( lua_tonumber(state, -1), 42 );
+		lua_close(state);
+	}
+}
+
+// a script with syntax errors reports the error every time it is loaded
+BOOST_AUTO_TEST_CASE( syntax_error )
+{
+	auto script = ScriptCache::compile("broken.lua", "function broken(");
+	BOOST_CHECK( script->bytecode.empty() );
+	BOOST_CHECK( script->error.find("broken.lua") != std::string::npos );
+
+	lua_State* state = luaL_newstate();
+	BOOST_CHECK_EQUAL( ScriptCache::load(state, *script), LUA_ERRSYNTAX );
+	BOOST_CHECK_EQUAL( std::string(lua_tostring(state, -1)), script->error );
+	lua_close(state);
+}
+
+// a cached script is returned until the file is invalidated, even if the file has changed
+BOOST_AUTO_TEST_CASE( rewritten_file )
+{
+	static FileSystem fs( "." );
+	fs.setWriteDir(".");
+	fs.addToSearchPath(".");
+
+	for(int value = 1; value <= 3; ++value)
+	{
+		FileWrite file("script_cache_test.lua");
+		file.write("VALUE = " + std::to_string(value));
+		file.close();
+
+		// the new content has the same size, but the cache does not look at the file at all
+		if(value > 1)
+			BOOST_CHECK_EQUAL( ScriptCache::get("script_cache_test")->source, "VALUE = " + std::to_string(value - 1) );
+
+		ScriptCache::invalidate("script_cache_test");
+		auto script = ScriptCache::get("script_cache_test");
+		BOOST_CHECK_EQUAL( script->source, "VALUE = " + std::to_string(value) );
+		BOOST_CHECK( script == ScriptCache::get("script_cache_test.lua") );
+	}
+	fs.deleteFile("script_cache_test.lua");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
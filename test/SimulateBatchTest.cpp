@@ -0,0 +1,83 @@
+#define BOOST_TEST_MODULE SimulateBatch
+#include <boost/test/unit_test.hpp>
+
+#include "IScriptableComponent.h"
+
+extern "C"
+{
+#include "lua/lua.h"
+#include "lua/lauxlib.h"
+}
+
+#include <string>
+
+namespace
+{
+	// gives access to a lua state with the game functions
+	struct ScriptComponent : public IScriptableComponent
+	{
+		lua_State* state() { return mState; }
+
+		void run(const std::string& code)
+		{
+			BOOST_REQUIRE_MESSAGE( luaL_dostring(mState, code.c_str()) == 0, lua_tostring(mState, -1) );
+		}
+
+		bool check(const std::string& expression)
+		{
+			run("__RESULT = " + expression);
+			lua_getglobal(mState, "__RESULT");
+			bool result = lua_toboolean(mState, -1);
+			lua_pop(mState, 1);
+			return result;
+		}
+	};
+}
+
+BOOST_AUTO_TEST_SUITE( simulate_batch )
+
+// every candidate gets exactly the result of a single simulate call
+BOOST_AUTO_TEST_CASE( same_as_simulate )
+{
+	ScriptComponent component;
+	component.run(
+		"steps, xs, ys, vxs, vys = {}, {}, {}, {}, {}\n"
+		"for i = 1, 200 do\n"
+		"	steps[i] = (i * 7) % 150\n"
+		"	xs[i] = 50 + (i * 37) % 700\n"
+		"	ys[i] = 150 + (i * 13) % 400\n"
+		"	vxs[i] = (i % 21) - 10\n"
+		"	vys[i] = (i % 15) - 7\n"
+		"end\n"
+		"rx, ry, rvx, rvy = simulate_batch(steps, xs, ys, vxs, vys)\n"
+		"equal = #rx == 200\n"
+		"for i = 1, 200 do\n"
+		"	local x, y, vx, vy = simulate(steps[i], xs[i], ys[i], vxs[i], vys[i])\n"
+		"	equal = equal and x == rx[i] and y == ry[i] and vx == rvx[i] and vy == rvy[i]\n"
+		"end\n");
+	BOOST_CHECK( component.check("equal") );
+}
+
+// numbers are used for all candidates, so a whole trajectory can be computed at once
+BOOST_AUTO_TEST_CASE( trajectory )
+{
+	ScriptComponent component;
+	component.run(
+		"steps = {}\n"
+		"for i = 1, 100 do steps[i] = i end\n"
+		"rx, ry, rvx, rvy = simulate_batch(steps, 300, 400, 6, 10)\n"
+		"equal = #ry == 100\n"
+		"for i = 1, 100 do\n"
+		"	local x, y, vx, vy = simulate(i, 300, 400, 6, 10)\n"
+		"	equal = equal and x == rx[i] and y == ry[i] and vx == rvx[i] and vy == rvy[i]\n"
+		"end\n");
+	BOOST_CHECK( component.check("equal") );
+}
+
+BOOST_AUTO_TEST_CASE( different_lengths )
+{
+	ScriptComponent component;
+	BOOST_CHECK( luaL_dostring(component.state(), "simulate_batch({1, 2}, {1, 2, 3}, 0, 0, 0)") != 0 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
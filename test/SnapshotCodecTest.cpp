@@ -0,0 +1,427 @@
+#define BOOST_TEST_MODULE SnapshotCodec
+#include <boost/test/unit_test.hpp>
+
+#include "SnapshotCodec.h"
+#include "DuelMatch.h"
+#include "DuelMatchState.h"
+#include "FileSystem.h"
+#include "GameLogic.h"
+#include "GenericIO.h"
+#include "HeadlessMatch.h"
+#include "ScriptedInputSource.h"
+#include "raknet/BitStream.h"
+
+#include <boost/make_shared.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#define TEST_DATA_PATH "../data"
+
+// acknowledgements arrive one round trip after the snapshot was sent: 5 steps are about 65ms
+const unsigned int ACK_LAG = 5;
+// a keyframe is sent at least every KEYFRAME_INTERVAL snapshots, as in NetworkGame
+const unsigned int KEYFRAME_INTERVAL = 150;
+// size of packet id and timestamp, which both message types have
+const int HEADER_BITS = 8 + 32;
+// sequence number, keyframe flag, encoding flag, input tick, server step and hash flag
+// of a delta snapshot. The offset of the base adds another 8 bits to a delta.
+const int DELTA_HEADER_BITS = 32 + 1 + 1 + 32 + 32 + 1;
+
+// helper
+void initFileSystem()
+{
+	static FileSystem fs( TEST_DATA_PATH );
+	static bool initialised = false;
+	if(!initialised)
+	{
+		fs.addToSearchPath(TEST_DATA_PATH);
+		initialised = true;
+	}
+}
+
+DuelMatchState createState(float offset)
+{
+	DuelMatchState state;
+	state.worldState.blobPosition[LEFT_PLAYER] = Vector2(200 + offset, 400);
+	state.worldState.blobPosition[RIGHT_PLAYER] = Vector2(600, 400 - offset);
+	state.worldState.blobVelocity[LEFT_PLAYER] = Vector2(4.5, -offset);
+	state.worldState.blobVelocity[RIGHT_PLAYER] = Vector2(0, 0);
+	state.worldState.blobState[LEFT_PLAYER] = 2;
+	state.worldState.blobState[RIGHT_PLAYER] = 0;
+	state.worldState.ballPosition = Vector2(200 + 2 * offset, 250);
+	state.worldState.ballVelocity = Vector2(3.25, 1 + offset);
+	state.worldState.ballRotation = 1.5;
+	state.worldState.ballAngularVelocity = 0.1;
+
+	state.logicState.leftScore = 7;
+	state.logicState.rightScore = 12;
+	state.logicState.hitCount[LEFT_PLAYER] = 2;
+	state.logicState.hitCount[RIGHT_PLAYER] = 0;
+	state.logicState.servingPlayer = LEFT_PLAYER;
+	state.logicState.winningPlayer = NO_PLAYER;
+	state.logicState.squish[LEFT_PLAYER] = 0;
+	state.logicState.squish[RIGHT_PLAYER] = 3;
+	state.logicState.squishWall = 0;
+	state.logicState.squishGround = 0;
+	state.logicState.isGameRunning = true;
+	state.logicState.isBallValid = true;
+
+	state.playerInput[LEFT_PLAYER] = PlayerInput(true, false, true);
+	state.playerInput[RIGHT_PLAYER] = PlayerInput(false, false, false);
+	return state;
+}
+
+// two states are equal if their keyframes are bitwise identical
+bool sameState(const DuelMatchState& a, const DuelMatchState& b)
+{
+	SnapshotCodec codec;
+	RakNet::BitStream sa, sb;
+	codec.encode(sa, a, 0);
+	codec.encode(sb, b, 0);
+	return sa.GetNumberOfBitsUsed() == sb.GetNumberOfBitsUsed() &&
+			std::memcmp(sa.GetData(), sb.GetData(), sa.GetNumberOfBytesUsed()) == 0;
+}
+
+BOOST_AUTO_TEST_SUITE( snapshot_codec )
+
+BOOST_AUTO_TEST_CASE( keyframe )
+{
+	SnapshotCodec codec;
+	DuelMatchState state = createState(1.f);
+
+	RakNet::BitStream stream;
+	codec.encode(stream, state, 0);
+
+	DuelMatchState decoded;
+	BOOST_REQUIRE( codec.decode(stream, decoded, 0) );
+	BOOST_CHECK( sameState(state, decoded) );
+	BOOST_CHECK_EQUAL( stream.GetNumberOfUnreadBits(), 0 );
+}
+
+BOOST_AUTO_TEST_CASE( delta )
+{
+	SnapshotCodec codec;
+	DuelMatchState base = createState(1.f);
+	DuelMatchState state = createState(2.f);
+	state.logicState.hitCount[LEFT_PLAYER] = 3;
+	state.playerInput[RIGHT_PLAYER] = PlayerInput(false, true, false);
+
+	RakNet::BitStream stream;
+	codec.encode(stream, state, &base);
+
+	DuelMatchState decoded;
+	BOOST_REQUIRE( codec.decode(stream, decoded, &base) );
+	BOOST_CHECK( sameState(state, decoded) );
+	BOOST_CHECK_EQUAL( stream.GetNumberOfUnreadBits(), 0 );
+}
+
+// an unchanged state costs one bit per group
+BOOST_AUTO_TEST_CASE( unchanged )
+{
+	SnapshotCodec codec;
+	DuelMatchState state = createState(1.f);
+
+	RakNet::BitStream stream;
+	codec.encode(stream, state, &state);
+	BOOST_CHECK_EQUAL( stream.GetNumberOfBitsUsed(), 3 );
+}
+
+BOOST_AUTO_TEST_CASE( truncated )
+{
+	SnapshotCodec codec;
+	DuelMatchState state = createState(1.f);
+
+	RakNet::BitStream stream;
+	codec.encode(stream, state, 0);
+	RakNet::BitStream truncated((char*)stream.GetData(), stream.GetNumberOfBytesUsed() / 2, false);
+
+	DuelMatchState decoded;
+	BOOST_CHECK( !codec.decode(truncated, decoded, 0) );
+}
+
+BOOST_AUTO_TEST_CASE( history )
+{
+	SnapshotHistory history;
+	BOOST_CHECK( history.find(0) == 0 );
+
+	for(unsigned int i = 0; i < SnapshotHistory::SIZE + 5; ++i)
+		history.store(i, createState(i));
+
+	BOOST_CHECK( history.find(4) == 0 );
+	BOOST_REQUIRE( history.find(5) != 0 );
+	BOOST_CHECK( sameState(*history.find(5), createState(5)) );
+	BOOST_CHECK( history.find(SnapshotHistory::SIZE + 5) == 0 );
+
+	history.clear();
+	BOOST_CHECK( history.find(10) == 0 );
+}
+
+float randomFloat(float min, float max)
+{
+	return min + (max - min) * (std::rand() / (float)RAND_MAX);
+}
+
+DuelMatchState createRandomState()
+{
+	DuelMatchState state = createState(0);
+	for(int i = 0; i < MAX_PLAYERS; ++i)
+	{
+		state.worldState.blobPosition[i] = Vector2(randomFloat(0, 800), randomFloat(-200, 600));
+		state.worldState.blobVelocity[i] = Vector2(randomFloat(-20, 20), randomFloat(-20, 20));
+		state.worldState.blobState[i] = randomFloat(0, 5);
+	}
+	state.worldState.ballPosition = Vector2(randomFloat(-100, 900), randomFloat(-1000, 600));
+	state.worldState.ballVelocity = Vector2(randomFloat(-30, 30), randomFloat(-30, 30));
+	state.worldState.ballRotation = randomFloat(0, 6.25);
+	state.worldState.ballAngularVelocity = randomFloat(-1, 1);
+	state.logicState.leftScore = std::rand() % 40;
+	state.logicState.servingPlayer = (PlayerSide)(std::rand() % 3 - 1);
+	return state;
+}
+
+void checkQuantizationError(const DuelMatchState& state, const DuelMatchState& decoded)
+{
+	const PhysicState& a = state.worldState;
+	const PhysicState& b = decoded.worldState;
+	for(int i = 0; i < MAX_PLAYERS; ++i)
+	{
+		BOOST_CHECK_LE( (a.blobPosition[i] - b.blobPosition[i]).length(), std::sqrt(2.f) / 128 );
+		BOOST_CHECK_LE( (a.blobVelocity[i] - b.blobVelocity[i]).length(), std::sqrt(2.f) / 512 );
+		BOOST_CHECK_LE( std::abs(a.blobState[i] - b.blobState[i]), 1.f / 128 );
+	}
+	BOOST_CHECK_LE( (a.ballPosition - b.ballPosition).length(), std::sqrt(2.f) / 128 );
+	BOOST_CHECK_LE( (a.ballVelocity - b.ballVelocity).length(), std::sqrt(2.f) / 512 );
+	BOOST_CHECK_LE( std::abs(a.ballRotation - b.ballRotation), 1.f / 2048 );
+	BOOST_CHECK_LE( std::abs(a.ballAngularVelocity - b.ballAngularVelocity), 1.f / 8192 );
+
+	// everything else is exact
+	DuelMatchState logic = decoded;
+	logic.worldState = state.worldState;
+	BOOST_CHECK( sameState(state, logic) );
+}
+
+BOOST_AUTO_TEST_CASE( quantized_accuracy )
+{
+	SnapshotCodec codec(SnapshotCodec::QUANTIZED_ENCODING);
+	std::srand(42);
+
+	DuelMatchState base;
+	bool hasBase = false;
+	for(int i = 0; i < 1000; ++i)
+	{
+		DuelMatchState state = createRandomState();
+
+		RakNet::BitStream keyframe;
+		codec.encode(keyframe, state, 0);
+		DuelMatchState decoded;
+		BOOST_REQUIRE( codec.decode(keyframe, decoded, 0) );
+		BOOST_CHECK_EQUAL( keyframe.GetNumberOfUnreadBits(), 0 );
+		checkQuantizationError(state, decoded);
+		// the server can calculate the hash of what the client decodes
+		BOOST_CHECK_EQUAL( codec.quantize(state).hash(), decoded.hash() );
+
+		// a decoded state is quantized to the same values again
+		RakNet::BitStream again;
+		codec.encode(again, decoded, &decoded);
+		BOOST_CHECK_EQUAL( again.GetNumberOfBitsUsed(), 3 );
+
+		if(hasBase)
+		{
+			// the client only has the decoded base, the server used the original one
+			RakNet::BitStream delta;
+			codec.encode(delta, state, &base);
+			DuelMatchState deltaDecoded;
+			BOOST_REQUIRE( codec.decode(delta, deltaDecoded, &decoded) );
+			BOOST_CHECK( sameState(deltaDecoded, decoded) );
+			BOOST_CHECK_EQUAL( codec.quantize(state).hash(), deltaDecoded.hash() );
+		}
+		base = state;
+		hasBase = true;
+	}
+}
+
+// values outside of the quantization ranges are transmitted exactly
+BOOST_AUTO_TEST_CASE( quantized_out_of_range )
+{
+	SnapshotCodec codec(SnapshotCodec::QUANTIZED_ENCODING);
+	DuelMatchState state = createState(1.f);
+	state.worldState.ballPosition.y = -5000.25f;
+	state.worldState.ballVelocity.x = 100.f;
+	state.worldState.ballRotation = std::nan("");
+	state.logicState.rightScore = 1000;
+
+	RakNet::BitStream stream;
+	codec.encode(stream, state, 0);
+	DuelMatchState decoded;
+	BOOST_REQUIRE( codec.decode(stream, decoded, 0) );
+	BOOST_CHECK_EQUAL( decoded.worldState.ballPosition.y, -5000.25f );
+	BOOST_CHECK_EQUAL( decoded.worldState.ballVelocity.x, 100.f );
+	BOOST_CHECK( std::isnan(decoded.worldState.ballRotation) );
+	BOOST_CHECK_EQUAL( decoded.logicState.rightScore, 1000u );
+}
+
+BOOST_AUTO_TEST_CASE( quantized_size )
+{
+	SnapshotCodec exact;
+	SnapshotCodec quantized(SnapshotCodec::QUANTIZED_ENCODING);
+	DuelMatchState state = createState(1.f);
+
+	RakNet::BitStream exactStream, quantizedStream;
+	exact.encode(exactStream, state, 0);
+	quantized.encode(quantizedStream, state, 0);
+	BOOST_TEST_MESSAGE( "keyframe: exact " << exactStream.GetNumberOfBitsUsed() << " bits, quantized "
+						<< quantizedStream.GetNumberOfBitsUsed() << " bits" );
+	BOOST_CHECK_LT( quantizedStream.GetNumberOfBitsUsed(), exactStream.GetNumberOfBitsUsed() / 2 );
+}
+
+// every field of the state, except the blob animation, changes the hash
+BOOST_AUTO_TEST_CASE( state_hash )
+{
+	DuelMatchState state = createState(1.f);
+	BOOST_CHECK_EQUAL( state.hash(), createState(1.f).hash() );
+	BOOST_CHECK_EQUAL( SnapshotCodec().quantize(state).hash(), state.hash() );
+
+	std::vector<std::uint64_t> hashes(1, state.hash());
+	std::vector<DuelMatchState> changed;
+	for(int i = 0; i < 16; ++i)
+	{
+		if(i == 8 || i == 9)
+			continue;
+		DuelMatchState other = state;
+		float* fields = &other.worldState.blobPosition[LEFT_PLAYER].x;
+		float* field = i < 8 ? fields + i :
+						i < 12 ? &other.worldState.ballPosition.x + (i - 10) :
+						i < 14 ? &other.worldState.ballVelocity.x + (i - 12) :
+						i == 14 ? &other.worldState.ballRotation : &other.worldState.ballAngularVelocity;
+		*field = std::nextafter(*field, 1000.f);
+		changed.push_back(other);
+	}
+	unsigned int* counters[] = { &state.logicState.leftScore, &state.logicState.rightScore,
+								&state.logicState.hitCount[LEFT_PLAYER], &state.logicState.hitCount[RIGHT_PLAYER],
+								&state.logicState.squish[LEFT_PLAYER], &state.logicState.squish[RIGHT_PLAYER],
+								&state.logicState.squishWall, &state.logicState.squishGround };
+	for(unsigned int* counter : counters)
+	{
+		++*counter;
+		changed.push_back(state);
+		--*counter;
+	}
+	changed.push_back(state);
+	changed.back().logicState.servingPlayer = RIGHT_PLAYER;
+	changed.push_back(state);
+	changed.back().logicState.winningPlayer = LEFT_PLAYER;
+	changed.push_back(state);
+	changed.back().logicState.isGameRunning = false;
+	changed.push_back(state);
+	changed.back().logicState.isBallValid = false;
+	changed.push_back(state);
+	changed.back().playerInput[RIGHT_PLAYER].up = true;
+	changed.push_back(state);
+	changed.back().worldState.blobVelocity[RIGHT_PLAYER].x = -0.f;
+	changed.push_back(state);
+	changed.back().swapSides();
+
+	for(const DuelMatchState& other : changed)
+		hashes.push_back(other.hash());
+	std::sort(hashes.begin(), hashes.end());
+	BOOST_CHECK( std::adjacent_find(hashes.begin(), hashes.end()) == hashes.end() );
+
+	DuelMatchState animated = state;
+	animated.worldState.blobState[LEFT_PLAYER] += 1;
+	BOOST_CHECK_EQUAL( animated.hash(), state.hash() );
+
+	// it is calculated every tick, so it has to be cheap
+	const int COUNT = 1000000;
+	std::uint64_t sum = 0;
+	auto start = std::chrono::steady_clock::now();
+	for(int i = 0; i < COUNT; ++i)
+	{
+		state.worldState.ballPosition.x = i;
+		sum += state.hash();
+	}
+	double duration = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / COUNT;
+	BOOST_TEST_MESSAGE( "state hash: " << duration << "ns (" << sum % 10 << ")" );
+	BOOST_CHECK_LT( duration, 1000 );
+}
+
+// plays bot matches and sends every step to the client, once as the full update old
+// clients get, and once as delta snapshot with each encoding
+BOOST_AUTO_TEST_CASE( match_bandwidth )
+{
+	initFileSystem();
+
+	const float GAME_SPEED = 75;
+	std::vector<DuelMatchState> states;
+	for(int game = 0; game < 2; ++game)
+	{
+		// different seeds, so the matches are not played the same way
+		HeadlessMatch match(FALLBACK_RULES_NAME, 3, [game](PlayerSide side)
+			{
+				auto bot = boost::make_shared<ScriptedInputSource>("scripts/com_11.lua", side, 0);
+				bot->seedRandom(2 * game + side);
+				return boost::shared_ptr<InputSource>(bot);
+			}, GAME_SPEED);
+
+		while(match.step())
+			states.push_back(match.getMatch().getState());
+	}
+	BOOST_REQUIRE_GT( states.size(), 1000 );
+
+	long fullBits = 0;
+	for(const DuelMatchState& state : states)
+	{
+		RakNet::BitStream full;
+		createGenericWriter(&full)->generic<DuelMatchState>(state);
+		fullBits += HEADER_BITS + full.GetNumberOfBitsUsed();
+	}
+	double seconds = states.size() / GAME_SPEED;
+	double fullRate = fullBits / 8 / seconds;
+	BOOST_TEST_MESSAGE( states.size() << " steps, full updates " << fullRate << " bytes/s" );
+
+	SnapshotCodec::Encoding encodings[] = { SnapshotCodec::EXACT_ENCODING, SnapshotCodec::QUANTIZED_ENCODING };
+	for(SnapshotCodec::Encoding encoding : encodings)
+	{
+		SnapshotCodec codec(encoding);
+		SnapshotHistory sent;
+		SnapshotHistory received;
+		long deltaBits = 0;
+		unsigned int keyframes = 0;
+
+		for(unsigned int snapshot = 0; snapshot < states.size(); ++snapshot)
+		{
+			const DuelMatchState& state = states[snapshot];
+
+			// the client acknowledged the snapshot sent ACK_LAG steps ago
+			const DuelMatchState* base = snapshot >= ACK_LAG ? sent.find(snapshot - ACK_LAG) : 0;
+			if(snapshot % KEYFRAME_INTERVAL == 0)
+				base = 0;
+
+			RakNet::BitStream delta;
+			codec.encode(delta, state, base);
+			sent.store(snapshot, state);
+			deltaBits += HEADER_BITS + DELTA_HEADER_BITS + (base ? 8 : 0) + delta.GetNumberOfBitsUsed();
+			keyframes += base ? 0 : 1;
+
+			// check that the client reconstructs what the server expects it to
+			DuelMatchState decoded;
+			BOOST_REQUIRE( codec.decode(delta, decoded, base ? received.find(snapshot - ACK_LAG) : 0) );
+			BOOST_REQUIRE( sameState(codec.quantize(state), decoded) );
+			received.store(snapshot, decoded);
+		}
+
+		double deltaRate = deltaBits / 8 / seconds;
+		BOOST_TEST_MESSAGE( (encoding == SnapshotCodec::EXACT_ENCODING ? "exact" : "quantized")
+							<< " delta snapshots: " << keyframes << " keyframes, " << deltaRate
+							<< " bytes/s (" << 100 * deltaRate / fullRate << "%)" );
+
+		BOOST_CHECK_LT( deltaRate, fullRate );
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
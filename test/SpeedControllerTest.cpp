@@ -0,0 +1,84 @@
+#define BOOST_TEST_MODULE SpeedController
+#include <boost/test/unit_test.hpp>
+
+#include "SpeedController.h"
+
+#include <algorithm>
+#include <chrono>
+
+typedef SpeedController::clock_type test_clock;
+
+const test_clock::duration PERIOD = std::chrono::milliseconds(10);
+
+// result of runFrames
+struct FrameRun
+{
+	int lateFrames = 0;
+	test_clock::time_point lastDeadline;
+	test_clock::time_point lastEnd;
+};
+
+// runs frames with deadline timing, without waiting for real. Each frame ends at its
+// deadline, or as soon as the previous frame has ended. Frame number stallFrame takes
+// stall longer.
+FrameRun runFrames(int frames, int stallFrame, test_clock::duration stall)
+{
+	FrameRun run;
+	test_clock::time_point anchor;
+	for(int frame = 0; frame < frames; ++frame)
+	{
+		test_clock::time_point deadline = anchor + PERIOD;
+		test_clock::time_point end = std::max(deadline, run.lastEnd);
+		if(frame == stallFrame)
+			end += stall;
+		if(end > deadline)
+			++run.lateFrames;
+
+		anchor = SpeedController::advanceDeadline(deadline, end, PERIOD);
+		run.lastDeadline = deadline;
+		run.lastEnd = end;
+	}
+	return run;
+}
+
+BOOST_AUTO_TEST_SUITE( speed_controller )
+
+// frames that are on time advance the deadline by exactly one period
+BOOST_AUTO_TEST_CASE( no_drift )
+{
+	FrameRun run = runFrames(1000, -1, test_clock::duration::zero());
+	BOOST_CHECK_EQUAL( run.lateFrames, 0 );
+	BOOST_CHECK( run.lastDeadline == test_clock::time_point() + 1000 * PERIOD );
+}
+
+// after a short stall, the following frames don't wait until the lost time is made up
+BOOST_AUTO_TEST_CASE( catch_up )
+{
+	FrameRun run = runFrames(100, 10, 3 * PERIOD);
+	// the stalled frame ends 3 periods late, the next two frames are still late
+	BOOST_CHECK_EQUAL( run.lateFrames, 3 );
+	// afterwards, the frames are on the original schedule again
+	BOOST_CHECK( run.lastDeadline == test_clock::time_point() + 100 * PERIOD );
+	BOOST_CHECK( run.lastEnd == run.lastDeadline );
+}
+
+// a stall up to MAX_LAG_FRAMES periods is still caught up with
+BOOST_AUTO_TEST_CASE( catch_up_at_lag_cap )
+{
+	FrameRun run = runFrames(100, 10, SpeedController::MAX_LAG_FRAMES * PERIOD);
+	BOOST_CHECK_EQUAL( run.lateFrames, SpeedController::MAX_LAG_FRAMES );
+	BOOST_CHECK( run.lastDeadline == test_clock::time_point() + 100 * PERIOD );
+}
+
+// after a longer stall, the schedule starts anew instead of running a burst of frames
+BOOST_AUTO_TEST_CASE( lag_cap )
+{
+	const int STALL = 4 * SpeedController::MAX_LAG_FRAMES;
+	FrameRun run = runFrames(100, 10, STALL * PERIOD);
+	BOOST_CHECK_EQUAL( run.lateFrames, 1 );
+	// the frames after the stall are timed from its end, so the stalled time is lost
+	BOOST_CHECK( run.lastDeadline == test_clock::time_point() + (100 + STALL) * PERIOD );
+	BOOST_CHECK( run.lastEnd == run.lastDeadline );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,88 @@
+#define BOOST_TEST_MODULE Trace
+#include <boost/test/unit_test.hpp>
+
+#define BLOBBY_TRACE
+#include "Trace.h"
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace
+{
+	int count(const std::string& text, const std::string& pattern)
+	{
+		int result = 0;
+		for(std::size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1))
+			++result;
+		return result;
+	}
+
+	void work(int spans)
+	{
+		for(int i = 0; i < spans; ++i)
+		{
+			TRACE_SCOPE("work");
+		}
+	}
+}
+
+BOOST_AUTO_TEST_SUITE( trace )
+
+// only spans inside a recording are written
+BOOST_AUTO_TEST_CASE( recording )
+{
+	work(10);
+
+	TraceRecorder::start();
+	{
+		TRACE_SCOPE("outer");
+		work(5);
+	}
+	TraceRecorder::stop();
+
+	work(10);
+
+	std::ostringstream stream;
+	TraceRecorder::writeChromeTrace(stream);
+	std::string trace = stream.str();
+
+	BOOST_CHECK_EQUAL( count(trace, "\"name\":\"work\""), 5 );
+	BOOST_CHECK_EQUAL( count(trace, "\"name\":\"outer\""), 1 );
+	BOOST_CHECK_EQUAL( trace.find("{\"traceEvents\":["), 0u );
+}
+
+// each thread writes its own buffer and appears with its name
+BOOST_AUTO_TEST_CASE( threads )
+{
+	TraceRecorder::start();
+	std::thread worker([]()
+		{
+			TRACE_THREAD_NAME("worker");
+			work(100);
+		});
+	work(100);
+	worker.join();
+	TraceRecorder::stop();
+
+	std::ostringstream stream;
+	TraceRecorder::writeChromeTrace(stream);
+	std::string trace = stream.str();
+
+	BOOST_CHECK_EQUAL( count(trace, "\"name\":\"work\""), 200 );
+	BOOST_CHECK_EQUAL( count(trace, "\"args\":{\"name\":\"worker\"}"), 1 );
+}
+
+// when a buffer overflows, only the newest spans are kept
+BOOST_AUTO_TEST_CASE( overflow )
+{
+	TraceRecorder::start();
+	work(TraceRecorder::BUFFER_SIZE + 100);
+	TraceRecorder::stop();
+
+	std::ostringstream stream;
+	TraceRecorder::writeChromeTrace(stream);
+	BOOST_CHECK_EQUAL( count(stream.str(), "\"name\":\"work\""), (int)TraceRecorder::BUFFER_SIZE - 1 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()